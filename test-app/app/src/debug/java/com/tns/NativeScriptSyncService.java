@@ -130,6 +130,7 @@ public class NativeScriptSyncService {
                 input.readFully(new byte[length]); // ignore the payload
                 executePartialSync(context, syncDir);
                 executeRemovedSync(context, removedSyncDir);
+                com.tns.Runtime.invalidateResolvedModulePaths();
 
                 runtime.runScript(new File(NativeScriptSyncService.this.context.getFilesDir(), "internal/livesync.js"));
                 try {
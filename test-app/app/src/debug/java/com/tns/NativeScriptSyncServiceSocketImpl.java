@@ -155,6 +155,7 @@ public class NativeScriptSyncServiceSocketImpl {
                         String fileName = getFileName();
                         validateData();
                         deleteRecursive(new File(DEVICE_APP_DIR, fileName));
+                        com.tns.Runtime.invalidateResolvedModulePaths();
 
                     } else if (operation == CREATE_FILE_OPERATION) {
 
@@ -164,6 +165,7 @@ public class NativeScriptSyncServiceSocketImpl {
                         byte[] content = getFileContent(fileName, contentLength);
                         validateData();
                         createOrOverrideFile(fileName, content);
+                        com.tns.Runtime.invalidateResolvedModulePaths();
 
                     } else if (operation == DO_SYNC_OPERATION) {
                         byte[] operationUid = readNextBytes(OPERATION_ID_BYTE_SIZE);
@@ -48,6 +48,9 @@ require("./tests/extendedClassesTests");
 require("./tests/testJniReferenceLeak");
 require("./tests/testNativeModules");
 require("./tests/requireExceptionTests");
+require("./tests/testModuleResolution");
+require("./tests/testModuleCompilation");
+require("./tests/testFileAccess");
 require("./tests/java-array-test");
 require("./tests/field-access-test");
 require("./tests/byte-buffer-test");
@@ -56,6 +59,7 @@ require("./tests/testInterfaceImplementation");
 require("./tests/testRuntimeImplementedAPIs");
 require("./tests/testsInstanceOfOperator");
 require("./tests/testReleaseNativeCounterpart");
+require("./tests/testRuntimeStats");
 require("./tests/testJSONObjects");
 require("./tests/kotlin/companions/testCompanionObjectsSupport");
 require("./tests/kotlin/properties/testPropertiesSupport");
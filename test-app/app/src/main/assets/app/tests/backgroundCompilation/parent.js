@@ -0,0 +1,3 @@
+var child = require("./child");
+
+exports.childValue = child.value;
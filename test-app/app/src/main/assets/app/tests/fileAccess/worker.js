@@ -0,0 +1,10 @@
+self.onmessage = function (msg) {
+	var large = require(msg.data);
+	var small = require("./small");
+
+	self.postMessage({
+		count: large.items.length,
+		last: large.items[large.items.length - 1],
+		small: small.value
+	});
+};
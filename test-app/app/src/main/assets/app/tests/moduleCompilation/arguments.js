@@ -0,0 +1 @@
+var error = new Error("first line"); module.exports = { args: Array.prototype.slice.call(arguments), stack: error.stack };
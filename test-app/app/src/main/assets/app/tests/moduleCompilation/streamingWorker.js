@@ -0,0 +1,4 @@
+self.onmessage = function (msg) {
+	var parent = require(msg.data);
+	self.postMessage({ childValue: parent.childValue, stats: __runtimeStats() });
+};
@@ -0,0 +1,3 @@
+self.onmessage = function (msg) {
+	self.postMessage(require(msg.data));
+};
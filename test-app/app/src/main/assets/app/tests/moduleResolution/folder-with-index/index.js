@@ -0,0 +1 @@
+exports.name = "folder-with-index";
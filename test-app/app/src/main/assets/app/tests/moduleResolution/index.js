@@ -0,0 +1,5 @@
+exports.packageWithMain = require("package-with-main");
+exports.folderWithIndex = require("./folder-with-index");
+exports.folderWithPackage = require("./folder-with-package");
+exports.fileWithoutExtension = require("./file");
+exports.data = require("./data.json");
@@ -0,0 +1,61 @@
+describe("Tests file access", function () {
+
+	it("should read the same content from concurrent workers", function (done) {
+		var filesDir = new java.io.File(__dirname).getParentFile().getParentFile();
+		var largeFile = new java.io.File(filesDir, "fileAccess/large.json");
+		largeFile.getParentFile().mkdirs();
+
+		// larger than 64KB, so that it is mapped rather than read
+		var items = [];
+		for (var i = 0; i < 8000; i++) {
+			items.push("item-" + ("0000" + i).slice(-5));
+		}
+		var writer = new java.io.FileWriter(largeFile);
+		writer.write(JSON.stringify({ items: items }, null, "\t"));
+		writer.close();
+		expect(largeFile.length()).toBeGreaterThan(64 * 1024);
+
+		var large = require(largeFile.getAbsolutePath());
+		var small = require("./fileAccess/small");
+		var workersCount = 4;
+		var workers = [];
+		var responses = 0;
+
+		for (var i = 0; i < workersCount; i++) {
+			var worker = new Worker("./fileAccess/worker");
+			worker.onmessage = function (msg) {
+				expect(msg.data.count).toBe(large.items.length);
+				expect(msg.data.last).toBe(large.items[large.items.length - 1]);
+				expect(msg.data.small).toBe(small.value);
+
+				if (++responses === workersCount) {
+					workers.forEach(function (w) {
+						w.terminate();
+					});
+					done();
+				}
+			};
+			workers.push(worker);
+		}
+
+		workers.forEach(function (w) {
+			w.postMessage(largeFile.getAbsolutePath());
+		});
+	});
+
+	it("should read the metadata from the application package without extracting it", function () {
+		var filesDir = new java.io.File(__dirname).getParentFile().getParentFile();
+
+		expect(new java.io.File(filesDir, "metadata").exists()).toBe(false);
+
+		// a class, a nested class and their members which no other test resolves, so their metadata is read now
+		var set = new java.util.concurrent.ConcurrentSkipListSet();
+		set.add("b");
+		set.add("a");
+		var entry = new java.util.AbstractMap.SimpleImmutableEntry("key", "value");
+
+		expect(set.first()).toBe("a");
+		expect(entry.getValue()).toBe("value");
+		expect(java.util.concurrent.TimeUnit.MINUTES.toSeconds(2)).toBe(120);
+	});
+});
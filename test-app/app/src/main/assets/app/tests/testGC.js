@@ -1,5 +1,5 @@
-// Run GC tests only in Full marking mode
-let describeFunc = __markingMode == 0 ? describe : xdescribe;
+// Run GC tests only in Full and Tracing marking modes
+let describeFunc = (__markingMode == 0 || __markingMode == 2) ? describe : xdescribe;
 
 describeFunc("Tests garbage collection", function () {
 	var myCustomEquality = function(first, second) {
@@ -317,4 +317,75 @@ describeFunc("Tests garbage collection", function () {
 
 		test.postCallback();
 	});
-});
\ No newline at end of file
+
+	it("should keep objects reachable only through a Java held callback alive across GCs", function () {
+		var list = new java.util.ArrayList();
+
+		(function () {
+			var holder = {
+				list: list,
+				items: [new java.lang.StringBuilder("cross-heap")]
+			};
+
+			list.add(new java.util.concurrent.Callable({
+				call: function () {
+					return holder.items[0].toString();
+				}
+			}));
+		})();
+
+		for (var i = 0; i < 3; i++) {
+			gc();
+			java.lang.System.gc();
+		}
+
+		expect(list.get(0).call()).toBe("cross-heap");
+	});
+});
+
+// Run the time-sliced marking tests only in the Full marking mode with a marking time slice
+let describeTimeSlicedFunc = (__markingMode == 0 && com.tns.Runtime.getCurrentRuntime().getMarkingTimeSlice() > 0) ? describe : xdescribe;
+
+describeTimeSlicedFunc("Tests time-sliced marking", function () {
+	it("should keep a wrapper moved out of a Java held callback while the marking is pending", function (done) {
+		var list = new java.util.ArrayList();
+
+		(function () {
+			var holder = {
+				wrapper: new java.lang.StringBuilder("moved"),
+				// walked before the wrapper, so that the marking does not reach it in the first slice
+				padding: []
+			};
+			for (var i = 0; i < 100000; i++) {
+				holder.padding.push({ index: i });
+			}
+
+			list.add(new java.util.concurrent.Callable({
+				call: function () {
+					global.movedWrapper = holder.wrapper;
+					holder.wrapper = null;
+					return null;
+				}
+			}));
+		})();
+
+		gc();
+
+		// the rest of the marking runs in the slices scheduled after this function returns
+		list.get(0).call();
+
+		var mainHandler = new android.os.Handler(android.os.Looper.getMainLooper());
+		mainHandler.postDelayed(new java.lang.Runnable({
+			run: function () {
+				for (var i = 0; i < 3; i++) {
+					java.lang.System.gc();
+					java.lang.Runtime.getRuntime().runFinalization();
+				}
+
+				expect(global.movedWrapper.toString()).toBe("moved");
+				delete global.movedWrapper;
+				done();
+			}
+		}), 1000);
+	});
+});
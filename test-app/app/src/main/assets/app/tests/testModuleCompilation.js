@@ -0,0 +1,101 @@
+describe("Tests module compilation", function () {
+
+	it("should pass exports, require, module, __filename and __dirname to the module", function () {
+		var fixture = require("./moduleCompilation/arguments");
+
+		expect(fixture.args.length).toBe(5);
+		expect(typeof fixture.args[0]).toBe("object");
+		expect(typeof fixture.args[1]).toBe("function");
+		expect(fixture.args[2].exports).toBe(fixture);
+		expect(fixture.args[3]).toMatch(/moduleCompilation\/arguments\.js$/);
+		expect(fixture.args[4]).toMatch(/moduleCompilation$/);
+	});
+
+	it("should report the columns of the first line as they are in the file", function () {
+		var fixture = require("./moduleCompilation/arguments");
+
+		expect(fixture.stack).toContain("arguments.js:1:13");
+	});
+
+	it("should decode the modules which are not ASCII", function () {
+		var text = require("./moduleCompilation/non-ascii");
+
+		expect(text.length).toBe(13);
+		expect(text.charCodeAt(1)).toBe(0xE9);
+		expect(text.charCodeAt(12)).toBe(0x2713);
+	});
+
+	it("should consume the code cache of a module compiled in the background", function (done) {
+		var filesDir = new java.io.File(__dirname).getParentFile().getParentFile();
+		var streamedDir = new java.io.File(filesDir, "moduleCompilation/streamed");
+		streamedDir.mkdirs();
+
+		// new content, so that neither module has a cache yet
+		var token = Date.now();
+		var writeModule = function (name, content) {
+			var writer = new java.io.FileWriter(new java.io.File(streamedDir, name));
+			writer.write(content);
+			writer.close();
+		};
+		writeModule("child.js", "exports.value = " + token + ";");
+		writeModule("parent.js", "var child = require(\"./child\");\nexports.childValue = child.value; // " + token);
+
+		var requireInWorker = function (callback) {
+			var worker = new Worker("./moduleCompilation/streamingWorker");
+			worker.onmessage = function (msg) {
+				worker.terminate();
+				callback(msg.data);
+			};
+			worker.postMessage(new java.io.File(streamedDir, "parent.js").getAbsolutePath());
+		};
+
+		// the child is streamed by the first worker and compiled from its script cache by the second one
+		requireInWorker(function (first) {
+			expect(first.childValue).toBe(token);
+			expect(first.stats.backgroundCompilations).toBe(1);
+
+			requireInWorker(function (second) {
+				expect(second.childValue).toBe(token);
+				expect(second.stats.backgroundCompilations).toBe(0);
+				expect(second.stats.codeCacheHits).toBeGreaterThan(1);
+				expect(second.stats.codeCacheRejected).toBe(0);
+				done();
+			});
+		});
+	});
+
+	it("should not reuse the code cache of a module whose content changed", function (done) {
+		var filesDir = new java.io.File(__dirname).getParentFile().getParentFile();
+		var moduleFile = new java.io.File(filesDir, "moduleCompilation/changed.js");
+		moduleFile.getParentFile().mkdirs();
+
+		// the same size and modification time, as after an update of the application
+		var writeModule = function (value) {
+			var writer = new java.io.FileWriter(moduleFile);
+			writer.write("module.exports = \"" + value + "\";");
+			writer.close();
+			moduleFile.setLastModified(1500000000000);
+		};
+
+		// each worker has a module cache of its own, but shares the code cache
+		var requireInWorker = function (callback) {
+			var worker = new Worker("./moduleCompilation/worker");
+			worker.onmessage = function (msg) {
+				worker.terminate();
+				callback(msg.data);
+			};
+			worker.postMessage(moduleFile.getAbsolutePath());
+		};
+
+		writeModule("first");
+		requireInWorker(function (first) {
+			expect(first).toBe("first");
+
+			writeModule("other");
+			requireInWorker(function (other) {
+				expect(other).toBe("other");
+				done();
+			});
+		});
+	});
+});
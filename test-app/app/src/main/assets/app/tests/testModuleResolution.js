@@ -0,0 +1,34 @@
+describe("Tests module resolution", function () {
+
+	it("should resolve the files, folders and packages", function () {
+		var fixture = require("./moduleResolution");
+
+		expect(fixture.packageWithMain.name).toBe("package-with-main");
+		expect(fixture.folderWithIndex.name).toBe("folder-with-index");
+		expect(fixture.folderWithPackage.name).toBe("folder-with-package");
+		expect(fixture.fileWithoutExtension.name).toBe("file");
+		expect(fixture.data.name).toBe("data");
+	});
+
+	it("should return the same module for the different paths to it", function () {
+		var byFolder = require("./moduleResolution/folder-with-index");
+		var byFile = require("./moduleResolution/folder-with-index/index.js");
+		var byParentFolder = require("../tests/moduleResolution/folder-with-index/index");
+
+		expect(byFile).toBe(byFolder);
+		expect(byParentFolder).toBe(byFolder);
+	});
+
+	it("should throw each time a missing module is required", function () {
+		for (var i = 0; i < 2; i++) {
+			var message;
+			try {
+				require("./moduleResolution/missing");
+			} catch (e) {
+				message = e.toString();
+			}
+
+			expect(message).toContain("Failed to find module: \"./moduleResolution/missing\"");
+		}
+	});
+});
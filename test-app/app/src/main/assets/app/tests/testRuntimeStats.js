@@ -0,0 +1,128 @@
+describe("Test runtime stats", function () {
+
+	it("should expose the runtime counters and histograms", function () {
+		var stats = global.__runtimeStats();
+
+		expect(typeof stats.gcCycles).toBe("number");
+		expect(typeof stats.linkedObjects).toBe("number");
+		expect(stats.histograms.gcFinished.buckets.length).toBeGreaterThan(0);
+		expect(typeof stats.histograms.markReachableObjects.totalMicroseconds).toBe("number");
+	});
+
+	it("should count the calls to Java methods", function () {
+		var before = global.__runtimeStats().javaMethodCalls;
+
+		var sb = new java.lang.StringBuilder();
+		sb.append("a");
+		sb.append("b");
+
+		var after = global.__runtimeStats().javaMethodCalls;
+
+		expect(after - before).toBeGreaterThan(1);
+	});
+
+	it("should count the linked objects and reuse their records", function () {
+		var before = global.__runtimeStats();
+
+		var list = new java.util.ArrayList();
+		for (var i = 0; i < 1000; i++) {
+			list.add(new java.lang.Object());
+		}
+		for (var i = 0; i < 1000; i++) {
+			list.get(i);
+		}
+
+		var after = global.__runtimeStats();
+
+		expect(after.objectsLinked - before.objectsLinked).toBeGreaterThan(999);
+		expect(after.wrapperSlabs).toBeGreaterThan(0);
+		expect(after.objectsLinked - after.objectsUnlinked).not.toBeLessThan(after.linkedObjects);
+	});
+
+	it("should expose the code cache counters", function () {
+		var stats = global.__runtimeStats();
+
+		expect(typeof stats.codeCacheHits).toBe("number");
+		expect(typeof stats.codeCacheMisses).toBe("number");
+	});
+
+	it("should compile the required modules in the background", function () {
+		var before = global.__runtimeStats().backgroundCompilations;
+
+		var parent = require("./backgroundCompilation/parent");
+
+		var after = global.__runtimeStats().backgroundCompilations;
+
+		expect(parent.childValue).toBe(42);
+		expect(after - before).toBe(1);
+	});
+
+	it("should survive cross-heap garbage allocated past the heap limit in a sync loop", function () {
+		var before = global.__runtimeStats();
+		var nearHeapLimitEvents = before.nearHeapLimitEvents;
+
+		// every round leaves about 1MB reachable only through a Java held callback, which
+		// only the coordinated JS and Java collection can release, and never yields to the looper
+		for (var round = 0; round < 4096 && nearHeapLimitEvents == before.nearHeapLimitEvents; round++) {
+			var list = new java.util.ArrayList();
+			(function (payload) {
+				list.add(new java.lang.Runnable({
+					run: function () {
+						payload[0]++;
+					}
+				}));
+			})(new Array(256 * 1024).fill(round));
+
+			nearHeapLimitEvents = global.__runtimeStats().nearHeapLimitEvents;
+		}
+
+		// the collection runs as an interrupt, at the next safe point of the JS thread
+		for (var i = 0; i < 1000 && global.__runtimeStats().heapReclaims == before.heapReclaims; i++) {
+		}
+
+		var after = global.__runtimeStats();
+		expect(after.nearHeapLimitEvents).toBeGreaterThan(before.nearHeapLimitEvents);
+		expect(after.heapReclaims).toBeGreaterThan(before.heapReclaims);
+	});
+
+	it("should count the GC cycles", function () {
+		var before = global.__runtimeStats().gcCycles;
+
+		gc();
+
+		var after = global.__runtimeStats();
+
+		if (__markingMode != 1) {
+			expect(after.gcCycles).toBeGreaterThan(before);
+			expect(after.histograms.gcFinished.count).toBeGreaterThan(0);
+		}
+	});
+
+	it("should trace the Java held callback objects instead of walking them", function () {
+		var list = new java.util.ArrayList();
+
+		(function () {
+			var items = [new java.lang.StringBuilder("traced")];
+			list.add(new java.util.concurrent.Callable({
+				call: function () {
+					return items[0].toString();
+				}
+			}));
+		})();
+
+		var before = global.__runtimeStats();
+
+		for (var i = 0; i < 3; i++) {
+			gc();
+			java.lang.System.gc();
+		}
+
+		var after = global.__runtimeStats();
+
+		if (__markingMode == 2) {
+			expect(after.markReachableObjectsRuns).toBe(before.markReachableObjectsRuns);
+			expect(after.histograms.tracePrologue.count).toBeGreaterThan(before.histograms.tracePrologue.count);
+		}
+		expect(list.get(0).call()).toBe("traced");
+	});
+});
@@ -1,13 +1,17 @@
 package com.tns;
 
+import android.app.Activity;
 import android.app.Application;
 import android.content.BroadcastReceiver;
+import android.content.ComponentCallbacks2;
 import android.content.Context;
 import android.content.Intent;
 import android.content.IntentFilter;
 import android.content.SharedPreferences;
 import android.content.pm.PackageManager.NameNotFoundException;
+import android.content.res.Configuration;
 import android.os.Build;
+import android.os.Bundle;
 import android.preference.PreferenceManager;
 import android.util.Log;
 
@@ -94,6 +98,19 @@ public final class RuntimeHelper {
                 } catch (IOException e1) {
                 }
 
+                AssetExtractor aE = new AssetExtractor(null, logger);
+                String outputDir = context.getFilesDir().getPath() + File.separator;
+
+                // the metadata is only read natively, so it is read from the APK in place, also when
+                // a plugin, e.g. LiveSync, takes care of the rest of the assets
+                boolean isMetadataMounted;
+                ManualInstrumentation.Frame mountFrame = ManualInstrumentation.start("Mounting metadata");
+                try {
+                    isMetadataMounted = aE.mountAssets(context, "metadata", outputDir);
+                } finally {
+                    mountFrame.close();
+                }
+
                 if (!skipAssetExtraction) {
                     ManualInstrumentation.Frame extractionFrame = ManualInstrumentation.start("Extracting assets");
                     try {
@@ -101,16 +118,15 @@ public final class RuntimeHelper {
                             logger.write("Extracting assets...");
                         }
 
-                        AssetExtractor aE = new AssetExtractor(null, logger);
-
-                        String outputDir = context.getFilesDir().getPath() + File.separator;
-
                         // will force deletion of previously extracted files in app/files directories
                         // see https://github.com/NativeScript/NativeScript/issues/4137 for reference
                         boolean removePreviouslyInstalledAssets = true;
                         aE.extractAssets(context, "app", outputDir, extractPolicy, removePreviouslyInstalledAssets);
                         aE.extractAssets(context, "internal", outputDir, extractPolicy, removePreviouslyInstalledAssets);
-                        aE.extractAssets(context, "metadata", outputDir, extractPolicy, false);
+
+                        if (!isMetadataMounted) {
+                            aE.extractAssets(context, "metadata", outputDir, extractPolicy, false);
+                        }
 
                         boolean shouldExtractSnapshots = true;
 
@@ -132,7 +148,8 @@ public final class RuntimeHelper {
                 }
 
                 AppConfig appConfig = new AppConfig(appDir);
-                ManualInstrumentation.setMode(appConfig.getProfilingMode());
+                // "profiling": "trace" writes the timeline of the startup to files/trace.json
+                ManualInstrumentation.setMode(appConfig.getProfilingMode(), new File(appDir, "trace.json"));
 
                 ClassLoader classLoader = context.getClassLoader();
                 File dexDir = new File(rootDir, "code_cache/secondary-dexes");
@@ -231,6 +248,9 @@ public final class RuntimeHelper {
                     // so that subsequent calls to "new Date()" return the new timezone
                     registerTimezoneChangedListener(context, runtime);
                 }
+
+                registerMemoryPressureListener(context);
+                registerLifecycleListener(context);
             }
             return runtime;
         } finally {
@@ -299,6 +319,78 @@ public final class RuntimeHelper {
         context.registerReceiver(timezoneReceiver, timezoneFilter);
     }
 
+    private static void registerMemoryPressureListener(Context context) {
+        context.registerComponentCallbacks(new ComponentCallbacks2() {
+            @Override
+            public void onTrimMemory(int level) {
+                Runtime.notifyMemoryPressure(level);
+            }
+
+            @Override
+            public void onLowMemory() {
+                Runtime.notifyMemoryPressure(ComponentCallbacks2.TRIM_MEMORY_COMPLETE);
+            }
+
+            @Override
+            public void onConfigurationChanged(Configuration newConfig) {
+            }
+        });
+    }
+
+    /**
+     * The application is in the background while none of its activities is started. An activity stopped
+     * for a configuration change is started again right away, so it does not count.
+     */
+    private static void registerLifecycleListener(Context context) {
+        Context appContext = context.getApplicationContext();
+        if (!(appContext instanceof Application)) {
+            return;
+        }
+
+        ((Application) appContext).registerActivityLifecycleCallbacks(new Application.ActivityLifecycleCallbacks() {
+            private int startedActivities;
+
+            @Override
+            public void onActivityStarted(Activity activity) {
+                if (startedActivities++ == 0) {
+                    Runtime.notifyInBackground(false);
+                }
+            }
+
+            @Override
+            public void onActivityStopped(Activity activity) {
+                if (startedActivities == 0) {
+                    // started before the runtime was initialized
+                    return;
+                }
+
+                if (--startedActivities == 0 && !activity.isChangingConfigurations()) {
+                    Runtime.notifyInBackground(true);
+                }
+            }
+
+            @Override
+            public void onActivityCreated(Activity activity, Bundle savedInstanceState) {
+            }
+
+            @Override
+            public void onActivityResumed(Activity activity) {
+            }
+
+            @Override
+            public void onActivityPaused(Activity activity) {
+            }
+
+            @Override
+            public void onActivitySaveInstanceState(Activity activity, Bundle outState) {
+            }
+
+            @Override
+            public void onActivityDestroyed(Activity activity) {
+            }
+        });
+    }
+
     public static void initLiveSync(Application app) {
         Runtime currentRuntime = Runtime.getCurrentRuntime();
         if (!currentRuntime.getIsLiveSyncStarted()) {
@@ -8,7 +8,10 @@ import org.nativescript.staticbindinggenerator.generating.parsing.methods.Reifie
 import org.nativescript.staticbindinggenerator.generating.writing.MethodsWriter;
 import org.nativescript.staticbindinggenerator.naming.BcelNamingUtil;
 
+import java.util.Arrays;
+import java.util.HashSet;
 import java.util.List;
+import java.util.Set;
 
 public class MethodsWriterImpl implements MethodsWriter {
 
@@ -20,10 +23,13 @@ public class MethodsWriterImpl implements MethodsWriter {
     private static final String ON_CREATE_METHOD_NAME = "onCreate";
 
     private static final String GET_INSTANCE_METHOD_SIGNATURE_PATTERN = "public static %s getInstance()";
-    private static final String RUNTIME_CALL_JS_METHOD_CALL_PATTERN = "com.tns.Runtime.callJSMethod(this, \"%s\", %s.class, " + ARGS_VARIABLE_NAME + ")";
+    private static final String RUNTIME_CALL_JS_METHOD_CALL_PATTERN = "com.tns.Runtime.callJSMethod(this, %s, %s.class, " + ARGS_VARIABLE_NAME + ")";
     private static final String RUNTIME_CALL_JS_CONSTRUCTOR_METHOD_CALL_PATTERN = "com.tns.Runtime.callJSMethod(this, \"%s\", %s.class, true," + ARGS_VARIABLE_NAME + ")";
     private static final String RUNTIME_CALL_JS_METHOD_FROM_POSSIBLE_NON_MAIN_THREAD_CALL_PATTERN = "com.tns.Runtime.callJSMethodFromPossibleNonMainThread(this, \"%s\", %s.class, " + ARGS_VARIABLE_NAME + ")";
     private static final String RUNTIME_CALL_JS_CONSTRUCTOR_METHOD_FROM_POSSIBLE_NON_MAIN_THREAD_CALL_PATTERN = "com.tns.Runtime.callJSMethodFromPossibleNonMainThread(this, \"%s\", %s.class, true," + ARGS_VARIABLE_NAME + ")";
+    private static final String RUNTIME_CALL_JS_METHOD_UNBOXED_CALL_PATTERN = "com.tns.Runtime.callJSMethod%s(this, %s%s)";
+    private static final String METHOD_SLOT_FIELD_PREFIX = "__ns_slot_";
+    private static final String METHOD_SLOT_FIELD_PATTERN = "private static final int %s = com.tns.Runtime.getMethodSlot(\"%s\");";
     private static final String ARGS_VARIABLE_PATTERN = "java.lang.Object[] " + ARGS_VARIABLE_NAME + " = new java.lang.Object[%d];";
 
     private static final String THROWS_DECLARATION_BEGINNING = " throws ";
@@ -56,12 +62,23 @@ public class MethodsWriterImpl implements MethodsWriter {
     private static final String NULL_VALUE = "null";
     private static final char NEGATE_LITERAL = '!';
 
+    /**
+     * Method signature shapes (argument signatures + '_' + return signature) for which com.tns.Runtime
+     * exposes a typed callJSMethod entry point that does not box the arguments into an Object[].
+     * Keep in sync with the callJSMethod[shape] methods in java/com/tns/Runtime.
+     */
+    private static final Set<String> UNBOXED_CALL_SHAPES = new HashSet<>(Arrays.asList(
+            "_V", "I_V", "II_V", "IIII_V", "J_V", "F_V", "Z_V",
+            "F_F", "_Z", "_I", "I_I", "I_J"
+    ));
+
 
     private final Writer writer;
     private final boolean shouldSuppressCallJsMethodExceptions;
     private final boolean isForApplicationClass;
     private final boolean isForServiceClass;
     private final boolean isForAndroidWorkerClass;
+    private final Set<String> declaredMethodSlotFields = new HashSet<>();
 
 
     public MethodsWriterImpl(final Writer writer, boolean shouldSuppressCallJsMethodExceptions, boolean isForApplicationClass, boolean isForServiceClass, boolean isForAndroidWorkerClass) {
@@ -74,6 +91,10 @@ public class MethodsWriterImpl implements MethodsWriter {
 
     @Override
     public void writeMethod(ReifiedJavaMethod method, boolean isUserImplemented) {
+        if (usesMethodSlot(method)) {
+            writeMethodSlotFieldIfNecessary(method);
+        }
+
         writeMethodSignature(method, isUserImplemented);
         writer.write(OPENING_CURLY_BRACKET_LITERAL);
 
@@ -280,12 +301,20 @@ public class MethodsWriterImpl implements MethodsWriter {
 
     private void writeMethodBody(ReifiedJavaMethod method) {
         Type returnType = method.getReturnType();
+        String unboxedCallShape = getUnboxedCallShape(method);
 
-        writeArgumentsVariableForMethodCall(method);
-        writeCallJsMethodExceptionsSuppressBlockBeginningIfNecessary();
+        String runtimeCallJsMethodCall;
+        if (unboxedCallShape != null) {
+            writeCallJsMethodExceptionsSuppressBlockBeginningIfNecessary();
+            runtimeCallJsMethodCall = getUnboxedMethodCall(method, unboxedCallShape);
+        } else {
+            writeArgumentsVariableForMethodCall(method);
+            writeCallJsMethodExceptionsSuppressBlockBeginningIfNecessary();
 
-        String methodCallPattern = getMethodCallPattern(method);
-        String runtimeCallJsMethodCall = String.format(methodCallPattern, getMethodName(method), BcelNamingUtil.resolveBcelTypeName(returnType));
+            String methodCallPattern = getMethodCallPattern(method);
+            String methodReference = usesMethodSlot(method) ? getMethodSlotFieldName(method) : getMethodName(method);
+            runtimeCallJsMethodCall = String.format(methodCallPattern, methodReference, BcelNamingUtil.resolveBcelTypeName(returnType));
+        }
 
         if (!returnType.equals(Type.VOID)) {
             writeReturnStatementWithCast(method.getReifiedReturnType(), runtimeCallJsMethodCall);
@@ -297,6 +326,57 @@ public class MethodsWriterImpl implements MethodsWriter {
         writeCallJsMethodExceptionsSuppressBlockClosingIfNecessary(returnType, getMethodName(method));
     }
 
+    private String getUnboxedCallShape(ReifiedJavaMethod method) {
+        if (method.isConstructor() || isForAndroidWorkerClass) {
+            return null;
+        }
+
+        StringBuilder shape = new StringBuilder();
+        for (Type argType : method.getArgumentTypes()) {
+            shape.append(argType.getSignature());
+        }
+        shape.append('_');
+        shape.append(method.getReturnType().getSignature());
+
+        String result = shape.toString();
+        return UNBOXED_CALL_SHAPES.contains(result) ? result : null;
+    }
+
+    private String getUnboxedMethodCall(ReifiedJavaMethod method, String unboxedCallShape) {
+        StringBuilder args = new StringBuilder();
+        int paramCount = method.getArgumentTypes().length;
+        for (int i = 0; i < paramCount; i++) {
+            args.append(COMMA_LITERAL);
+            args.append(PARAMETER_PREFIX);
+            args.append(i);
+        }
+
+        return String.format(RUNTIME_CALL_JS_METHOD_UNBOXED_CALL_PATTERN, unboxedCallShape, getMethodSlotFieldName(method), args.toString());
+    }
+
+    /**
+     * The calls of the methods pass the slot handle of the JS method name, resolved once by a static
+     * field of the generated class, instead of the name. The constructors and the Android worker
+     * classes keep passing the names.
+     */
+    private boolean usesMethodSlot(ReifiedJavaMethod method) {
+        return !method.isConstructor() && !isForAndroidWorkerClass;
+    }
+
+    private String getMethodSlotFieldName(ReifiedJavaMethod method) {
+        return METHOD_SLOT_FIELD_PREFIX + method.getName();
+    }
+
+    private void writeMethodSlotFieldIfNecessary(ReifiedJavaMethod method) {
+        String fieldName = getMethodSlotFieldName(method);
+
+        // the overloads share the slot of their name
+        if (declaredMethodSlotFields.add(fieldName)) {
+            writer.write(String.format(METHOD_SLOT_FIELD_PATTERN, fieldName, method.getName()));
+            writer.writeln();
+        }
+    }
+
     private String getMethodCallPattern(ReifiedJavaMethod method) {
         if (method.isConstructor()) {
             if (!isForAndroidWorkerClass) {
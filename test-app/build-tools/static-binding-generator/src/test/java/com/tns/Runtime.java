@@ -2,7 +2,35 @@ package com.tns;
 
 public class Runtime {
     public static void initInstance(Object instance) {}
+    public static int getMethodSlot(String methodName) {
+        return 0;
+    }
     public static Object callJSMethod(Object javaObject, String methodName, Class<?> retType, Object... args) {
         return null;
     }
+    public static Object callJSMethod(Object javaObject, int methodSlot, Class<?> retType, Object... args) {
+        return null;
+    }
+    public static void callJSMethod_V(Object javaObject, int methodSlot) {}
+    public static void callJSMethodI_V(Object javaObject, int methodSlot, int arg0) {}
+    public static void callJSMethodII_V(Object javaObject, int methodSlot, int arg0, int arg1) {}
+    public static void callJSMethodIIII_V(Object javaObject, int methodSlot, int arg0, int arg1, int arg2, int arg3) {}
+    public static void callJSMethodJ_V(Object javaObject, int methodSlot, long arg0) {}
+    public static void callJSMethodF_V(Object javaObject, int methodSlot, float arg0) {}
+    public static void callJSMethodZ_V(Object javaObject, int methodSlot, boolean arg0) {}
+    public static float callJSMethodF_F(Object javaObject, int methodSlot, float arg0) {
+        return 0f;
+    }
+    public static boolean callJSMethod_Z(Object javaObject, int methodSlot) {
+        return false;
+    }
+    public static int callJSMethod_I(Object javaObject, int methodSlot) {
+        return 0;
+    }
+    public static int callJSMethodI_I(Object javaObject, int methodSlot, int arg0) {
+        return 0;
+    }
+    public static long callJSMethodI_J(Object javaObject, int methodSlot, int arg0) {
+        return 0L;
+    }
 }
@@ -163,4 +163,25 @@ public class GeneratorTest {
         // class compiles, meaning abstract method of super-super class is extended properly
         Assert.assertNotNull(ComplexClass);
     }
+
+    @Test
+    public void testPrimitiveCallbackUsesUnboxedRuntimeEntryPoint() throws Exception {
+        String dataRowString = "java.lang.Object*app*1*1**run*com.example.MyRunnable**java.lang.Runnable";
+        DataRow dataRow = new DataRow(dataRowString);
+
+        File outputDir = null;
+        List<DataRow> libs = new ArrayList<>();
+        libs.add(new DataRow(runtimePath));
+        Generator generator = new Generator(outputDir, libs);
+        Binding binding = generator.generateBinding(dataRow);
+
+        String sourceCode = binding.getContent();
+        Assert.assertTrue(sourceCode.contains("private static final int __ns_slot_run = com.tns.Runtime.getMethodSlot(\"run\");"));
+        Assert.assertTrue(sourceCode.contains("com.tns.Runtime.callJSMethod_V(this, __ns_slot_run)"));
+
+        Iterable<String> options = new ArrayList<String>(Arrays.asList("-cp", dependenciesDir));
+        Class<?> runnableClass = InMemoryJavaCompiler.compile(binding.getClassname(), sourceCode, options);
+
+        Assert.assertNotNull(runnableClass);
+    }
 }
@@ -0,0 +1,565 @@
+#include "ApkFileSystem.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+using namespace std;
+using namespace tns;
+
+namespace {
+const uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+const uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+const uint32_t END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06054b50;
+const uint32_t ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE = 0x06064b50;
+const uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+const uint16_t ZIP64_EXTRA_FIELD_ID = 0x0001;
+
+const size_t LOCAL_HEADER_SIZE = 30;
+const size_t CENTRAL_HEADER_SIZE = 46;
+const size_t END_OF_CENTRAL_DIRECTORY_SIZE = 22;
+const size_t ZIP64_LOCATOR_SIZE = 20;
+const size_t ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE = 56;
+const size_t MAX_COMMENT_SIZE = 0xFFFF;
+
+const string ASSETS_DIR = "assets";
+
+uint16_t ReadUInt16(const uint8_t* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t ReadUInt32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint64_t ReadUInt64(const uint8_t* p) {
+    return static_cast<uint64_t>(ReadUInt32(p)) | (static_cast<uint64_t>(ReadUInt32(p + 4)) << 32);
+}
+}
+
+bool ApkFileSystem::Open(const string& apkPath) {
+    lock_guard<mutex> lock(s_mutex);
+
+    if (s_fd != -1) {
+        return true;
+    }
+
+    int fd = open(apkPath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !ReadCentralDirectory(fd, static_cast<uint64_t>(st.st_size))) {
+        s_entries.clear();
+        s_directories.clear();
+        close(fd);
+        return false;
+    }
+
+    s_fd = fd;
+    s_fileSize = static_cast<uint64_t>(st.st_size);
+
+    return true;
+}
+
+bool ApkFileSystem::Mount(const string& assetsDir, const string& mountPath) {
+    lock_guard<mutex> lock(s_mutex);
+
+    if (s_fd == -1) {
+        return false;
+    }
+
+    auto dir = ASSETS_DIR + "/" + NormalizePath("/" + assetsDir).substr(1);
+    while (!dir.empty() && dir.back() == '/') {
+        dir.pop_back();
+    }
+
+    if (s_directories.find(dir) == s_directories.end()) {
+        return false;
+    }
+
+    // the files are looked up by their canonical paths, the mount path itself may not exist
+    auto path = NormalizePath(mountPath);
+    auto separator = path.find_last_of('/');
+    if (separator != string::npos && separator > 0) {
+        char canonicalPath[PATH_MAX];
+        if (realpath(path.substr(0, separator).c_str(), canonicalPath) != nullptr) {
+            path = string(canonicalPath) + path.substr(separator);
+        }
+    }
+
+    s_mounts.emplace_back(path, dir);
+
+    return true;
+}
+
+bool ApkFileSystem::IsMounted(const string& path) {
+    string name;
+    return ToEntryName(path, name);
+}
+
+bool ApkFileSystem::GetEntryKind(const string& path, bool& isDirectory) {
+    string name;
+    if (!ToEntryName(path, name)) {
+        return false;
+    }
+
+    if (s_entries.find(name) != s_entries.end()) {
+        isDirectory = false;
+        return true;
+    }
+
+    if (s_directories.find(name) != s_directories.end()) {
+        isDirectory = true;
+        return true;
+    }
+
+    return false;
+}
+
+bool ApkFileSystem::ListDirectory(const string& path, vector<pair<string, bool>>& entries) {
+    string name;
+    if (!ToEntryName(path, name)) {
+        return false;
+    }
+
+    auto it = s_directories.find(name);
+    if (it == s_directories.end()) {
+        return false;
+    }
+
+    entries.assign(it->second.begin(), it->second.end());
+
+    return true;
+}
+
+bool ApkFileSystem::FindFile(const string& path, Entry& entry) {
+    string name;
+    if (!ToEntryName(path, name)) {
+        return false;
+    }
+
+    auto it = s_entries.find(name);
+    if (it == s_entries.end()) {
+        return false;
+    }
+
+    entry = it->second;
+
+    return true;
+}
+
+bool ApkFileSystem::MapEntry(const Entry& entry, MemoryMappedFile& mapping, const char*& data, FileAccess access) {
+    uint64_t dataOffset;
+    if (entry.method != METHOD_STORED || entry.size == 0 || !GetDataOffset(entry, dataOffset)) {
+        return false;
+    }
+
+    static const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+
+    // the entries are aligned to 4 bytes by zipalign, so the mapping starts at the page holding the entry
+    auto mappingOffset = dataOffset - (dataOffset % pageSize);
+    auto delta = static_cast<size_t>(dataOffset - mappingOffset);
+    auto length = delta + static_cast<size_t>(entry.size);
+
+    void* memory = mmap(nullptr, length, PROT_READ, MAP_SHARED, s_fd, static_cast<off_t>(mappingOffset));
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+
+    mapping = MemoryMappedFile(memory, length);
+    mapping.Advise(delta, static_cast<size_t>(entry.size), access);
+    data = static_cast<const char*>(memory) + delta;
+
+    return true;
+}
+
+bool ApkFileSystem::ReadEntry(const Entry& entry, char* data) {
+    if (entry.size == 0) {
+        return true;
+    }
+
+    uint64_t dataOffset;
+    if (!GetDataOffset(entry, dataOffset)) {
+        return false;
+    }
+
+    switch (entry.method) {
+        case METHOD_STORED:
+            return File::ReadAt(s_fd, data, static_cast<size_t>(entry.size), dataOffset);
+        case METHOD_DEFLATED:
+            return Inflate(entry, dataOffset, data);
+        default:
+            return false;
+    }
+}
+
+bool ApkFileSystem::ListFiles(const string& assetsDir, vector<pair<string, Entry>>& files) {
+    auto dir = ASSETS_DIR + NormalizePath("/" + assetsDir);
+    if (s_directories.find(dir) == s_directories.end()) {
+        return false;
+    }
+
+    auto prefix = dir + "/";
+    for (const auto& entry : s_entries) {
+        if (entry.first.compare(0, prefix.size(), prefix) == 0) {
+            files.emplace_back(entry.first.substr(ASSETS_DIR.size() + 1), entry.second);
+        }
+    }
+
+    return true;
+}
+
+bool ApkFileSystem::CopyEntry(const Entry& entry, int fd) {
+    uint64_t dataOffset = 0;
+    if (entry.size > 0 && !GetDataOffset(entry, dataOffset)) {
+        return false;
+    }
+
+    const size_t CHUNK_SIZE = 64 * 1024;
+    vector<uint8_t> input(CHUNK_SIZE);
+    vector<uint8_t> output(CHUNK_SIZE);
+    uLong crc = crc32(0, Z_NULL, 0);
+    uint64_t written = 0;
+    auto remaining = (entry.size > 0) ? entry.compressedSize : 0;
+    auto offset = dataOffset;
+
+    if (entry.method == METHOD_STORED) {
+        while (remaining > 0) {
+            auto length = static_cast<size_t>(min<uint64_t>(remaining, CHUNK_SIZE));
+            if (!File::ReadAt(s_fd, input.data(), length, offset) || !File::WriteAt(fd, input.data(), length, written)) {
+                return false;
+            }
+            crc = crc32(crc, input.data(), static_cast<uInt>(length));
+            remaining -= length;
+            offset += length;
+            written += length;
+        }
+    } else if (entry.method == METHOD_DEFLATED) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            return false;
+        }
+
+        int result = Z_OK;
+        while (result == Z_OK && remaining > 0) {
+            auto length = static_cast<size_t>(min<uint64_t>(remaining, CHUNK_SIZE));
+            if (!File::ReadAt(s_fd, input.data(), length, offset)) {
+                break;
+            }
+            remaining -= length;
+            offset += length;
+
+            stream.next_in = input.data();
+            stream.avail_in = static_cast<uInt>(length);
+            do {
+                stream.next_out = output.data();
+                stream.avail_out = static_cast<uInt>(output.size());
+                result = inflate(&stream, Z_NO_FLUSH);
+
+                auto produced = output.size() - stream.avail_out;
+                if (produced > 0) {
+                    if (!File::WriteAt(fd, output.data(), produced, written)) {
+                        result = Z_ERRNO;
+                        break;
+                    }
+                    crc = crc32(crc, output.data(), static_cast<uInt>(produced));
+                    written += produced;
+                }
+
+                if (result == Z_BUF_ERROR && stream.avail_in == 0) {
+                    // the output is flushed and the next chunk of the input is needed
+                    result = Z_OK;
+                    break;
+                }
+            } while (result == Z_OK && (stream.avail_in > 0 || stream.avail_out == 0));
+        }
+
+        inflateEnd(&stream);
+        if (result != Z_STREAM_END && !(result == Z_OK && entry.size == 0)) {
+            return false;
+        }
+    } else {
+        return false;
+    }
+
+    return written == entry.size && crc == entry.crc;
+}
+
+time_t ApkFileSystem::GetModificationTime(const Entry& entry) {
+    // the same conversion as libzip, the MS-DOS times are local
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_isdst = -1;
+    tm.tm_year = static_cast<int>((entry.modificationTime >> 25) & 0x7F) + 80;
+    tm.tm_mon = static_cast<int>((entry.modificationTime >> 21) & 0x0F) - 1;
+    tm.tm_mday = static_cast<int>((entry.modificationTime >> 16) & 0x1F);
+    tm.tm_hour = static_cast<int>((entry.modificationTime >> 11) & 0x1F);
+    tm.tm_min = static_cast<int>((entry.modificationTime >> 5) & 0x3F);
+    tm.tm_sec = static_cast<int>((entry.modificationTime << 1) & 0x3E);
+
+    return mktime(&tm);
+}
+
+string ApkFileSystem::NormalizePath(const string& path) {
+    vector<string> segments;
+
+    size_t start = 0;
+    while (start <= path.size()) {
+        auto end = path.find('/', start);
+        if (end == string::npos) {
+            end = path.size();
+        }
+
+        auto segment = path.substr(start, end - start);
+        if (segment == "..") {
+            if (!segments.empty()) {
+                segments.pop_back();
+            }
+        } else if (!segment.empty() && segment != ".") {
+            segments.push_back(move(segment));
+        }
+
+        start = end + 1;
+    }
+
+    string normalized;
+    for (const auto& segment : segments) {
+        normalized += "/";
+        normalized += segment;
+    }
+
+    return normalized.empty() ? "/" : normalized;
+}
+
+bool ApkFileSystem::ReadCentralDirectory(int fd, uint64_t fileSize) {
+    if (fileSize < END_OF_CENTRAL_DIRECTORY_SIZE) {
+        return false;
+    }
+
+    // the end of central directory record is followed by a comment of up to 64KB
+    auto tailSize = static_cast<size_t>(min<uint64_t>(fileSize, END_OF_CENTRAL_DIRECTORY_SIZE + MAX_COMMENT_SIZE));
+    auto tailOffset = fileSize - tailSize;
+    vector<uint8_t> tail(tailSize);
+    if (!File::ReadAt(fd, tail.data(), tailSize, tailOffset)) {
+        return false;
+    }
+
+    const uint8_t* end = nullptr;
+    for (auto i = tailSize - END_OF_CENTRAL_DIRECTORY_SIZE + 1; i-- > 0;) {
+        if (ReadUInt32(&tail[i]) == END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+            end = &tail[i];
+            break;
+        }
+    }
+
+    if (end == nullptr) {
+        return false;
+    }
+
+    uint64_t entriesCount = ReadUInt16(end + 10);
+    uint64_t directorySize = ReadUInt32(end + 12);
+    uint64_t directoryOffset = ReadUInt32(end + 16);
+
+    auto endOffset = tailOffset + static_cast<uint64_t>(end - tail.data());
+    if (endOffset >= ZIP64_LOCATOR_SIZE) {
+        uint8_t locator[ZIP64_LOCATOR_SIZE];
+        if (File::ReadAt(fd, locator, sizeof(locator), endOffset - ZIP64_LOCATOR_SIZE) && ReadUInt32(locator) == ZIP64_LOCATOR_SIGNATURE) {
+            uint8_t end64[ZIP64_END_OF_CENTRAL_DIRECTORY_SIZE];
+            if (!File::ReadAt(fd, end64, sizeof(end64), ReadUInt64(locator + 8)) || ReadUInt32(end64) != ZIP64_END_OF_CENTRAL_DIRECTORY_SIGNATURE) {
+                return false;
+            }
+            entriesCount = ReadUInt64(end64 + 32);
+            directorySize = ReadUInt64(end64 + 40);
+            directoryOffset = ReadUInt64(end64 + 48);
+        }
+    }
+
+    if (directoryOffset > fileSize || directorySize > fileSize - directoryOffset) {
+        return false;
+    }
+
+    vector<uint8_t> directory(static_cast<size_t>(directorySize));
+    if (!File::ReadAt(fd, directory.data(), directory.size(), directoryOffset)) {
+        return false;
+    }
+
+    const auto assetsPrefix = ASSETS_DIR + "/";
+    size_t pos = 0;
+    for (uint64_t i = 0; i < entriesCount; i++) {
+        if (pos + CENTRAL_HEADER_SIZE > directory.size()) {
+            return false;
+        }
+
+        const uint8_t* header = &directory[pos];
+        if (ReadUInt32(header) != CENTRAL_HEADER_SIGNATURE) {
+            return false;
+        }
+
+        auto nameLength = ReadUInt16(header + 28);
+        auto extraLength = ReadUInt16(header + 30);
+        auto commentLength = ReadUInt16(header + 32);
+        auto next = pos + CENTRAL_HEADER_SIZE + nameLength + extraLength + commentLength;
+        if (next > directory.size()) {
+            return false;
+        }
+
+        string name(reinterpret_cast<const char*>(header + CENTRAL_HEADER_SIZE), nameLength);
+        if (name.compare(0, assetsPrefix.size(), assetsPrefix) == 0) {
+            Entry entry;
+            entry.method = ReadUInt16(header + 10);
+            entry.modificationTime = ReadUInt32(header + 12);
+            entry.crc = ReadUInt32(header + 16);
+            entry.compressedSize = ReadUInt32(header + 20);
+            entry.size = ReadUInt32(header + 24);
+            entry.localHeaderOffset = ReadUInt32(header + 42);
+
+            // the values which do not fit in 32 bits are in the zip64 extra field, in this order
+            const uint8_t* extra = header + CENTRAL_HEADER_SIZE + nameLength;
+            const uint8_t* extraEnd = extra + extraLength;
+            while (extra + 4 <= extraEnd) {
+                auto id = ReadUInt16(extra);
+                auto size = ReadUInt16(extra + 2);
+                const uint8_t* value = extra + 4;
+                const uint8_t* valueEnd = min(value + size, extraEnd);
+                if (id == ZIP64_EXTRA_FIELD_ID) {
+                    for (uint64_t* field : { &entry.size, &entry.compressedSize, &entry.localHeaderOffset }) {
+                        if (*field == 0xFFFFFFFF && value + 8 <= valueEnd) {
+                            *field = ReadUInt64(value);
+                            value += 8;
+                        }
+                    }
+                }
+                extra += 4 + size;
+            }
+
+            AddEntry(name, entry);
+        }
+
+        pos = next;
+    }
+
+    return true;
+}
+
+void ApkFileSystem::AddEntry(const string& name, const Entry& entry) {
+    auto path = name;
+    bool isDirectory = !path.empty() && path.back() == '/';
+    while (!path.empty() && path.back() == '/') {
+        path.pop_back();
+    }
+
+    if (isDirectory) {
+        s_directories[path];
+    } else {
+        s_entries.emplace(path, entry);
+    }
+
+    // registers the entry in its folder and the folders up to "assets"
+    while (path != ASSETS_DIR) {
+        auto separator = path.find_last_of('/');
+        if (separator == string::npos) {
+            break;
+        }
+
+        auto parent = path.substr(0, separator);
+        bool isAdded = s_directories[parent].emplace(path.substr(separator + 1), isDirectory).second;
+        if (!isAdded && isDirectory) {
+            // the folders above are registered already
+            break;
+        }
+
+        path = parent;
+        isDirectory = true;
+    }
+}
+
+bool ApkFileSystem::GetDataOffset(const Entry& entry, uint64_t& dataOffset) {
+    // the lengths of the name and the extra field of the local header may differ from the central directory
+    uint8_t header[LOCAL_HEADER_SIZE];
+    if (!File::ReadAt(s_fd, header, sizeof(header), entry.localHeaderOffset) || ReadUInt32(header) != LOCAL_HEADER_SIGNATURE) {
+        return false;
+    }
+
+    dataOffset = entry.localHeaderOffset + LOCAL_HEADER_SIZE + ReadUInt16(header + 26) + ReadUInt16(header + 28);
+
+    return dataOffset <= s_fileSize && entry.compressedSize <= s_fileSize - dataOffset;
+}
+
+bool ApkFileSystem::Inflate(const Entry& entry, uint64_t dataOffset, char* data) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // the entries are raw deflate streams, without the zlib header
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        return false;
+    }
+
+    const size_t CHUNK_SIZE = 64 * 1024;
+    uint8_t chunk[CHUNK_SIZE];
+    auto remaining = entry.compressedSize;
+    auto offset = dataOffset;
+
+    stream.next_out = reinterpret_cast<Bytef*>(data);
+    stream.avail_out = static_cast<uInt>(entry.size);
+
+    int result = Z_OK;
+    while (result == Z_OK && remaining > 0) {
+        auto length = static_cast<size_t>(min<uint64_t>(remaining, CHUNK_SIZE));
+        if (!File::ReadAt(s_fd, chunk, length, offset)) {
+            break;
+        }
+        remaining -= length;
+        offset += length;
+
+        stream.next_in = chunk;
+        stream.avail_in = static_cast<uInt>(length);
+        do {
+            result = inflate(&stream, Z_NO_FLUSH);
+        } while (result == Z_OK && stream.avail_in > 0 && stream.avail_out > 0);
+    }
+
+    bool isComplete = (result == Z_STREAM_END || (result == Z_OK && remaining == 0)) && stream.total_out == entry.size;
+    inflateEnd(&stream);
+
+    return isComplete;
+}
+
+bool ApkFileSystem::ToEntryName(const string& path, string& name) {
+    if (s_mounts.empty() || path.empty() || path[0] != '/') {
+        return false;
+    }
+
+    auto normalized = NormalizePath(path);
+    for (const auto& mount : s_mounts) {
+        const auto& mountPath = mount.first;
+        if (normalized.compare(0, mountPath.size(), mountPath) != 0) {
+            continue;
+        }
+
+        if (normalized.size() == mountPath.size()) {
+            name = mount.second;
+            return true;
+        }
+
+        if (normalized[mountPath.size()] == '/') {
+            name = mount.second + normalized.substr(mountPath.size());
+            return true;
+        }
+    }
+
+    return false;
+}
+
+mutex ApkFileSystem::s_mutex;
+int ApkFileSystem::s_fd = -1;
+uint64_t ApkFileSystem::s_fileSize = 0;
+unordered_map<string, ApkFileSystem::Entry> ApkFileSystem::s_entries;
+unordered_map<string, unordered_map<string, bool>> ApkFileSystem::s_directories;
+vector<pair<string, string>> ApkFileSystem::s_mounts;
@@ -0,0 +1,127 @@
+#ifndef APKFILESYSTEM_H_
+#define APKFILESYSTEM_H_
+
+#include "File.h"
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tns {
+/*
+ * A read-only view of the assets of the application package, which lets the runtime read them
+ * in place instead of extracting them to the files directory.
+ *
+ * The central directory of the package is indexed once. A folder of the assets is then mounted
+ * at a path, e.g. "metadata" at <files>/metadata, and MappedFile, File::Exists and the module
+ * resolution serve the paths under it from the package only. The stored entries are mapped at
+ * their offset in the package, or read with pread when small, and the compressed ones are
+ * inflated into memory when read.
+ *
+ * Open and Mount are called before the runtime starts, the lookups and the reads may be done on
+ * any thread afterwards.
+ */
+class ApkFileSystem {
+    public:
+        struct Entry {
+            uint64_t localHeaderOffset;
+            uint64_t compressedSize;
+            uint64_t size;
+            uint32_t crc;
+            // in the MS-DOS format, the date in the high 16 bits
+            uint32_t modificationTime;
+            uint16_t method;
+        };
+
+        /*
+         * Indexes the assets of the package. Returns false if the package cannot be read or is not a zip file.
+         */
+        static bool Open(const std::string& apkPath);
+
+        /*
+         * Mounts the assets folder, e.g. "metadata", at the path. Returns false if the package has no such folder.
+         */
+        static bool Mount(const std::string& assetsDir, const std::string& mountPath);
+
+        /*
+         * Returns true if the path lies in a mounted folder, whether or not it exists in the package.
+         */
+        static bool IsMounted(const std::string& path);
+
+        /*
+         * Returns false if the path is not in a mounted folder or does not exist in the package.
+         */
+        static bool GetEntryKind(const std::string& path, bool& isDirectory);
+
+        /*
+         * Lists the names of the files and the folders in a mounted folder, each with whether it is a folder.
+         */
+        static bool ListDirectory(const std::string& path, std::vector<std::pair<std::string, bool>>& entries);
+
+        static bool FindFile(const std::string& path, Entry& entry);
+
+        /*
+         * Lists the files in the assets folder and its subfolders, with their names relative to the assets, e.g. "app/index.js".
+         */
+        static bool ListFiles(const std::string& assetsDir, std::vector<std::pair<std::string, Entry>>& files);
+
+        /*
+         * Maps a stored, i.e. uncompressed, entry. The content starts at data, in the mapping.
+         */
+        static bool MapEntry(const Entry& entry, MemoryMappedFile& mapping, const char*& data, FileAccess access);
+
+        /*
+         * Reads or inflates the content of an entry into data, which holds entry.size bytes.
+         */
+        static bool ReadEntry(const Entry& entry, char* data);
+
+        /*
+         * Writes the content of an entry to the file, in chunks, and checks its CRC.
+         */
+        static bool CopyEntry(const Entry& entry, int fd);
+
+        static time_t GetModificationTime(const Entry& entry);
+
+        /*
+         * Collapses the duplicate separators and the "." and ".." segments of an absolute path.
+         */
+        static std::string NormalizePath(const std::string& path);
+
+        static const uint16_t METHOD_STORED = 0;
+        static const uint16_t METHOD_DEFLATED = 8;
+
+    private:
+        static bool ReadCentralDirectory(int fd, uint64_t fileSize);
+
+        static void AddEntry(const std::string& name, const Entry& entry);
+
+        static bool GetDataOffset(const Entry& entry, uint64_t& dataOffset);
+
+        static bool Inflate(const Entry& entry, uint64_t dataOffset, char* data);
+
+        /*
+         * Maps the path to the name of the entry in the package, returns false if the path is not mounted.
+         */
+        static bool ToEntryName(const std::string& path, std::string& name);
+
+        static std::mutex s_mutex;
+
+        static int s_fd;
+
+        static uint64_t s_fileSize;
+
+        // the entries under "assets/" by name
+        static std::unordered_map<std::string, Entry> s_entries;
+
+        // the folders under "assets/", without the trailing separator -> entry name -> whether it is a folder
+        static std::unordered_map<std::string, std::unordered_map<std::string, bool>> s_directories;
+
+        // mount path -> assets folder
+        static std::vector<std::pair<std::string, std::string>> s_mounts;
+};
+}
+
+#endif /* APKFILESYSTEM_H_ */
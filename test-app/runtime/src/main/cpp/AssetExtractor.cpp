@@ -1,103 +1,275 @@
 #include "jni.h"
-#include "zip.h"
-#include <assert.h>
-#include <libgen.h>
-#include <utime.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <thread>
 #include <sys/stat.h>
+#include <unistd.h>
 #include "AssetExtractor.h"
+#include "CodeCacheBundle.h"
+#include "File.h"
+#include "NativeScriptException.h"
 
+using namespace std;
 using namespace tns;
 
-void AssetExtractor::ExtractAssets(JNIEnv* env, jobject obj, jstring apk, jstring input, jstring outputDir, jboolean _forceOverwrite) {
+void AssetExtractor::ExtractAssets(JNIEnv* env, jobject obj, jstring apk, jstring input, jstring outputDir, jstring manifestPath, jboolean _forceOverwrite) {
     auto forceOverwrite = JNI_TRUE == _forceOverwrite;
-    auto strApk = jstringToString(env, apk);
+    ExtractAssets(jstringToString(env, apk), jstringToString(env, input), jstringToString(env, outputDir), jstringToString(env, manifestPath), forceOverwrite);
+}
 
-    auto baseDir = jstringToString(env, outputDir);
+void AssetExtractor::ExtractAssets(const string& apkPath, const string& inputDir, const string& outputDir, const string& manifestPath, bool forceOverwrite) {
+    if (!ApkFileSystem::Open(apkPath)) {
+        throw NativeScriptException("Cannot read the assets of " + apkPath);
+    }
+
+    vector<pair<string, ApkFileSystem::Entry>> files;
+    if (!ApkFileSystem::ListFiles(inputDir, files)) {
+        return;
+    }
+
+    Manifest previousManifest;
+    if (ReadManifest(manifestPath, previousManifest)) {
+        // an interrupted extraction leaves no manifest, so the next one starts over
+        unlink(manifestPath.c_str());
+    }
+
+    Manifest manifest;
+    vector<size_t> changedFiles;
+    for (size_t i = 0; i < files.size(); i++) {
+        const auto& name = files[i].first;
+        const auto& entry = files[i].second;
+        auto path = outputDir + name;
 
-    std::string filePrefix("assets/");
-    int prefixLen = filePrefix.length();
-    filePrefix.append(jstringToString(env, input));
-    auto prfx = filePrefix.c_str();
-
-    int err = 0;
-    auto z = zip_open(strApk.c_str(), 0, &err);
-
-    assert(z != nullptr);
-    zip_int64_t num = zip_get_num_entries(z, 0);
-    struct zip_stat sb;
-    struct zip_file* zf;
-    char buf[65536];
-    auto pathcopy = new char[1024];
-
-    for (zip_int64_t i = 0; i < num; i++) {
-        zip_stat_index(z, i, ZIP_STAT_MTIME, &sb);
-        if (strstr(sb.name, prfx) == sb.name) {
-            auto name = sb.name + prefixLen; // strlen("assets/") == 7
-
-            std::string assetFullname(baseDir);
-            assetFullname.append(name);
-
-            struct stat attrib;
-            auto shouldOverwrite = true;
-            int ret = stat(assetFullname.c_str(), &attrib);
-            if (ret == 0 /* file exists */) {
-                auto diff = difftime(sb.mtime, attrib.st_mtime);
-                shouldOverwrite = diff > 0;
+        if (IsUnchanged(path, entry, previousManifest, name, forceOverwrite)) {
+            auto it = previousManifest.find(name);
+            if (it != previousManifest.end()) {
+                manifest.emplace(name, it->second);
             }
+        } else {
+            changedFiles.push_back(i);
+        }
+    }
+
+    // the files of the entries removed from the package
+    if (!previousManifest.empty()) {
+        unordered_set<string> names;
+        for (const auto& file : files) {
+            names.insert(file.first);
+        }
+        for (const auto& previous : previousManifest) {
+            if (names.find(previous.first) == names.end()) {
+                unlink((outputDir + previous.first).c_str());
+            }
+        }
+    }
+
+    // the larger files first, so that the threads finish together
+    sort(changedFiles.begin(), changedFiles.end(), [&files](size_t a, size_t b) {
+        return files[a].second.size > files[b].second.size;
+    });
+
+    // converted here, as mktime reads the time zone
+    vector<time_t> modificationTimes(files.size());
+    for (auto i : changedFiles) {
+        modificationTimes[i] = ApkFileSystem::GetModificationTime(files[i].second);
+    }
+
+    DirectoryCache directories;
+    vector<ManifestEntry> extracted(files.size());
+    vector<char> isExtracted(files.size(), 0);
+    atomic<size_t> next(0);
 
-            if (shouldOverwrite || forceOverwrite) {
-                strcpy(pathcopy, name);
-                auto path = dirname(pathcopy);
-                std::string dirFullname(baseDir);
-                dirFullname.append(path);
-                mkdir_rec(dirFullname.c_str());
-
-                zf = zip_fopen_index(z, i, 0);
-                assert(zf != nullptr);
-
-                auto fd = fopen(assetFullname.c_str(), "w");
-
-                if (fd != nullptr) {
-                    zip_int64_t sum = 0;
-                    while (sum != sb.size) {
-                        zip_int64_t len = zip_fread(zf, buf, sizeof(buf));
-                        assert(len > 0);
-
-                        fwrite(buf, 1, len, fd);
-                        sum += len;
-                    }
-                    fclose(fd);
-                    utimbuf t;
-                    t.modtime = sb.mtime;
-                    utime(assetFullname.c_str(), &t);
-                }
-
-                zip_fclose(zf);
+    auto extractFiles = [&]() {
+        size_t index;
+        while ((index = next++) < changedFiles.size()) {
+            auto fileIndex = changedFiles[index];
+            const auto& entry = files[fileIndex].second;
+            int64_t modificationTime;
+            if (Extract(outputDir + files[fileIndex].first, entry, modificationTimes[fileIndex], directories, modificationTime)) {
+                extracted[fileIndex] = { entry.crc, entry.size, modificationTime };
+                isExtracted[fileIndex] = 1;
             }
         }
+    };
+
+    auto threadsCount = min<size_t>(min<size_t>(max(thread::hardware_concurrency(), 1u), MAX_THREADS), changedFiles.size());
+    vector<thread> threads;
+    for (size_t i = 1; i < threadsCount; i++) {
+        threads.emplace_back(extractFiles);
+    }
+    extractFiles();
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    for (auto i : changedFiles) {
+        // the files which failed are extracted again the next time
+        if (isExtracted[i]) {
+            manifest.emplace(files[i].first, extracted[i]);
+        }
+    }
+
+    WriteManifest(manifestPath, manifest);
+}
+
+bool AssetExtractor::IsUnchanged(const string& path, const ApkFileSystem::Entry& entry, const Manifest& manifest, const string& name, bool forceOverwrite) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
     }
-    delete[] pathcopy;
-    zip_close(z);
+
+    auto it = manifest.find(name);
+    if (it != manifest.end()) {
+        const auto& recorded = it->second;
+        // a file rewritten since, e.g. by livesync, has another modification time
+        return recorded.crc == entry.crc && recorded.size == entry.size && static_cast<uint64_t>(st.st_size) == entry.size
+               && static_cast<int64_t>(st.st_mtime) == recorded.modificationTime;
+    }
+
+    return !forceOverwrite && difftime(ApkFileSystem::GetModificationTime(entry), st.st_mtime) <= 0;
 }
 
-void AssetExtractor::mkdir_rec(const char* dir) {
-    char opath[256];
-    snprintf(opath, sizeof(opath), "%s", dir);
-    size_t len = strlen(opath);
+bool AssetExtractor::Extract(const string& path, const ApkFileSystem::Entry& entry, time_t entryTime, DirectoryCache& directories, int64_t& modificationTime) {
+    auto separator = path.find_last_of('/');
+    if (separator != string::npos && separator > 0) {
+        directories.Create(path.substr(0, separator));
+    }
 
-    if (opath[len - 1] == '/') {
-        opath[len - 1] = 0;
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, S_IRUSR | S_IWUSR);
+    if (fd == -1) {
+        return false;
     }
 
-    for (char* p = opath + 1; *p; p++) {
-        if (*p == '/') {
-            *p = 0;
-            mkdir(opath, S_IRWXU);
-            *p = '/';
+    bool isCopied = ApkFileSystem::CopyEntry(entry, fd);
+
+    struct timespec times[2];
+    times[0].tv_sec = 0;
+    times[0].tv_nsec = UTIME_OMIT;
+    times[1].tv_sec = entryTime;
+    times[1].tv_nsec = 0;
+    futimens(fd, times);
+
+    struct stat st;
+    isCopied = isCopied && fstat(fd, &st) == 0;
+    modificationTime = isCopied ? static_cast<int64_t>(st.st_mtime) : 0;
+    close(fd);
+
+    return isCopied;
+}
+
+void AssetExtractor::DirectoryCache::Create(const string& dir) {
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_created.find(dir) != m_created.end()) {
+        return;
+    }
+
+    // creates the missing parents first, stopping at the first one created before
+    vector<string> missing;
+    auto current = dir;
+    while (!current.empty() && m_created.find(current) == m_created.end()) {
+        missing.push_back(current);
+        auto separator = current.find_last_of('/');
+        if (separator == string::npos || separator == 0) {
+            break;
         }
+        current = current.substr(0, separator);
     }
 
-    mkdir(opath, S_IRWXU);
+    for (auto it = missing.rbegin(); it != missing.rend(); ++it) {
+        mkdir(it->c_str(), S_IRWXU);
+        m_created.insert(*it);
+    }
+}
+
+bool AssetExtractor::ReadManifest(const string& manifestPath, Manifest& manifest) {
+    MappedFile file(manifestPath, FileAccess::Sequential);
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    auto data = file.Data();
+    size_t size = file.Size();
+    uint64_t checksum = 0;
+    if (size < sizeof(MAGIC) + sizeof(uint32_t) * 2 + sizeof(checksum) || memcmp(data, MAGIC, sizeof(MAGIC)) != 0) {
+        return false;
+    }
+
+    size -= sizeof(checksum);
+    memcpy(&checksum, data + size, sizeof(checksum));
+    if (checksum != CodeCacheBundle::Hash(data, size)) {
+        return false;
+    }
+
+    size_t pos = sizeof(MAGIC);
+    auto read = [&](void* value, size_t length) {
+        if (pos + length > size) {
+            return false;
+        }
+        memcpy(value, data + pos, length);
+        pos += length;
+        return true;
+    };
+
+    uint32_t version = 0;
+    uint32_t count = 0;
+    bool isValid = read(&version, sizeof(version)) && version == VERSION && read(&count, sizeof(count));
+
+    for (uint32_t i = 0; isValid && i < count; i++) {
+        ManifestEntry entry;
+        uint32_t nameLength = 0;
+        isValid = read(&entry.crc, sizeof(entry.crc)) && read(&entry.size, sizeof(entry.size))
+                  && read(&entry.modificationTime, sizeof(entry.modificationTime)) && read(&nameLength, sizeof(nameLength))
+                  && pos + nameLength <= size;
+        if (isValid) {
+            manifest.emplace(string(data + pos, nameLength), entry);
+            pos += nameLength;
+        }
+    }
+
+    if (!isValid) {
+        manifest.clear();
+    }
+
+    return isValid;
+}
+
+bool AssetExtractor::WriteManifest(const string& manifestPath, const Manifest& manifest) {
+    string buffer(MAGIC, sizeof(MAGIC));
+    auto append = [&buffer](const void* value, size_t length) {
+        buffer.append(static_cast<const char*>(value), length);
+    };
+
+    auto version = VERSION;
+    auto count = static_cast<uint32_t>(manifest.size());
+    append(&version, sizeof(version));
+    append(&count, sizeof(count));
+
+    for (const auto& entry : manifest) {
+        auto nameLength = static_cast<uint32_t>(entry.first.size());
+        append(&entry.second.crc, sizeof(entry.second.crc));
+        append(&entry.second.size, sizeof(entry.second.size));
+        append(&entry.second.modificationTime, sizeof(entry.second.modificationTime));
+        append(&nameLength, sizeof(nameLength));
+        buffer += entry.first;
+    }
+
+    auto checksum = CodeCacheBundle::Hash(buffer.data(), buffer.size());
+    append(&checksum, sizeof(checksum));
+
+    auto tmpPath = manifestPath + ".tmp";
+    return File::WriteBinary(tmpPath, buffer.data(), buffer.size()) && rename(tmpPath.c_str(), manifestPath.c_str()) == 0;
+}
+
+bool AssetExtractor::MountAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir) {
+    auto strApk = jstringToString(env, apk);
+    auto input = jstringToString(env, inputDir);
+    auto baseDir = jstringToString(env, outputDir);
+
+    return ApkFileSystem::Open(strApk) && ApkFileSystem::Mount(input, baseDir + input);
 }
 
 std::string AssetExtractor::jstringToString(JNIEnv* env, jstring value) {
@@ -112,3 +284,5 @@ std::string AssetExtractor::jstringToString(JNIEnv* env, jstring value) {
 
     return s;
 }
+
+const char AssetExtractor::MAGIC[4] = { 'N', 'S', 'A', 'M' };
@@ -2,15 +2,75 @@
 #define ASSETEXTRACTOR_
 
 #include "JEnv.h"
+#include "ApkFileSystem.h"
+#include <cstdint>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace tns {
+/*
+ * Extracts the assets to the files directory, on a bounded number of threads, each reading the
+ * package with pread.
+ *
+ * The files written are recorded in a manifest, with the CRC and the size of their entries and the
+ * modification time they were given. The files whose entries are unchanged, and which were not
+ * modified since, are skipped on the next extraction, and the files of the removed entries are
+ * deleted. Without a manifest the existing files are compared by their modification times, as
+ * before, unless the extraction is forced.
+ */
 class AssetExtractor {
     public:
-        static void ExtractAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir, jboolean _forceOverwrite);
+        static void ExtractAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir, jstring manifestPath, jboolean _forceOverwrite);
+
+        static void ExtractAssets(const std::string& apkPath, const std::string& inputDir, const std::string& outputDir, const std::string& manifestPath, bool forceOverwrite);
+
+        /*
+         * Serves the assets in inputDir from the package, at outputDir + inputDir, instead of extracting them.
+         */
+        static bool MountAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir);
 
     private:
+        struct ManifestEntry {
+            uint32_t crc;
+            uint64_t size;
+            int64_t modificationTime;
+        };
+
+        typedef std::unordered_map<std::string, ManifestEntry> Manifest;
+
+        /*
+         * The directories created by the extraction, shared by its threads.
+         */
+        class DirectoryCache {
+            public:
+                void Create(const std::string& dir);
+
+            private:
+                std::mutex m_mutex;
+                std::unordered_set<std::string> m_created;
+        };
+
+        static bool IsUnchanged(const std::string& path, const ApkFileSystem::Entry& entry, const Manifest& manifest, const std::string& name, bool forceOverwrite);
+
+        static bool Extract(const std::string& path, const ApkFileSystem::Entry& entry, time_t entryTime, DirectoryCache& directories, int64_t& modificationTime);
+
+        static bool ReadManifest(const std::string& manifestPath, Manifest& manifest);
+
+        static bool WriteManifest(const std::string& manifestPath, const Manifest& manifest);
+
         static std::string jstringToString(JNIEnv* env, jstring value);
-        static void mkdir_rec(const char* dir);
+
+        // the extraction is bound by the storage, so more threads do not help
+        static const unsigned MAX_THREADS = 4;
+
+        static const uint32_t VERSION = 1;
+
+        static const char MAGIC[4];
 };
 }
 #endif /* ASSETEXTRACTOR_ */
@@ -0,0 +1,199 @@
+#include "BackgroundCompiler.h"
+#include "ArgConverter.h"
+#include "CodeCacheBundle.h"
+#include "Constants.h"
+#include "NativeScriptAssert.h"
+#include "Runtime.h"
+#include "v8-platform.h"
+#include <cstring>
+
+using namespace v8;
+using namespace std;
+using namespace tns;
+
+/*
+ * Hands the whole wrapped module to V8 in a single chunk. Called on a worker thread.
+ */
+class BackgroundCompiler::SourceStream : public ScriptCompiler::ExternalSourceStream {
+    public:
+        SourceStream(BackgroundCompiler* compiler, Job* job)
+            : m_compiler(compiler), m_job(job), m_isRead(false) {
+        }
+
+        size_t GetMoreData(const uint8_t** src) override {
+            if (m_isRead) {
+                return 0;
+            }
+            m_isRead = true;
+
+            auto content = ModuleSource::Open(m_job->path);
+            if (content == nullptr) {
+                m_job->isSkipped = true;
+                return 0;
+            }
+
+            if (Constants::V8_CACHE_COMPILED_CODE && CodeCacheBundle::GetInstance()->Contains(m_job->path, content->GetHash())) {
+                m_job->isSkipped = true;
+                return 0;
+            }
+
+            string& source = m_job->source;
+            source.reserve(m_compiler->m_prologue.size() + content->length() + m_compiler->m_epilogue.size());
+            source += m_compiler->m_prologue;
+            source.append(content->data(), content->length());
+            source += m_compiler->m_epilogue;
+            m_job->content = move(content);
+
+            // V8 takes the ownership of the chunk
+            auto chunk = new uint8_t[source.size()];
+            memcpy(chunk, source.data(), source.size());
+            *src = chunk;
+
+            return source.size();
+        }
+
+    private:
+        BackgroundCompiler* m_compiler;
+        Job* m_job;
+        bool m_isRead;
+};
+
+class BackgroundCompiler::StreamingTask : public Task {
+    public:
+        StreamingTask(BackgroundCompiler* compiler, Job* job, ScriptCompiler::ScriptStreamingTask* task)
+            : m_compiler(compiler), m_job(job), m_task(task) {
+        }
+
+        void Run() override {
+            m_task->Run();
+            m_compiler->OnJobDone(m_job);
+        }
+
+    private:
+        BackgroundCompiler* m_compiler;
+        Job* m_job;
+        unique_ptr<ScriptCompiler::ScriptStreamingTask> m_task;
+};
+
+BackgroundCompiler::BackgroundCompiler(const char* prologue, const char* epilogue)
+    : m_isolate(nullptr), m_prologue(prologue), m_epilogue(epilogue) {
+}
+
+BackgroundCompiler::~BackgroundCompiler() {
+    // the tasks refer to the jobs, which own the V8 streaming data
+    for (auto& pair : m_jobs) {
+        WaitFor(pair.second.get());
+    }
+    for (auto& job : m_discardedJobs) {
+        WaitFor(job.get());
+    }
+}
+
+void BackgroundCompiler::Init(Isolate* isolate) {
+    m_isolate = isolate;
+}
+
+void BackgroundCompiler::Start(const string& path) {
+    if (m_jobs.find(path) != m_jobs.end()) {
+        return;
+    }
+
+    DeleteDiscardedJobs();
+
+    auto job = new Job();
+    job->path = path;
+    job->isDone = false;
+    job->isSkipped = false;
+    m_jobs.emplace(path, unique_ptr<Job>(job));
+
+    job->streamedSource.reset(new ScriptCompiler::StreamedSource(unique_ptr<ScriptCompiler::ExternalSourceStream>(new SourceStream(this, job)),
+                              ScriptCompiler::StreamedSource::UTF8));
+
+    auto streamingTask = ScriptCompiler::StartStreamingScript(m_isolate, job->streamedSource.get());
+
+    Runtime::platform->CallOnWorkerThread(unique_ptr<Task>(new StreamingTask(this, job, streamingTask)));
+}
+
+bool BackgroundCompiler::IsStarted(const string& path) const {
+    return m_jobs.find(path) != m_jobs.end();
+}
+
+size_t BackgroundCompiler::PendingCount() const {
+    return m_jobs.size();
+}
+
+bool BackgroundCompiler::Finish(Local<Context> context, const string& path, const ScriptOrigin& origin,
+                                Local<Script>& script, unique_ptr<ModuleSource>& content) {
+    auto it = m_jobs.find(path);
+    if (it == m_jobs.end()) {
+        return false;
+    }
+
+    unique_ptr<Job> job(it->second.release());
+    m_jobs.erase(it);
+
+    WaitFor(job.get());
+
+    if (job->isSkipped) {
+        return false;
+    }
+
+    Local<String> fullSource;
+    if (job->content->IsAscii()) {
+        fullSource = String::NewFromOneByte(m_isolate, reinterpret_cast<const uint8_t*>(job->source.data()), NewStringType::kNormal, job->source.size()).ToLocalChecked();
+    } else {
+        fullSource = ArgConverter::ConvertToV8String(m_isolate, job->source);
+    }
+    auto maybeScript = ScriptCompiler::Compile(context, job->streamedSource.get(), fullSource, origin);
+
+    // the exception, if any, is left for the caller's TryCatch
+    if (!maybeScript.ToLocal(&script)) {
+        return true;
+    }
+
+    content = move(job->content);
+
+    return true;
+}
+
+void BackgroundCompiler::Discard(const vector<string>& paths) {
+    for (const auto& path : paths) {
+        auto it = m_jobs.find(path);
+        if (it != m_jobs.end()) {
+            m_discardedJobs.push_back(move(it->second));
+            m_jobs.erase(it);
+        }
+    }
+
+    DeleteDiscardedJobs();
+}
+
+void BackgroundCompiler::DeleteDiscardedJobs() {
+    if (m_discardedJobs.empty()) {
+        return;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    auto it = m_discardedJobs.begin();
+    while (it != m_discardedJobs.end()) {
+        if ((*it)->isDone) {
+            it = m_discardedJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void BackgroundCompiler::WaitFor(Job* job) {
+    unique_lock<mutex> lock(m_mutex);
+    m_jobDone.wait(lock, [job] {
+        return job->isDone;
+    });
+}
+
+void BackgroundCompiler::OnJobDone(Job* job) {
+    // notified under the lock, as the compiler may be destroyed as soon as the job is done
+    lock_guard<mutex> lock(m_mutex);
+    job->isDone = true;
+    m_jobDone.notify_all();
+}
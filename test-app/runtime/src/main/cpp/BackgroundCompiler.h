@@ -0,0 +1,95 @@
+#ifndef BACKGROUNDCOMPILER_H_
+#define BACKGROUNDCOMPILER_H_
+
+#include "v8.h"
+#include "ModuleSource.h"
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tns {
+/*
+ * Compiles the modules which are expected to be required soon on the V8 worker threads.
+ *
+ * The module file is read, wrapped and parsed by a streaming task, so the isolate thread only
+ * resolves the path and posts the task. When the module is required, Finish waits for the task
+ * and finalizes the compilation on the isolate thread. Modules which have a code cache are not
+ * compiled in the background, as consuming the cache is cheaper than streaming.
+ *
+ * V8 streams scripts only, so the modules compiled here are wrapped in a function expression.
+ */
+class BackgroundCompiler {
+    public:
+        BackgroundCompiler(const char* prologue, const char* epilogue);
+
+        /*
+         * Waits for the tasks still running.
+         */
+        ~BackgroundCompiler();
+
+        void Init(v8::Isolate* isolate);
+
+        /*
+         * Starts compiling the module at the given (resolved) path, unless it is already being compiled.
+         */
+        void Start(const std::string& path);
+
+        bool IsStarted(const std::string& path) const;
+
+        size_t PendingCount() const;
+
+        /*
+         * Returns false if no compilation was started for the path, or if it was given up
+         * because the module has a code cache or could not be read. Otherwise returns the
+         * compiled script along with the source of the module.
+         */
+        bool Finish(v8::Local<v8::Context> context, const std::string& path, const v8::ScriptOrigin& origin,
+                    v8::Local<v8::Script>& script, std::unique_ptr<ModuleSource>& content);
+
+        /*
+         * Gives up the compilations of the modules which were not required after all.
+         */
+        void Discard(const std::vector<std::string>& paths);
+
+    private:
+        struct Job {
+            std::string path;
+            std::unique_ptr<ModuleSource> content;
+            // the content wrapped in the function expression
+            std::string source;
+            bool isDone;
+            bool isSkipped;
+            std::unique_ptr<v8::ScriptCompiler::StreamedSource> streamedSource;
+        };
+
+        class SourceStream;
+
+        class StreamingTask;
+
+        void WaitFor(Job* job);
+
+        void OnJobDone(Job* job);
+
+        void DeleteDiscardedJobs();
+
+        v8::Isolate* m_isolate;
+
+        std::string m_prologue;
+
+        std::string m_epilogue;
+
+        std::map<std::string, std::unique_ptr<Job>> m_jobs;
+
+        // the jobs given up while their tasks were still running
+        std::vector<std::unique_ptr<Job>> m_discardedJobs;
+
+        std::mutex m_mutex;
+
+        std::condition_variable m_jobDone;
+};
+}
+
+#endif /* BACKGROUNDCOMPILER_H_ */
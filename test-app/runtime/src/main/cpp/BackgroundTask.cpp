@@ -0,0 +1,60 @@
+#include "BackgroundTask.h"
+#include <assert.h>
+#include <sys/prctl.h>
+
+using namespace std;
+using namespace tns;
+
+BackgroundTask::BackgroundTask()
+    : m_isStarted(false), m_isDone(false) {
+}
+
+BackgroundTask::~BackgroundTask() {
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void BackgroundTask::Start(const char* threadName, function<void()> task) {
+    lock_guard<mutex> lock(m_mutex);
+    assert(!m_isStarted);
+
+    m_isStarted = true;
+    m_thread = thread(&BackgroundTask::Run, this, threadName, move(task));
+}
+
+void BackgroundTask::Run(const char* threadName, const function<void()>& task) {
+    prctl(PR_SET_NAME, threadName);
+
+    exception_ptr exception;
+    try {
+        task();
+    } catch (...) {
+        exception = current_exception();
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    m_exception = exception;
+    m_isDone = true;
+    m_doneCondition.notify_all();
+}
+
+void BackgroundTask::Wait() {
+    unique_lock<mutex> lock(m_mutex);
+    if (!m_isStarted) {
+        return;
+    }
+
+    m_doneCondition.wait(lock, [this] {
+        return m_isDone;
+    });
+
+    if (m_exception) {
+        rethrow_exception(m_exception);
+    }
+}
+
+bool BackgroundTask::IsDone() {
+    lock_guard<mutex> lock(m_mutex);
+    return m_isDone;
+}
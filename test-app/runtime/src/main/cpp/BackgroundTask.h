@@ -0,0 +1,54 @@
+#ifndef BACKGROUNDTASK_H_
+#define BACKGROUNDTASK_H_
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace tns {
+/*
+ * Runs a piece of the startup on a thread of its own, so that it overlaps with the work of the
+ * calling thread. The calling thread synchronizes with it in Wait, right before it needs the result.
+ *
+ * An exception thrown by the task is rethrown by every Wait, on the waiting thread.
+ */
+class BackgroundTask {
+    public:
+        BackgroundTask();
+
+        /*
+         * Waits for the task, without rethrowing its exception.
+         */
+        ~BackgroundTask();
+
+        /*
+         * Starts the task on a thread with the given name, at most 15 characters long, as it
+         * shows in the traces. A task can be started once.
+         */
+        void Start(const char* threadName, std::function<void()> task);
+
+        /*
+         * Blocks until the task has finished. Returns at once if the task was not started.
+         */
+        void Wait();
+
+        bool IsDone();
+
+    private:
+        void Run(const char* threadName, const std::function<void()>& task);
+
+        std::thread m_thread;
+        std::mutex m_mutex;
+        std::condition_variable m_doneCondition;
+        bool m_isStarted;
+        bool m_isDone;
+        std::exception_ptr m_exception;
+
+        BackgroundTask(const BackgroundTask&) = delete;
+        BackgroundTask& operator=(const BackgroundTask&) = delete;
+};
+}
+
+#endif /* BACKGROUNDTASK_H_ */
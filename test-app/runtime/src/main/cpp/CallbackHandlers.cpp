@@ -17,6 +17,8 @@
 #include "MethodCache.h"
 #include "SimpleProfiler.h"
 #include "Runtime.h"
+#include "RuntimeStats.h"
+#include "TraceRecorder.h"
 
 using namespace v8;
 using namespace std;
@@ -46,6 +48,10 @@ void CallbackHandlers::Init(Isolate* isolate) {
                         "(Ljava/lang/String;I)[Ljava/lang/String;");
     assert(GET_TYPE_METADATA != nullptr);
 
+    GET_METHOD_SLOT_NAME_METHOD_ID = env.GetStaticMethodID(RUNTIME_CLASS, "getMethodSlotName",
+                                     "(I)Ljava/lang/String;");
+    assert(GET_METHOD_SLOT_NAME_METHOD_ID != nullptr);
+
     ENABLE_VERBOSE_LOGGING_METHOD_ID = env.GetMethodID(RUNTIME_CLASS, "enableVerboseLogging",
                                        "()V");
     assert(ENABLE_VERBOSE_LOGGING_METHOD_ID != nullptr);
@@ -198,6 +204,8 @@ void CallbackHandlers::CallJavaMethod(const Local<Object>& caller, const string&
                                       bool isSuper,
                                       const v8::FunctionCallbackInfo<v8::Value>& args) {
     SET_PROFILER_FRAME();
+    RUNTIME_STATS_INCREMENT(args.GetIsolate(), JavaMethodCalls);
+    TraceRecorder::Scope traceScope("jni", className, methodName, JAVA_CALL_TRACE_THRESHOLD_MICROS);
 
     JEnv env;
 
@@ -701,6 +709,60 @@ void CallbackHandlers::TimeCallback(const v8::FunctionCallbackInfo<v8::Value>& a
     args.GetReturnValue().Set(duration);
 }
 
+#ifdef RUNTIME_STATS_ENABLED
+void CallbackHandlers::RuntimeStatsCallback(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    try {
+        auto isolate = args.GetIsolate();
+        auto context = isolate->GetCurrentContext();
+        auto stats = RuntimeStats::Get(isolate);
+
+        RuntimeStats::Snapshot snapshot;
+        stats->TakeSnapshot(snapshot);
+
+        auto result = Object::New(isolate);
+        for (int i = 0; i < static_cast<int>(RuntimeStats::Counter::END); i++) {
+            auto name = RuntimeStats::GetName(static_cast<RuntimeStats::Counter>(i));
+            result->Set(context, ArgConverter::ConvertToV8String(isolate, name), Number::New(isolate, snapshot.counters[i]));
+        }
+
+        auto objectManager = Runtime::GetObjectManager(isolate);
+        result->Set(context, ArgConverter::ConvertToV8String(isolate, "linkedObjects"), Number::New(isolate, objectManager->GetLinkedObjectsCount()));
+        result->Set(context, ArgConverter::ConvertToV8String(isolate, "wrapperSlabs"), Number::New(isolate, objectManager->GetWrapperSlabCount()));
+
+        auto histograms = Object::New(isolate);
+        for (int i = 0; i < static_cast<int>(RuntimeStats::Histogram::END); i++) {
+            auto& histogramSnapshot = snapshot.histograms[i];
+
+            auto buckets = Array::New(isolate, RuntimeStats::HISTOGRAM_BUCKETS);
+            for (int j = 0; j < RuntimeStats::HISTOGRAM_BUCKETS; j++) {
+                buckets->Set(context, j, Number::New(isolate, histogramSnapshot.buckets[j]));
+            }
+
+            auto histogram = Object::New(isolate);
+            histogram->Set(context, ArgConverter::ConvertToV8String(isolate, "count"), Number::New(isolate, histogramSnapshot.count));
+            histogram->Set(context, ArgConverter::ConvertToV8String(isolate, "totalMicroseconds"), Number::New(isolate, histogramSnapshot.totalMicroseconds));
+            histogram->Set(context, ArgConverter::ConvertToV8String(isolate, "buckets"), buckets);
+
+            auto name = RuntimeStats::GetName(static_cast<RuntimeStats::Histogram>(i));
+            histograms->Set(context, ArgConverter::ConvertToV8String(isolate, name), histogram);
+        }
+        result->Set(context, ArgConverter::ConvertToV8String(isolate, "histograms"), histograms);
+
+        args.GetReturnValue().Set(result);
+    } catch (NativeScriptException& e) {
+        e.ReThrowToV8();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToV8();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToV8();
+    }
+}
+#endif
+
 void CallbackHandlers::ReleaseNativeCounterpartCallback(
     const v8::FunctionCallbackInfo<v8::Value>& info) {
     try {
@@ -841,56 +903,82 @@ vector<string> CallbackHandlers::GetTypeMetadata(const string& name, int index)
     return result;
 }
 
+bool CallbackHandlers::GetMethodSlotName(int methodSlot, string& methodName) {
+    JEnv env;
+
+    JniLocalRef name(env.CallStaticObjectMethod(RUNTIME_CLASS, GET_METHOD_SLOT_NAME_METHOD_ID, methodSlot));
+    if (name.IsNull()) {
+        return false;
+    }
+
+    methodName = ArgConverter::jstringToString(name);
+    return true;
+}
+
 Local<Value> CallbackHandlers::CallJSMethod(Isolate* isolate, JNIEnv* _env,
-        const Local<Object>& jsObject, const string& methodName,
+        const Local<Object>& jsObject, const Local<String>& methodName,
         jobjectArray args) {
     SET_PROFILER_FRAME();
 
     JEnv env(_env);
-    Local<Value> result;
+    EscapableHandleScope handleScope(isolate);
 
     auto context = Runtime::GetRuntime(isolate)->GetContext();
-    auto method = jsObject->Get(context, ArgConverter::ConvertToV8String(isolate, methodName)).ToLocalChecked();
+    auto jsMethod = GetJSMethod(isolate, jsObject, methodName);
+
+    auto jsArgs = ArgConverter::ConvertJavaArgsToJsArgs(context, args);
+    int argc = jsArgs->Length();
+
+    std::vector<Local<Value>> arguments(argc);
+    for (int i = 0; i < argc; i++) {
+        arguments[i] = jsArgs->Get(context, i).ToLocalChecked();
+    }
+
+    auto jsResult = CallJSMethod(isolate, jsObject, jsMethod, methodName, argc, argc == 0 ? nullptr : arguments.data());
+
+    return handleScope.Escape(jsResult);
+}
+
+Local<Function> CallbackHandlers::GetJSMethod(Isolate* isolate, const Local<Object>& jsObject, const Local<String>& methodName) {
+    auto context = Runtime::GetRuntime(isolate)->GetContext();
+    auto method = jsObject->Get(context, methodName).ToLocalChecked();
 
     if (method.IsEmpty() || method->IsUndefined()) {
         stringstream ss;
-        ss << "Cannot find method '" << methodName << "' implementation";
+        ss << "Cannot find method '" << ArgConverter::ConvertToString(methodName) << "' implementation";
         throw NativeScriptException(ss.str());
     } else if (!method->IsFunction()) {
         stringstream ss;
-        ss << "Property '" << methodName << "' is not a function";
+        ss << "Property '" << ArgConverter::ConvertToString(methodName) << "' is not a function";
         throw NativeScriptException(ss.str());
-    } else {
-        EscapableHandleScope handleScope(isolate);
+    }
 
-        auto jsMethod = method.As<Function>();
-        auto jsArgs = ArgConverter::ConvertJavaArgsToJsArgs(context, args);
-        int argc = jsArgs->Length();
+    return method.As<Function>();
+}
 
-        std::vector<Local<Value>> arguments(argc);
-        for (int i = 0; i < argc; i++) {
-            arguments[i] = jsArgs->Get(context, i).ToLocalChecked();
-        }
+Local<Value> CallbackHandlers::CallJSMethod(Isolate* isolate, const Local<Object>& jsObject, const Local<Function>& jsMethod,
+        const Local<String>& methodName, int argc, Local<Value> argv[]) {
+    RUNTIME_STATS_INCREMENT(isolate, JsMethodCalls);
 
-        TryCatch tc(isolate);
-        Local<Value> jsResult;
-        {
-            SET_PROFILER_FRAME();
-            jsMethod->Call(context, jsObject, argc, argc == 0 ? nullptr : arguments.data()).ToLocal(&jsResult);
-        }
+    EscapableHandleScope handleScope(isolate);
+    auto context = Runtime::GetRuntime(isolate)->GetContext();
 
-        //TODO: if javaResult is a pure js object create a java object that represents this object in java land
+    TryCatch tc(isolate);
+    Local<Value> jsResult;
+    {
+        SET_PROFILER_FRAME();
+        jsMethod->Call(context, jsObject, argc, argv).ToLocal(&jsResult);
+    }
 
-        if (tc.HasCaught()) {
-            stringstream ss;
-            ss << "Calling js method " << methodName << " failed";
-            throw NativeScriptException(tc, ss.str());
-        }
+    //TODO: if javaResult is a pure js object create a java object that represents this object in java land
 
-        result = handleScope.Escape(jsResult);
+    if (tc.HasCaught()) {
+        stringstream ss;
+        ss << "Calling js method " << ArgConverter::ConvertToString(methodName) << " failed";
+        throw NativeScriptException(tc, ss.str());
     }
 
-    return result;
+    return handleScope.Escape(jsResult);
 }
 
 Local<Object> CallbackHandlers::FindClass(Isolate* isolate, const string& className) {
@@ -1514,6 +1602,7 @@ jfieldID CallbackHandlers::CURRENT_OBJECTID_FIELD_ID = nullptr;
 jmethodID CallbackHandlers::RESOLVE_CLASS_METHOD_ID = nullptr;
 jmethodID CallbackHandlers::MAKE_INSTANCE_STRONG_ID = nullptr;
 jmethodID CallbackHandlers::GET_TYPE_METADATA = nullptr;
+jmethodID CallbackHandlers::GET_METHOD_SLOT_NAME_METHOD_ID = nullptr;
 jmethodID CallbackHandlers::ENABLE_VERBOSE_LOGGING_METHOD_ID = nullptr;
 jmethodID CallbackHandlers::DISABLE_VERBOSE_LOGGING_METHOD_ID = nullptr;
 jmethodID CallbackHandlers::INIT_WORKER_METHOD_ID = nullptr;
@@ -64,7 +64,19 @@ namespace tns {
 
         static v8::Local<v8::Value>
         CallJSMethod(v8::Isolate *isolate, JNIEnv *_env, const v8::Local<v8::Object> &jsObject,
-                     const std::string &methodName, jobjectArray args);
+                     const v8::Local<v8::String> &methodName, jobjectArray args);
+
+        /*
+         * Returns the method of the JS object, throwing if it is missing or not a function.
+         */
+        static v8::Local<v8::Function>
+        GetJSMethod(v8::Isolate *isolate, const v8::Local<v8::Object> &jsObject,
+                    const v8::Local<v8::String> &methodName);
+
+        static v8::Local<v8::Value>
+        CallJSMethod(v8::Isolate *isolate, const v8::Local<v8::Object> &jsObject,
+                     const v8::Local<v8::Function> &jsMethod, const v8::Local<v8::String> &methodName,
+                     int argc, v8::Local<v8::Value> argv[]);
 
         static v8::Local<v8::Value>
         GetJavaField(v8::Isolate *isolate, const v8::Local<v8::Object> &caller,
@@ -77,6 +89,13 @@ namespace tns {
 
         static void TimeCallback(const v8::FunctionCallbackInfo<v8::Value> &args);
 
+#ifdef RUNTIME_STATS_ENABLED
+        /*
+         * Returns a snapshot of the RuntimeStats counters and histograms of the current isolate.
+         */
+        static void RuntimeStatsCallback(const v8::FunctionCallbackInfo<v8::Value> &args);
+#endif
+
         static void
         DumpReferenceTablesMethodCallback(const v8::FunctionCallbackInfo<v8::Value> &args);
 
@@ -91,6 +110,11 @@ namespace tns {
 
         static std::vector<std::string> GetTypeMetadata(const std::string &name, int index);
 
+        /*
+         * Gets the JS method name of a slot handle from com.tns.Runtime. Returns false for an unknown slot.
+         */
+        static bool GetMethodSlotName(int methodSlot, std::string &methodName);
+
         /*
          * Gets all methods in the implementation object, and packs them in a jobjectArray
          * to pass them to Java Land, so that their corresponding Java callbacks are written when
@@ -202,6 +226,9 @@ namespace tns {
 
         static short MAX_JAVA_STRING_ARRAY_LENGTH;
 
+        // the Java calls recorded in the trace, the faster ones are too many to be of use
+        static const int64_t JAVA_CALL_TRACE_THRESHOLD_MICROS = 1000;
+
         static jclass RUNTIME_CLASS;
 
         static jclass JAVA_LANG_STRING;
@@ -214,6 +241,8 @@ namespace tns {
 
         static jmethodID GET_TYPE_METADATA;
 
+        static jmethodID GET_METHOD_SLOT_NAME_METHOD_ID;
+
         static jmethodID ENABLE_VERBOSE_LOGGING_METHOD_ID;
 
         static jmethodID DISABLE_VERBOSE_LOGGING_METHOD_ID;
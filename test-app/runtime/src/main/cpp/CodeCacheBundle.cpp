@@ -0,0 +1,492 @@
+#include "CodeCacheBundle.h"
+#include "ManualInstrumentation.h"
+#include "NativeScriptAssert.h"
+#include "XxHash.h"
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace v8;
+using namespace std;
+using namespace tns;
+
+class CodeCacheBundle::WriteTask : public Task {
+    public:
+        WriteTask(CodeCacheBundle* bundle)
+            : m_bundle(bundle) {
+        }
+
+        void Run() override {
+            m_bundle->WritePending();
+        }
+
+    private:
+        CodeCacheBundle* m_bundle;
+};
+
+const char CodeCacheBundle::MAGIC[8] = { 'N', 'S', 'C', 'C', 'B', 'N', 'D', 'L' };
+
+CodeCacheBundle::CodeCacheBundle()
+    : m_platform(nullptr), m_fd(-1), m_fileSize(0), m_table(nullptr), m_tableCapacity(0),
+      m_paths(nullptr), m_pathsSize(0), m_versionTag(0), m_isWriteScheduled(false),
+      m_isFlushRequested(false), m_unflushedCount(0) {
+}
+
+CodeCacheBundle* CodeCacheBundle::GetInstance() {
+    // shared by the main thread and the workers for the lifetime of the process
+    static CodeCacheBundle* instance = new CodeCacheBundle();
+    return instance;
+}
+
+uint64_t CodeCacheBundle::Hash(const char* data, size_t length) {
+    return XxHash::Hash64(data, length);
+}
+
+uint64_t CodeCacheBundle::HeaderChecksum(const Header& header) {
+    return XxHash::Hash64(&header, offsetof(Header, checksum));
+}
+
+const uint8_t* CodeCacheBundle::MappedBytes() const {
+    return static_cast<const uint8_t*>(m_mapping.memory);
+}
+
+uint64_t CodeCacheBundle::AlignToPage(uint64_t offset) {
+    static const uint64_t pageSize = sysconf(_SC_PAGESIZE);
+    return (offset + pageSize - 1) / pageSize * pageSize;
+}
+
+void CodeCacheBundle::Open(const string& path, uint32_t versionTag, Platform* platform) {
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_fd != -1) {
+        return;
+    }
+
+    m_path = path;
+    m_platform = platform;
+    m_versionTag = versionTag;
+    m_fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (m_fd == -1) {
+        DEBUG_WRITE("Cannot open code cache bundle %s: %s", path.c_str(), strerror(errno));
+        return;
+    }
+
+    if (!MapIndex()) {
+        // missing, corrupted or created by another V8 version or with other flags, start over
+        ftruncate(m_fd, 0);
+        m_fileSize = AlignToPage(sizeof(Header));
+        return;
+    }
+
+    uint64_t liveSize = 0;
+    for (uint32_t i = 0; i < m_tableCapacity; i++) {
+        liveSize += AlignToPage(m_table[i].dataLength);
+    }
+
+    // the caches of modules which have changed and the indices written by previous flushes are garbage
+    if (m_fileSize > 2 * liveSize + COMPACTION_THRESHOLD) {
+        unordered_map<string, Entry> entries;
+        CollectEntries(entries);
+        Compact(entries);
+    }
+}
+
+bool CodeCacheBundle::MapIndex() {
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < sizeof(Header)) {
+        return false;
+    }
+
+    Header header;
+    if (!File::ReadAt(m_fd, &header, sizeof(Header), 0)) {
+        return false;
+    }
+
+    if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION || header.checksum != HeaderChecksum(header)) {
+        return false;
+    }
+
+    if (header.versionTag != m_versionTag) {
+        DEBUG_WRITE("The code caches were created by another V8 version or with other flags, discarding them");
+        return false;
+    }
+
+    uint64_t tableSize = static_cast<uint64_t>(header.tableCapacity) * sizeof(IndexEntry);
+    if (header.indexSize < tableSize || header.indexOffset + header.indexSize > static_cast<uint64_t>(st.st_size)) {
+        return false;
+    }
+
+    // everything past the index belongs to an interrupted flush
+    auto size = static_cast<size_t>(header.indexOffset + header.indexSize);
+    auto mapping = MemoryMappedFile::Open(m_fd, size);
+    if (mapping.memory == nullptr) {
+        return false;
+    }
+
+    auto index = static_cast<const uint8_t*>(mapping.memory) + header.indexOffset;
+
+    uint64_t indexChecksum = XxHash::Hash64(index + tableSize, header.indexSize - tableSize, XxHash::Hash64(index, tableSize));
+    if (indexChecksum != header.indexChecksum) {
+        return false;
+    }
+
+    m_mapping = move(mapping);
+    m_table = reinterpret_cast<const IndexEntry*>(index);
+    m_tableCapacity = header.tableCapacity;
+    m_paths = reinterpret_cast<const char*>(index + tableSize);
+    m_pathsSize = header.indexSize - tableSize;
+    m_fileSize = size;
+
+    return true;
+}
+
+const CodeCacheBundle::IndexEntry* CodeCacheBundle::FindMapped(const string& modulePath) const {
+    if (m_tableCapacity == 0) {
+        return nullptr;
+    }
+
+    auto pathHash = Hash(modulePath.data(), modulePath.size());
+    auto mask = m_tableCapacity - 1;
+
+    for (uint32_t i = 0; i < m_tableCapacity; i++) {
+        const IndexEntry& entry = m_table[(pathHash + i) & mask];
+        if (entry.pathLength == 0) {
+            return nullptr;
+        }
+
+        if (entry.pathHash == pathHash && entry.pathLength == modulePath.size()
+                && static_cast<uint64_t>(entry.pathOffset) + entry.pathLength <= m_pathsSize
+                && memcmp(m_paths + entry.pathOffset, modulePath.data(), entry.pathLength) == 0) {
+            return &entry;
+        }
+    }
+
+    return nullptr;
+}
+
+const CodeCacheBundle::PendingCache* CodeCacheBundle::FindPending(const string& modulePath) const {
+    // the latest cache of the module, if it was added more than once
+    for (auto it = m_pending.rbegin(); it != m_pending.rend(); ++it) {
+        if (it->modulePath == modulePath) {
+            return &*it;
+        }
+    }
+
+    return nullptr;
+}
+
+ScriptCompiler::CachedData* CodeCacheBundle::Get(const string& modulePath, uint64_t sourceHash, CacheKind& kind) {
+    lock_guard<mutex> lock(m_mutex);
+
+    // a worker may need a module compiled after the bundle was mapped, possibly not written yet
+    auto pending = FindPending(modulePath);
+    if (pending != nullptr) {
+        if (pending->sourceHash != sourceHash) {
+            return nullptr;
+        }
+
+        kind = pending->kind;
+        auto length = pending->cachedData->length;
+        auto data = new uint8_t[length];
+        memcpy(data, pending->cachedData->data, length);
+
+        return new ScriptCompiler::CachedData(data, length, ScriptCompiler::CachedData::BufferOwned);
+    }
+
+    auto it = m_added.find(modulePath);
+    if (it != m_added.end()) {
+        const Entry& added = it->second;
+        if (added.sourceHash != sourceHash) {
+            return nullptr;
+        }
+
+        auto data = new uint8_t[added.dataLength];
+        if (!File::ReadAt(m_fd, data, added.dataLength, added.dataOffset)) {
+            delete[] data;
+            return nullptr;
+        }
+
+        kind = added.kind;
+
+        return new ScriptCompiler::CachedData(data, added.dataLength, ScriptCompiler::CachedData::BufferOwned);
+    }
+
+    auto entry = FindMapped(modulePath);
+    if (entry == nullptr || entry->sourceHash != sourceHash || entry->dataOffset + entry->dataLength > m_mapping.size) {
+        return nullptr;
+    }
+
+    kind = static_cast<CacheKind>(entry->kind);
+
+    // the mapping is never released, so the cache can be consumed in place
+    return new ScriptCompiler::CachedData(MappedBytes() + entry->dataOffset, entry->dataLength, ScriptCompiler::CachedData::BufferNotOwned);
+}
+
+bool CodeCacheBundle::Contains(const string& modulePath, uint64_t sourceHash) {
+    lock_guard<mutex> lock(m_mutex);
+
+    auto pending = FindPending(modulePath);
+    if (pending != nullptr) {
+        return pending->sourceHash == sourceHash;
+    }
+
+    auto it = m_added.find(modulePath);
+    if (it != m_added.end()) {
+        return it->second.sourceHash == sourceHash;
+    }
+
+    auto entry = FindMapped(modulePath);
+    return entry != nullptr && entry->sourceHash == sourceHash;
+}
+
+void CodeCacheBundle::Prefetch(const vector<string>& modulePaths) {
+    lock_guard<mutex> lock(m_mutex);
+
+    for (const auto& modulePath : modulePaths) {
+        auto entry = FindMapped(modulePath);
+        if (entry == nullptr || entry->dataOffset + entry->dataLength > m_mapping.size) {
+            continue;
+        }
+
+        m_mapping.Advise(entry->dataOffset, entry->dataLength, FileAccess::WillNeed);
+    }
+}
+
+void CodeCacheBundle::Put(const string& modulePath, uint64_t sourceHash, CacheKind kind, unique_ptr<ScriptCompiler::CachedData> cachedData) {
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_fd == -1 || cachedData == nullptr || cachedData->length <= 0) {
+        return;
+    }
+
+    PendingCache pending;
+    pending.modulePath = modulePath;
+    pending.sourceHash = sourceHash;
+    pending.kind = kind;
+    pending.cachedData = move(cachedData);
+    m_pending.push_back(move(pending));
+
+    ScheduleWrite();
+}
+
+void CodeCacheBundle::Flush() {
+    lock_guard<mutex> lock(m_mutex);
+
+    if (m_fd == -1 || (m_unflushedCount == 0 && m_pending.empty())) {
+        return;
+    }
+
+    m_isFlushRequested = true;
+    ScheduleWrite();
+}
+
+void CodeCacheBundle::ScheduleWrite() {
+    if (m_isWriteScheduled) {
+        return;
+    }
+
+    m_isWriteScheduled = true;
+    m_platform->CallOnWorkerThread(unique_ptr<Task>(new WriteTask(this)));
+}
+
+void CodeCacheBundle::WritePending() {
+    tns::instrumentation::Frame frame("CodeCacheBundle.WritePending");
+    unique_lock<mutex> lock(m_mutex);
+
+    while (!m_pending.empty() || (m_isFlushRequested && m_unflushedCount > 0)) {
+        if (!m_pending.empty()) {
+            // left in the queue while it is written, so that it can still be read
+            const PendingCache& pending = m_pending.front();
+            auto modulePath = pending.modulePath;
+            auto sourceHash = pending.sourceHash;
+            auto kind = pending.kind;
+            auto data = pending.cachedData->data;
+            auto length = pending.cachedData->length;
+            auto offset = AlignToPage(m_fileSize);
+
+            lock.unlock();
+            bool isWritten = File::WriteAt(m_fd, data, length, offset);
+            lock.lock();
+
+            if (isWritten) {
+                m_fileSize = offset + length;
+
+                Entry entry;
+                entry.sourceHash = sourceHash;
+                entry.dataOffset = offset;
+                entry.dataLength = static_cast<uint32_t>(length);
+                entry.kind = kind;
+                m_added[modulePath] = entry;
+                m_unflushedCount++;
+            } else {
+                DEBUG_WRITE("Cannot write the code cache of %s: %s", modulePath.c_str(), strerror(errno));
+            }
+
+            m_pending.pop_front();
+        }
+
+        if (m_pending.empty() && m_isFlushRequested) {
+            m_isFlushRequested = false;
+            FlushUnlocked(lock);
+        } else if (m_unflushedCount >= FLUSH_BATCH_SIZE) {
+            FlushUnlocked(lock);
+        }
+    }
+
+    m_isFlushRequested = false;
+    m_isWriteScheduled = false;
+}
+
+void CodeCacheBundle::FlushUnlocked(unique_lock<mutex>& lock) {
+    if (m_unflushedCount == 0) {
+        return;
+    }
+
+    unordered_map<string, Entry> entries;
+    CollectEntries(entries);
+
+    auto indexOffset = (m_fileSize + 7) & ~static_cast<uint64_t>(7);
+
+    lock.unlock();
+    auto indexSize = WriteIndex(m_fd, indexOffset, entries);
+    lock.lock();
+
+    if (indexSize == 0) {
+        DEBUG_WRITE("Cannot write the code cache index: %s", strerror(errno));
+        return;
+    }
+
+    m_fileSize = indexOffset + indexSize;
+    m_unflushedCount = 0;
+}
+
+void CodeCacheBundle::CollectEntries(unordered_map<string, Entry>& entries) const {
+    for (uint32_t i = 0; i < m_tableCapacity; i++) {
+        const IndexEntry& indexEntry = m_table[i];
+        if (indexEntry.pathLength == 0 || static_cast<uint64_t>(indexEntry.pathOffset) + indexEntry.pathLength > m_pathsSize) {
+            continue;
+        }
+
+        Entry entry;
+        entry.sourceHash = indexEntry.sourceHash;
+        entry.dataOffset = indexEntry.dataOffset;
+        entry.dataLength = indexEntry.dataLength;
+        entry.kind = static_cast<CacheKind>(indexEntry.kind);
+        entries[string(m_paths + indexEntry.pathOffset, indexEntry.pathLength)] = entry;
+    }
+
+    for (const auto& pair : m_added) {
+        entries[pair.first] = pair.second;
+    }
+}
+
+uint64_t CodeCacheBundle::WriteIndex(int fd, uint64_t offset, const unordered_map<string, Entry>& entries) {
+    uint32_t capacity = 16;
+    while (capacity < 2 * entries.size()) {
+        capacity *= 2;
+    }
+
+    vector<IndexEntry> table(capacity);
+    string paths;
+    auto mask = capacity - 1;
+
+    for (const auto& pair : entries) {
+        const string& path = pair.first;
+        auto pathHash = Hash(path.data(), path.size());
+
+        auto slot = pathHash & mask;
+        while (table[slot].pathLength != 0) {
+            slot = (slot + 1) & mask;
+        }
+
+        IndexEntry& entry = table[slot];
+        entry.pathHash = pathHash;
+        entry.sourceHash = pair.second.sourceHash;
+        entry.dataOffset = pair.second.dataOffset;
+        entry.dataLength = pair.second.dataLength;
+        entry.kind = static_cast<uint32_t>(pair.second.kind);
+        entry.pathOffset = static_cast<uint32_t>(paths.size());
+        entry.pathLength = static_cast<uint32_t>(path.size());
+        paths += path;
+    }
+
+    auto tableSize = capacity * sizeof(IndexEntry);
+    uint64_t indexSize = tableSize + paths.size();
+
+    Header header;
+    memset(&header, 0, sizeof(Header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.tableCapacity = capacity;
+    header.indexOffset = offset;
+    header.indexSize = indexSize;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.versionTag = m_versionTag;
+    header.indexChecksum = XxHash::Hash64(paths.data(), paths.size(), XxHash::Hash64(table.data(), tableSize));
+    header.checksum = HeaderChecksum(header);
+
+    // the new index has to be on disk before the header refers to it
+    if (!File::WriteAt(fd, table.data(), tableSize, offset) || !File::WriteAt(fd, paths.data(), paths.size(), offset + tableSize)
+            || fdatasync(fd) != 0 || !File::WriteAt(fd, &header, sizeof(Header), 0)) {
+        return 0;
+    }
+
+    return indexSize;
+}
+
+bool CodeCacheBundle::Compact(const unordered_map<string, Entry>& entries) {
+    auto tmpPath = m_path + ".tmp";
+    int fd = open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return false;
+    }
+
+    unordered_map<string, Entry> compacted;
+    uint64_t fileSize = AlignToPage(sizeof(Header));
+    bool success = true;
+
+    for (const auto& pair : entries) {
+        const Entry& entry = pair.second;
+        if (entry.dataOffset + entry.dataLength > m_mapping.size) {
+            continue;
+        }
+
+        auto offset = AlignToPage(fileSize);
+        if (!File::WriteAt(fd, MappedBytes() + entry.dataOffset, entry.dataLength, offset)) {
+            success = false;
+            break;
+        }
+
+        Entry moved = entry;
+        moved.dataOffset = offset;
+        compacted[pair.first] = moved;
+        fileSize = offset + entry.dataLength;
+    }
+
+    auto indexOffset = (fileSize + 7) & ~static_cast<uint64_t>(7);
+    success = success && WriteIndex(fd, indexOffset, compacted) != 0 && fdatasync(fd) == 0;
+
+    if (!success || rename(tmpPath.c_str(), m_path.c_str()) != 0) {
+        close(fd);
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    m_mapping = MemoryMappedFile();
+    close(m_fd);
+
+    m_fd = fd;
+    m_table = nullptr;
+    m_tableCapacity = 0;
+
+    if (!MapIndex()) {
+        ftruncate(m_fd, 0);
+        m_fileSize = AlignToPage(sizeof(Header));
+    }
+
+    return true;
+}
@@ -0,0 +1,209 @@
+#ifndef CODECACHEBUNDLE_H_
+#define CODECACHEBUNDLE_H_
+
+#include "v8.h"
+#include "v8-platform.h"
+#include "File.h"
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tns {
+/*
+ * Keeps the V8 code caches of all modules in a single file, shared by all isolates of the process.
+ *
+ * The file starts with a header pointing to an index: an open addressing hash table keyed by
+ * the module path, followed by the module paths. Each entry holds the hash of the module source
+ * the cache was created from and the location of the cache, which starts at a page boundary.
+ * The file is mapped once and the caches are handed to V8 without copying.
+ *
+ * A module has the cache of a function, when it was compiled with CompileFunctionInContext, or
+ * the cache of the wrapped script, when it was streamed by BackgroundCompiler. V8 rejects the
+ * one in place of the other, so the entries record the kind of their cache.
+ *
+ * The header also holds the tag of the V8 version and flags the caches were created with. V8
+ * rejects a cache of another version or with other flags only after reading it, so a bundle
+ * with another tag is discarded as a whole when opened. The caches are keyed by the content of
+ * the modules rather than by their modification times, which the updates of the application reset.
+ *
+ * New caches are appended to the end of the file, on a V8 worker thread, and a new index is
+ * written after them. Only then the header is updated to point to the new index, so an
+ * interrupted write leaves the previous index in effect. When most of the file is taken by
+ * caches which are no longer referenced, the bundle is rewritten to a temporary file which
+ * replaces it.
+ */
+class CodeCacheBundle {
+    public:
+        enum class CacheKind : uint32_t {
+            Function,
+            Script
+        };
+
+        static CodeCacheBundle* GetInstance();
+
+        /*
+         * Maps the bundle at the given path, discarding its caches unless they were created with the
+         * given ScriptCompiler::CachedDataVersionTag. The caches are written on the worker threads of
+         * the platform. Does nothing if a bundle is already open.
+         */
+        void Open(const std::string& path, uint32_t versionTag, v8::Platform* platform);
+
+        /*
+         * Returns a view of the cache created from the given module source, along with its kind, or nullptr if there is none.
+         */
+        v8::ScriptCompiler::CachedData* Get(const std::string& modulePath, uint64_t sourceHash, CacheKind& kind);
+
+        bool Contains(const std::string& modulePath, uint64_t sourceHash);
+
+        /*
+         * Advises the kernel that the caches of the given modules will be needed soon.
+         */
+        void Prefetch(const std::vector<std::string>& modulePaths);
+
+        /*
+         * Adds the cache of a module, which is written in the background. The index is updated in
+         * batches, or when Flush is called.
+         */
+        void Put(const std::string& modulePath, uint64_t sourceHash, CacheKind kind, std::unique_ptr<v8::ScriptCompiler::CachedData> cachedData);
+
+        /*
+         * Writes the index of the caches added since the last flush, in the background.
+         */
+        void Flush();
+
+        /*
+         * The hash of the module sources, an XXH64.
+         */
+        static uint64_t Hash(const char* data, size_t length);
+
+    private:
+        CodeCacheBundle();
+
+        struct Header {
+            char magic[8];
+            uint32_t version;
+            uint32_t tableCapacity;
+            uint64_t indexOffset;
+            uint64_t indexSize;
+            uint32_t entryCount;
+            uint32_t versionTag;
+            uint64_t indexChecksum;
+            uint64_t checksum;
+        };
+
+        struct IndexEntry {
+            uint64_t pathHash;
+            uint64_t sourceHash;
+            uint64_t dataOffset;
+            uint32_t dataLength;
+            uint32_t pathOffset;
+            uint32_t pathLength;
+            uint32_t kind;
+        };
+
+        struct Entry {
+            uint64_t sourceHash;
+            uint64_t dataOffset;
+            uint32_t dataLength;
+            CacheKind kind;
+        };
+
+        struct PendingCache {
+            std::string modulePath;
+            uint64_t sourceHash;
+            CacheKind kind;
+            std::unique_ptr<v8::ScriptCompiler::CachedData> cachedData;
+        };
+
+        class WriteTask;
+
+        const IndexEntry* FindMapped(const std::string& modulePath) const;
+
+        bool MapIndex();
+
+        const PendingCache* FindPending(const std::string& modulePath) const;
+
+        void CollectEntries(std::unordered_map<std::string, Entry>& entries) const;
+
+        /*
+         * Posts the task writing the pending caches, unless it is already running. Called with the mutex held.
+         */
+        void ScheduleWrite();
+
+        /*
+         * Writes the pending caches and the index, on a worker thread.
+         */
+        void WritePending();
+
+        /*
+         * Writes the index with the mutex released, as it waits for the caches to reach the disk.
+         */
+        void FlushUnlocked(std::unique_lock<std::mutex>& lock);
+
+        /*
+         * Writes the index and then the header referring to it. Returns the size of the index, or 0 on failure.
+         */
+        uint64_t WriteIndex(int fd, uint64_t offset, const std::unordered_map<std::string, Entry>& entries);
+
+        bool Compact(const std::unordered_map<std::string, Entry>& entries);
+
+        static uint64_t HeaderChecksum(const Header& header);
+
+        static uint64_t AlignToPage(uint64_t offset);
+
+        const uint8_t* MappedBytes() const;
+
+        std::mutex m_mutex;
+
+        std::string m_path;
+
+        v8::Platform* m_platform;
+
+        int m_fd;
+
+        uint64_t m_fileSize;
+
+        MemoryMappedFile m_mapping;
+
+        const IndexEntry* m_table;
+
+        uint32_t m_tableCapacity;
+
+        const char* m_paths;
+
+        uint64_t m_pathsSize;
+
+        uint32_t m_versionTag;
+
+        // the caches appended since the bundle was mapped
+        std::unordered_map<std::string, Entry> m_added;
+
+        // the caches not written yet, in the order they were added
+        std::deque<PendingCache> m_pending;
+
+        // only the write task appends to the file after it is opened
+        bool m_isWriteScheduled;
+
+        bool m_isFlushRequested;
+
+        int m_unflushedCount;
+
+        static const int FLUSH_BATCH_SIZE = 64;
+
+        static const uint64_t COMPACTION_THRESHOLD = 4 * 1024 * 1024;
+
+        // 2: the modules are compiled as functions, their caches differ from the caches of the wrapped scripts
+        // 3: the XXH64 source hashes and the V8 version tag
+        // 4: the kind of the caches, the caches of the streamed modules were taken for function caches
+        static const uint32_t VERSION = 4;
+
+        static const char MAGIC[8];
+};
+}
+
+#endif /* CODECACHEBUNDLE_H_ */
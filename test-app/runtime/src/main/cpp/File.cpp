@@ -6,52 +6,74 @@
  */
 
 #include "File.h"
+#include "ApkFileSystem.h"
 #include <sstream>
 #include <fstream>
+#include <cerrno>
+#include <fcntl.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <assert.h>
 
 using namespace std;
 
 namespace tns {
-bool File::Exists(const string& path) {
-    std::ifstream infile(path.c_str());
-    return infile.good();
-}
-string File::ReadText(const string& filePath) {
-    int len;
-    bool isNew;
-    const char* content = ReadText(filePath, len, isNew);
+namespace {
+struct ScratchBuffer {
+    vector<char> data;
+    bool isInUse = false;
+};
 
-    string s(content, len);
+thread_local ScratchBuffer scratchBuffer;
 
-    if (isNew) {
-        delete[] content;
-    }
+// the memory kept by the scratch buffer of a thread between the reads
+const size_t MAX_RETAINED_SCRATCH_SIZE = 1024 * 1024;
 
-    return s;
+int ToMadvise(FileAccess access) {
+    switch (access) {
+    case FileAccess::Sequential:
+        return MADV_SEQUENTIAL;
+    case FileAccess::Random:
+        return MADV_RANDOM;
+    case FileAccess::WillNeed:
+        return MADV_WILLNEED;
+    default:
+        return MADV_NORMAL;
+    }
 }
 
-void* File::ReadBinary(const string& filePath, int& length) {
-    length = 0;
-    if (!File::Exists(filePath)) {
-        return nullptr;
+int ToFadvise(FileAccess access) {
+    switch (access) {
+    case FileAccess::Sequential:
+        return POSIX_FADV_SEQUENTIAL;
+    case FileAccess::Random:
+        return POSIX_FADV_RANDOM;
+    case FileAccess::WillNeed:
+        return POSIX_FADV_WILLNEED;
+    default:
+        return POSIX_FADV_NORMAL;
     }
+}
+}
 
-    auto file = fopen(filePath.c_str(), READ_BINARY);
-    if (!file) {
-        return nullptr;
+bool File::Exists(const string& path) {
+    if (ApkFileSystem::IsMounted(path)) {
+        bool isDirectory;
+        return ApkFileSystem::GetEntryKind(path, isDirectory);
     }
 
-    fseek(file, 0, SEEK_END);
-    length = ftell(file);
-    rewind(file);
+    std::ifstream infile(path.c_str());
+    return infile.good();
+}
 
-    uint8_t* data = new uint8_t[length];
-    fread(data, sizeof(uint8_t), length, file);
-    fclose(file);
+string File::ReadText(const string& filePath) {
+    MappedFile file(filePath, FileAccess::Sequential);
+    if (!file.IsOpen()) {
+        return string();
+    }
 
-    return data;
+    return string(file.Data(), file.Size());
 }
 
 bool File::WriteBinary(const string& filePath, const void* data, int length) {
@@ -66,45 +88,64 @@ bool File::WriteBinary(const string& filePath, const void* data, int length) {
     return writtenBytes == length;
 }
 
-const char* File::ReadText(const string& filePath, int& charLength, bool& isNew) {
-    FILE* file = fopen(filePath.c_str(), "rb");
-    fseek(file, 0, SEEK_END);
-
-    charLength = ftell(file);
-    isNew = charLength > BUFFER_SIZE;
-
-    rewind(file);
+bool File::ReadAt(int fd, void* data, size_t length, uint64_t offset) {
+    auto bytes = static_cast<uint8_t*>(data);
+    while (length > 0) {
+        auto read = pread(fd, bytes, length, offset);
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read <= 0) {
+            return false;
+        }
+        bytes += read;
+        length -= read;
+        offset += read;
+    }
+    return true;
+}
 
-    if (isNew) {
-        char* newBuffer = new char[charLength];
-        fread(newBuffer, 1, charLength, file);
-        fclose(file);
+bool File::WriteAt(int fd, const void* data, size_t length, uint64_t offset) {
+    auto bytes = static_cast<const uint8_t*>(data);
+    while (length > 0) {
+        auto written = pwrite(fd, bytes, length, offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        bytes += written;
+        length -= written;
+        offset += written;
+    }
+    return true;
+}
 
-        return newBuffer;
+MemoryMappedFile MemoryMappedFile::Open(const char* filePath) {
+    int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return MemoryMappedFile();
     }
 
-    fread(Buffer, 1, charLength, file);
-    fclose(file);
+    struct stat st;
+    auto file = (fstat(fd, &st) == 0) ? Open(fd, st.st_size) : MemoryMappedFile();
+    close(fd);
 
-    return Buffer;
+    return file;
 }
 
-MemoryMappedFile MemoryMappedFile::Open(const char* filePath) {
-    void* memory = nullptr;
-    int length = 0;
-    if (FILE* file = fopen(filePath, "r+")) {
-        if (fseek(file, 0, SEEK_END) == 0) {
-            length = ftell(file);
-            if (length >= 0) {
-                memory = mmap(NULL, length, PROT_READ, MAP_SHARED, fileno(file), 0);
-                if (memory == MAP_FAILED) {
-                    memory = nullptr;
-                }
-            }
-        }
-        fclose(file);
+MemoryMappedFile MemoryMappedFile::Open(int fd, size_t size) {
+    if (size == 0) {
+        return MemoryMappedFile();
+    }
+
+    void* memory = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (memory == MAP_FAILED) {
+        return MemoryMappedFile();
     }
-    return MemoryMappedFile(memory, length);
+
+    return MemoryMappedFile(memory, size);
 }
 
 MemoryMappedFile::MemoryMappedFile(void* memory, size_t size)
@@ -112,13 +153,169 @@ MemoryMappedFile::MemoryMappedFile(void* memory, size_t size)
     memory(memory), size(size) {
 }
 
+MemoryMappedFile::MemoryMappedFile(MemoryMappedFile&& other)
+    :
+    memory(other.memory), size(other.size) {
+    other.memory = nullptr;
+    other.size = 0;
+}
+
+MemoryMappedFile& MemoryMappedFile::operator=(MemoryMappedFile&& other) {
+    if (this != &other) {
+        if (memory != nullptr) {
+            munmap(memory, size);
+        }
+        memory = other.memory;
+        size = other.size;
+        other.memory = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
 MemoryMappedFile::~MemoryMappedFile() {
-    int result = munmap(this->memory, this->size);
-    assert(result == 0);
+    if (this->memory != nullptr) {
+        int result = munmap(this->memory, this->size);
+        assert(result == 0);
+    }
 }
 
-char* File::Buffer = new char[BUFFER_SIZE];
+void MemoryMappedFile::Advise(size_t offset, size_t length, FileAccess access) const {
+    if (this->memory == nullptr || offset >= this->size) {
+        return;
+    }
+
+    static const size_t pageMask = ~(static_cast<size_t>(sysconf(_SC_PAGESIZE)) - 1);
+
+    auto start = offset & pageMask;
+    auto end = min(offset + length, this->size);
+    madvise(static_cast<char*>(this->memory) + start, end - start, ToMadvise(access));
+}
+
+MappedFile::MappedFile(const string& filePath, FileAccess access)
+    :
+    m_data(nullptr), m_size(0), m_isOpen(false), m_usesScratchBuffer(false) {
+    Open(filePath, nullptr, access);
+}
+
+MappedFile::MappedFile(const string& filePath, vector<char>& buffer, FileAccess access)
+    :
+    m_data(nullptr), m_size(0), m_isOpen(false), m_usesScratchBuffer(false) {
+    Open(filePath, &buffer, access);
+}
+
+MappedFile::~MappedFile() {
+    if (m_usesScratchBuffer) {
+        scratchBuffer.isInUse = false;
+        if (scratchBuffer.data.capacity() > MAX_RETAINED_SCRATCH_SIZE) {
+            vector<char>().swap(scratchBuffer.data);
+        }
+    }
+}
+
+void MappedFile::Open(const string& filePath, vector<char>* buffer, FileAccess access) {
+    if (ApkFileSystem::IsMounted(filePath)) {
+        OpenFromApk(filePath, buffer, access);
+        return;
+    }
+
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return;
+    }
+
+    auto size = static_cast<size_t>(st.st_size);
+
+#ifndef APPLICATION_IN_DEBUG
+    // the files of a debug application are rewritten in place by livesync, so they are only read there
+    if (size >= MAP_THRESHOLD) {
+        m_mapping = MemoryMappedFile::Open(fd, size);
+        if (m_mapping.memory != nullptr) {
+            m_mapping.Advise(0, size, access);
+            close(fd);
+
+            m_data = static_cast<const char*>(m_mapping.memory);
+            m_size = size;
+            m_isOpen = true;
+            return;
+        }
+    }
+#endif
+
+    if (access != FileAccess::Normal) {
+        posix_fadvise(fd, 0, 0, ToFadvise(access));
+    }
+
+    buffer = SelectBuffer(buffer);
+    buffer->resize(size);
+    m_isOpen = File::ReadAt(fd, buffer->data(), size, 0);
+    close(fd);
+
+    m_data = (size > 0) ? buffer->data() : "";
+    m_size = size;
+}
+
+void MappedFile::OpenFromApk(const string& filePath, vector<char>* buffer, FileAccess access) {
+    // the mounted folders are not looked up on the disk, where an extracted copy may be stale
+    ApkFileSystem::Entry entry;
+    if (!ApkFileSystem::FindFile(filePath, entry)) {
+        return;
+    }
+
+    auto size = static_cast<size_t>(entry.size);
+
+    // the package is not rewritten by livesync, so its stored entries are mapped in debug as well
+    if (entry.method == ApkFileSystem::METHOD_STORED && size >= MAP_THRESHOLD) {
+        if (ApkFileSystem::MapEntry(entry, m_mapping, m_data, access)) {
+            m_size = size;
+            m_isOpen = true;
+            return;
+        }
+    }
+
+    buffer = SelectBuffer(buffer);
+    buffer->resize(size);
+    m_isOpen = ApkFileSystem::ReadEntry(entry, buffer->data());
+
+    m_data = (size > 0) ? buffer->data() : "";
+    m_size = size;
+}
+
+vector<char>* MappedFile::SelectBuffer(vector<char>* buffer) {
+    if (buffer != nullptr) {
+        return buffer;
+    }
+
+    if (scratchBuffer.isInUse) {
+        return &m_ownBuffer;
+    }
+
+    scratchBuffer.isInUse = true;
+    m_usesScratchBuffer = true;
+    return &scratchBuffer.data;
+}
+
+bool MappedFile::IsOpen() const {
+    return m_isOpen;
+}
+
+const char* MappedFile::Data() const {
+    return m_data;
+}
+
+size_t MappedFile::Size() const {
+    return m_size;
+}
+
+bool MappedFile::IsMapped() const {
+    return m_mapping.memory != nullptr;
+}
 
 const char* File::WRITE_BINARY = "wb";
-const char* File::READ_BINARY = "rb";
 }
@@ -8,30 +8,99 @@
 #ifndef JNI_FILE_H_
 #define JNI_FILE_H_
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace tns {
+/*
+ * How a file is about to be read, passed to posix_fadvise and madvise.
+ */
+enum class FileAccess {
+    Normal,
+    Sequential,
+    Random,
+    WillNeed
+};
+
 struct MemoryMappedFile final {
     static MemoryMappedFile Open(const char* filePath);
+    /*
+     * Maps the first size bytes of a file opened for reading, the descriptor stays owned by the caller.
+     */
+    static MemoryMappedFile Open(int fd, size_t size);
+    MemoryMappedFile() = default;
     MemoryMappedFile(void* memory, size_t size);
+    MemoryMappedFile(MemoryMappedFile&& other);
+    MemoryMappedFile& operator=(MemoryMappedFile&& other);
+    MemoryMappedFile(const MemoryMappedFile&) = delete;
+    MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
     ~MemoryMappedFile();
 
+    void Advise(size_t offset, size_t length, FileAccess access) const;
+
     void* memory = nullptr;
     size_t size = 0;
 };
 
+/*
+ * A read-only view of the content of a file, which may be used on any thread.
+ *
+ * The files of MAP_THRESHOLD bytes or more are mapped. The smaller ones are read with pread into
+ * the buffer given by the caller or, by default, into a scratch buffer reused by the reads of the
+ * thread. The paths in the folders mounted by ApkFileSystem are read from the application package
+ * the same way, except for its compressed entries, which are inflated into the buffer. The content is valid as long as the MappedFile, and the buffer of the caller if given.
+ * A MappedFile reading into the scratch buffer is destroyed on the thread which created it.
+ */
+class MappedFile final {
+    public:
+        explicit MappedFile(const std::string& filePath, FileAccess access = FileAccess::Normal);
+        MappedFile(const std::string& filePath, std::vector<char>& buffer, FileAccess access = FileAccess::Normal);
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile();
+
+        /*
+         * Returns false if the file is missing or is not a regular file, or if it cannot be read.
+         */
+        bool IsOpen() const;
+        const char* Data() const;
+        size_t Size() const;
+        bool IsMapped() const;
+
+        static const size_t MAP_THRESHOLD = 64 * 1024;
+
+    private:
+        void Open(const std::string& filePath, std::vector<char>* buffer, FileAccess access);
+
+        void OpenFromApk(const std::string& filePath, std::vector<char>* buffer, FileAccess access);
+
+        /*
+         * Returns the buffer of the caller if given, otherwise the scratch buffer of the thread, or the own buffer if it is in use.
+         */
+        std::vector<char>* SelectBuffer(std::vector<char>* buffer);
+
+        MemoryMappedFile m_mapping;
+        const char* m_data;
+        size_t m_size;
+        bool m_isOpen;
+        bool m_usesScratchBuffer;
+        // used when a MappedFile alive on the same thread holds the scratch buffer
+        std::vector<char> m_ownBuffer;
+};
+
 class File {
     public:
-        static const char* ReadText(const std::string& filePath, int& length, bool& isNew);
         static std::string ReadText(const std::string& filePath);
         static bool Exists(const std::string& filePath);
         static bool WriteBinary(const std::string& filePath, const void* inData, int length);
-        static void* ReadBinary(const std::string& filePath, int& length);
+        /*
+         * Read and write the whole range at the offset with pread and pwrite, retrying the partial transfers.
+         */
+        static bool ReadAt(int fd, void* data, size_t length, uint64_t offset);
+        static bool WriteAt(int fd, const void* data, size_t length, uint64_t offset);
     private:
-        static const int BUFFER_SIZE = 1024 * 1024;
-        static char* Buffer;
         static const char* WRITE_BINARY;
-        static const char* READ_BINARY;
 };
 }
 
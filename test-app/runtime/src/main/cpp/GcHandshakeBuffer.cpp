@@ -0,0 +1,83 @@
+#include "GcHandshakeBuffer.h"
+#include "JniLocalRef.h"
+#include <cstring>
+
+using namespace tns;
+
+GcHandshakeBuffer::GcHandshakeBuffer(uint32_t initialCapacity)
+    :
+    m_buff(nullptr), m_data(nullptr), m_stride(0), m_wordCount(0) {
+    Grow((initialCapacity + 31) / 32);
+}
+
+GcHandshakeBuffer::operator jobject() const {
+    return m_buff;
+}
+
+void GcHandshakeBuffer::Set(Bitmap bitmap, int javaObjectId) {
+    uint32_t word = static_cast<uint32_t>(javaObjectId) >> 5;
+    if (word >= m_stride) {
+        Grow(word + 1);
+    }
+    if (word >= m_wordCount) {
+        m_wordCount = word + 1;
+    }
+
+    m_data[static_cast<int>(bitmap) * m_stride + word] |= 1u << (javaObjectId & 31);
+}
+
+bool GcHandshakeBuffer::IsSet(Bitmap bitmap, int javaObjectId) const {
+    uint32_t word = static_cast<uint32_t>(javaObjectId) >> 5;
+    if (word >= m_wordCount) {
+        return false;
+    }
+
+    return (m_data[static_cast<int>(bitmap) * m_stride + word] & (1u << (javaObjectId & 31))) != 0;
+}
+
+int GcHandshakeBuffer::BitmapStride() const {
+    return m_stride;
+}
+
+int GcHandshakeBuffer::WordCount() const {
+    return m_wordCount;
+}
+
+void GcHandshakeBuffer::Reset() {
+    for (int i = 0; i < BITMAP_COUNT; i++) {
+        memset(m_data + i * m_stride, 0, m_wordCount * sizeof(uint32_t));
+    }
+    m_wordCount = 0;
+}
+
+void GcHandshakeBuffer::Grow(uint32_t minWords) {
+    uint32_t stride = (m_stride == 0) ? minWords : m_stride;
+    while (stride < minWords) {
+        stride *= 2;
+    }
+
+    auto data = new uint32_t[BITMAP_COUNT * stride]();
+    for (int i = 0; i < BITMAP_COUNT; i++) {
+        if (m_wordCount > 0) {
+            memcpy(data + i * stride, m_data + i * m_stride, m_wordCount * sizeof(uint32_t));
+        }
+    }
+
+    JEnv env;
+    if (m_buff != nullptr) {
+        env.DeleteGlobalRef(m_buff);
+    }
+    delete[] m_data;
+
+    m_data = data;
+    m_stride = stride;
+
+    JniLocalRef buff(env.NewDirectByteBuffer(m_data, BITMAP_COUNT * m_stride * sizeof(uint32_t)));
+    m_buff = env.NewGlobalRef(buff);
+}
+
+GcHandshakeBuffer::~GcHandshakeBuffer() {
+    JEnv env;
+    env.DeleteGlobalRef(m_buff);
+    delete[] m_data;
+}
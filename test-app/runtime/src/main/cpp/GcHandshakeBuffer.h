@@ -0,0 +1,63 @@
+#ifndef GCHANDSHAKEBUFFER_H_
+#define GCHANDSHAKEBUFFER_H_
+
+#include "JEnv.h"
+#include <cstdint>
+
+namespace tns {
+/*
+ * Bitmaps indexed by Java object id, shared with java/com/tns/Runtime through a direct ByteBuffer.
+ * The native side sets the bits in place, in native byte order, and Java processes all of them
+ * in a single processGcHandshake call at the end of a GC.
+ */
+class GcHandshakeBuffer {
+    public:
+        /*
+         * Keep in sync with the GC_HANDSHAKE_* constants in java/com/tns/Runtime.
+         */
+        enum class Bitmap {
+            // the Java object can be released
+            MakeWeak,
+            // the Java object is held with a weak reference
+            MakeWeakKeepAsWeak,
+            // Java clears the bits of the objects which are still alive
+            CheckAlive,
+            // like MakeWeakKeepAsWeak for the strong objects, then like CheckAlive for all of them
+            MakeWeakAndCheckAlive,
+            END
+        };
+
+        GcHandshakeBuffer(uint32_t initialCapacity = 65536);
+        ~GcHandshakeBuffer();
+
+        operator jobject() const;
+
+        void Set(Bitmap bitmap, int javaObjectId);
+
+        bool IsSet(Bitmap bitmap, int javaObjectId) const;
+
+        /*
+         * The number of 32-bit words reserved for each bitmap in the buffer.
+         */
+        int BitmapStride() const;
+
+        /*
+         * The number of 32-bit words of each bitmap which hold the bits set since the last Reset.
+         */
+        int WordCount() const;
+
+        void Reset();
+
+    private:
+        void Grow(uint32_t minWords);
+
+        jobject m_buff;
+        uint32_t* m_data;
+        uint32_t m_stride;
+        uint32_t m_wordCount;
+
+        static const int BITMAP_COUNT = static_cast<int>(Bitmap::END);
+};
+}
+
+#endif /* GCHANDSHAKEBUFFER_H_ */
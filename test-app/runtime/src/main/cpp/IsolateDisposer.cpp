@@ -5,6 +5,7 @@
 #include "IsolateDisposer.h"
 #include "ArgConverter.h"
 #include "MetadataNode.h"
+#include "NumericCasts.h"
 #include "V8GlobalHelpers.h"
 #include <console/Console.h>
 
@@ -13,6 +14,7 @@ namespace tns {
     void disposeIsolate(v8::Isolate *isolate) {
         tns::ArgConverter::onDisposeIsolate(isolate);
         tns::MetadataNode::onDisposeIsolate(isolate);
+        tns::NumericCasts::onDisposeIsolate(isolate);
         tns::V8GlobalHelpers::onDisposeIsolate(isolate);
         tns::Console::onDisposeIsolate(isolate);
     }
@@ -91,6 +91,28 @@ class LRUCache {
             }
         }
 
+        // Purge all elements
+        void clear() {
+            while (!m_key_tracker.empty()) {
+                evict();
+            }
+        }
+
+        // Purge the record for k, if any
+        void erase(const key_type& k) {
+            auto it = m_key_to_value.find(k);
+            if (it == m_key_to_value.end()) {
+                return;
+            }
+
+            if (m_evictCallback != nullptr) {
+                m_evictCallback((*it).second.first, m_state);
+            }
+
+            m_key_tracker.erase((*it).second.second);
+            m_key_to_value.erase(it);
+        }
+
         void update(const key_type& key, const value_type& value) {
             jweak ref = m_loadCallback(key, m_state);
             insert(key, ref);
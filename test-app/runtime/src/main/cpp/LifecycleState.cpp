@@ -0,0 +1,20 @@
+#include "LifecycleState.h"
+
+using namespace tns;
+
+LifecycleState::LifecycleState()
+    : m_isInBackground(false) {
+}
+
+LifecycleState::Change LifecycleState::SetInBackground(bool isInBackground) {
+    if (isInBackground == m_isInBackground) {
+        return Change::None;
+    }
+
+    m_isInBackground = isInBackground;
+    return isInBackground ? Change::ToBackground : Change::ToForeground;
+}
+
+bool LifecycleState::IsInBackground() const {
+    return m_isInBackground;
+}
@@ -0,0 +1,31 @@
+#ifndef LIFECYCLESTATE_H_
+#define LIFECYCLESTATE_H_
+
+namespace tns {
+/*
+ * Whether a runtime is in the foreground or in the background, as reported by the activity lifecycle.
+ * A runtime starts in the foreground, like V8 does. The memory pressure notifications never change the state.
+ */
+class LifecycleState {
+    public:
+        enum class Change {
+            None,
+            ToBackground,
+            ToForeground
+        };
+
+        LifecycleState();
+
+        /*
+         * Returns the V8 notification the new state calls for, if any.
+         */
+        Change SetInBackground(bool isInBackground);
+
+        bool IsInBackground() const;
+
+    private:
+        bool m_isInBackground;
+};
+}
+
+#endif /* LIFECYCLESTATE_H_ */
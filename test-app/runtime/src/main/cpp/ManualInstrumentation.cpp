@@ -5,4 +5,3 @@
 #include "ManualInstrumentation.h"
 
 bool tns::instrumentation::Frame::disabled = true;
-const std::chrono::system_clock::time_point tns::instrumentation::Frame::disabled_time = std::chrono::system_clock::time_point();
@@ -6,20 +6,24 @@
 #define MANUALINSTRUMENTATION_H
 
 #include "v8.h"
-#import <chrono>
 #import <NativeScriptAssert.h>
+#include "TraceRecorder.h"
 #include <string>
 
 namespace tns {
 namespace instrumentation {
+/*
+ * Logs the frames which take 16ms or more in the "timeline" profiling mode, and records every
+ * named or logged frame in the trace in the "trace" mode.
+ */
 class Frame {
     public:
         inline Frame() : Frame("") { }
-        inline Frame(std::string name) : name(name), start(disabled ? disabled_time : std::chrono::system_clock::now()) {}
+        inline Frame(std::string name) : name(name), start(isActive() ? TraceRecorder::Now() : 0) {}
 
         inline ~Frame() {
-            if (!name.empty() && check()) {
-                log(name);
+            if (!name.empty()) {
+                end(name, false);
             }
         }
 
@@ -27,20 +31,14 @@ class Frame {
             if (disabled) {
                 return false;
             }
-            std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::operator-(end, start)).count();
-            return duration >= 16000;
+            auto duration = TraceRecorder::Now() - start;
+            return duration >= 16000000;
         }
 
         inline void log(const char* message) {
-            if (disabled) {
-                return;
+            if (isActive()) {
+                end(message, true);
             }
-            std::chrono::system_clock::time_point end = std::chrono::system_clock::now();
-            auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::operator-(end, start)).count();
-            auto startMilis = std::chrono::time_point_cast<std::chrono::microseconds>(start).time_since_epoch().count() / 1000.0;
-            auto endMilis = std::chrono::time_point_cast<std::chrono::microseconds>(end).time_since_epoch().count() / 1000.0;
-            __android_log_print(ANDROID_LOG_DEBUG, "JS", "Timeline: %.3fms: Runtime: %s  (%.3fms - %.3fms)", duration / 1000.0, message, startMilis, endMilis);
         }
 
         inline void log(const std::string& message) {
@@ -56,11 +54,30 @@ class Frame {
 
     private:
         static bool disabled;
-        static const std::chrono::system_clock::time_point disabled_time; // Couldn't find reasonable constant
 
-        const std::chrono::system_clock::time_point start;
+        // in the nanoseconds of the monotonic clock
+        const int64_t start;
         const std::string name;
 
+        static inline bool isActive() {
+            return !disabled || TraceRecorder::IsEnabled();
+        }
+
+        inline void end(const std::string& message, bool isAlwaysLogged) {
+            // started before the profiling mode was set
+            if (start == 0) {
+                return;
+            }
+
+            auto end = TraceRecorder::Now();
+            TraceRecorder::AddComplete("runtime", message, start, end);
+
+            auto duration = end - start;
+            if (!disabled && (isAlwaysLogged || duration >= 16000000)) {
+                __android_log_print(ANDROID_LOG_DEBUG, "JS", "Timeline: %.3fms: Runtime: %s  (%.3fms - %.3fms)", duration / 1000000.0, message.c_str(), start / 1000000.0, end / 1000000.0);
+            }
+        }
+
         Frame(const Frame&) = delete;
         Frame& operator=(const Frame&) = delete;
 };
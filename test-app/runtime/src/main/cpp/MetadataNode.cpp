@@ -9,6 +9,9 @@
 #include "CallbackHandlers.h"
 #include "NativeScriptException.h"
 #include "Runtime.h"
+#include "RuntimeStats.h"
+#include "ApkFileSystem.h"
+#include "File.h"
 #include <sstream>
 #include <cctype>
 #include <dirent.h>
@@ -82,6 +85,7 @@ Local<Object> MetadataNode::CreateExtendedJSWrapper(Isolate* isolate, ObjectMana
         extInstance->Set(context, ArgConverter::ConvertToV8String(isolate, "constructor"), extdCtorFunc);
 
         SetInstanceMetadata(isolate, extInstance, cacheData.node);
+        RUNTIME_STATS_INCREMENT(isolate, JsWrappersCreated);
     }
 
     return extInstance;
@@ -188,6 +192,7 @@ Local<Object> MetadataNode::CreateJSWrapper(Isolate* isolate, ObjectManager* obj
             obj->Set(context, ArgConverter::ConvertToV8String(isolate, "constructor"), ctorFunc);
             obj->SetPrototype(context, ctorFunc->Get(context, V8StringConstants::GetPrototype(isolate)).ToLocalChecked());
             SetInstanceMetadata(isolate, obj, this);
+            RUNTIME_STATS_INCREMENT(isolate, JsWrappersCreated);
         }
     }
 
@@ -915,6 +920,7 @@ Local<FunctionTemplate> MetadataNode::GetConstructorFunctionTemplate(Isolate* is
         return ctorFuncTemplate;
     }
     //
+    RUNTIME_STATS_INCREMENT(isolate, ConstructorTemplatesCreated);
 
     auto node = GetOrCreateInternal(treeNode);
     auto ctorCallbackData = External::New(isolate, node);
@@ -1750,12 +1756,6 @@ bool MetadataNode::GetExtendLocation(v8::Isolate* isolate, string& extendLocatio
                 return false;
             }
 
-            // Account for the column length offset added by the addition of the Common JS function wrapper
-            // See issue https://github.com/NativeScript/android-runtime/issues/975
-            if (lineNumber == 1) {
-                column = column - ModuleInternal::MODULE_PROLOGUE_LENGTH;
-            }
-
             extendLocationStream << fullPathToFile.c_str() << "_" << lineNumber << "_" << column << "_";
         }
     }
@@ -1795,14 +1795,43 @@ MetadataEntry MetadataNode::GetChildMetadataForPackage(MetadataNode* node, const
     return child;
 }
 
-void MetadataNode::BuildMetadata(const string& filesPath) {
-    timeval time1;
-    gettimeofday(&time1, nullptr);
+char* MetadataNode::ReadMetadataFile(const string& filePath, const char* fileName, int extraSize, int& length) {
+    MappedFile file(filePath, FileAccess::Sequential);
+    if (!file.IsOpen()) {
+        stringstream ss;
+        ss << "metadata file (" << fileName << ") couldn't be opened! (Error: ";
+        ss << errno;
+        ss << ") ";
+        throw NativeScriptException(ss.str());
+    }
+
+    length = static_cast<int>(file.Size());
+    char* data = new char[length + extraSize];
+    memcpy(data, file.Data(), length);
 
+    return data;
+}
+
+void MetadataNode::StartBuildingMetadata(const string& filesPath) {
+    CheckMetadataFolder(filesPath);
+
+    s_metadataTask.Start("TNSMetadata", [filesPath]() {
+        BuildMetadata(filesPath);
+    });
+}
+
+void MetadataNode::WaitForMetadata() {
+    tns::instrumentation::Frame frame("WaitForMetadata");
+    s_metadataTask.Wait();
+}
+
+void MetadataNode::CheckMetadataFolder(const string& filesPath) {
     string baseDir = filesPath;
     baseDir.append("/metadata");
 
-    DIR* dir = opendir(baseDir.c_str());
+    // the metadata read from the application package is still behind the files directory when it is locked
+    bool isInApk = ApkFileSystem::IsMounted(baseDir);
+    DIR* dir = opendir(isInApk ? filesPath.c_str() : baseDir.c_str());
 
     if(dir == nullptr){
         stringstream ss;
@@ -1835,59 +1864,32 @@ void MetadataNode::BuildMetadata(const string& filesPath) {
           throw NativeScriptException(ss.str());
         }
     }
+    closedir(dir);
+}
+
+void MetadataNode::BuildMetadata(const string& filesPath) {
+    tns::instrumentation::Frame frame("BuildMetadata");
+    timeval time1;
+    gettimeofday(&time1, nullptr);
+
+    string baseDir = filesPath;
+    baseDir.append("/metadata");
 
     string nodesFile = baseDir + "/treeNodeStream.dat";
     string namesFile = baseDir + "/treeStringsStream.dat";
     string valuesFile = baseDir + "/treeValueStream.dat";
 
-    FILE* f = fopen(nodesFile.c_str(), "rb");
-    if (f == nullptr) {
-        stringstream ss;
-        ss << "metadata file (treeNodeStream.dat) couldn't be opened! (Error: ";
-        ss << errno;
-        ss << ") ";
-
-        throw NativeScriptException(ss.str());
-    }
-    fseek(f, 0, SEEK_END);
-    int lenNodes = ftell(f);
+    int lenNodes;
+    char* nodes = ReadMetadataFile(nodesFile, "treeNodeStream.dat", 0, lenNodes);
     assert((lenNodes % sizeof(MetadataTreeNodeRawData)) == 0);
-    char* nodes = new char[lenNodes];
-    rewind(f);
-    fread(nodes, 1, lenNodes, f);
-    fclose(f);
 
     const int _512KB = 524288;
 
-    f = fopen(namesFile.c_str(), "rb");
-    if (f == nullptr) {
-        stringstream ss;
-        ss << "metadata file (treeStringsStream.dat) couldn't be opened! (Error: ";
-        ss << errno;
-        ss << ") ";
-        throw NativeScriptException(ss.str());
-    }
-    fseek(f, 0, SEEK_END);
-    int lenNames = ftell(f);
-    char* names = new char[lenNames + _512KB];
-    rewind(f);
-    fread(names, 1, lenNames, f);
-    fclose(f);
+    int lenNames;
+    char* names = ReadMetadataFile(namesFile, "treeStringsStream.dat", _512KB, lenNames);
 
-    f = fopen(valuesFile.c_str(), "rb");
-    if (f == nullptr) {
-        stringstream ss;
-        ss << "metadata file (treeValueStream.dat) couldn't be opened! (Error: ";
-        ss << errno;
-        ss << ") ";
-        throw NativeScriptException(ss.str());
-    }
-    fseek(f, 0, SEEK_END);
-    int lenValues = ftell(f);
-    char* values = new char[lenValues + _512KB];
-    rewind(f);
-    fread(values, 1, lenValues, f);
-    fclose(f);
+    int lenValues;
+    char* values = ReadMetadataFile(valuesFile, "treeValueStream.dat", _512KB, lenValues);
 
     timeval time2;
     gettimeofday(&time2, nullptr);
@@ -2204,6 +2206,7 @@ void MetadataNode::onDisposeIsolate(Isolate* isolate) {
 
 string MetadataNode::TNS_PREFIX = "com/tns/gen/";
 MetadataReader MetadataNode::s_metadataReader;
+BackgroundTask MetadataNode::s_metadataTask;
 std::map<std::string, MetadataNode*> MetadataNode::s_name2NodeCache;
 std::map<std::string, MetadataTreeNode*> MetadataNode::s_name2TreeNodeCache;
 std::map<MetadataTreeNode*, MetadataNode*> MetadataNode::s_treeNode2NodeCache;
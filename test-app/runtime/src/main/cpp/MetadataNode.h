@@ -23,6 +23,7 @@
 #include "MetadataReader.h"
 #include "FieldCallbackData.h"
 #include "ArgsWrapper.h"
+#include "BackgroundTask.h"
 #include "ObjectManager.h"
 #include <string>
 #include <vector>
@@ -33,7 +34,16 @@ class MetadataNode {
     public:
         static void Init(v8::Isolate* isolate);
 
-        static void BuildMetadata(const std::string& filesPath);
+        /*
+         * Reads the metadata and builds its tree on a background thread, which does not need V8, so
+         * that it overlaps with the creation of the isolate. Exits if the metadata folder is locked.
+         */
+        static void StartBuildingMetadata(const std::string& filesPath);
+
+        /*
+         * Blocks until the metadata is built, rethrowing its error. Called before its first use.
+         */
+        static void WaitForMetadata();
 
         static void EnableProfiler(bool enableProfiler);
 
@@ -90,8 +100,17 @@ class MetadataNode {
         void SetStaticMembers(v8::Isolate* isolate, v8::Local<v8::Function>& ctorFunction, MetadataTreeNode* treeNode);
         void SetInnerTypes(v8::Isolate* isolate, v8::Local<v8::Function>& ctorFunction, MetadataTreeNode* treeNode);
 
+        static void CheckMetadataFolder(const std::string& filesPath);
+
+        static void BuildMetadata(const std::string& filesPath);
+
         static void BuildMetadata(uint32_t nodesLength, uint8_t* nodeData, uint32_t nameLength, uint8_t* nameData, uint32_t valueLength, uint8_t* valueData);
 
+        /*
+         * Reads a metadata file, from the disk or the application package, into a new buffer with extraSize spare bytes.
+         */
+        static char* ReadMetadataFile(const std::string& filePath, const char* fileName, int extraSize, int& length);
+
         static MetadataNodeCache* GetMetadataNodeCache(v8::Isolate* isolate);
 
         static MetadataNode* GetOrCreateInternal(MetadataTreeNode* treeNode);
@@ -155,6 +174,7 @@ class MetadataNode {
 
         static std::string TNS_PREFIX;
         static MetadataReader s_metadataReader;
+        static BackgroundTask s_metadataTask;
         static std::map<std::string, MetadataNode*> s_name2NodeCache;
         static std::map<std::string, MetadataTreeNode*> s_name2TreeNodeCache;
         static std::map<MetadataTreeNode*, MetadataNode*> s_treeNode2NodeCache;
@@ -16,20 +16,23 @@
 #include "SimpleProfiler.h"
 #include "include/v8.h"
 #include "CallbackHandlers.h"
+#include "CodeCacheBundle.h"
+#include "ModuleSource.h"
+#include "RuntimeStats.h"
 #include "ManualInstrumentation.h"
 #include "Runtime.h"
 #include <sstream>
+#include <cstring>
 #include <mutex>
 #include <libgen.h>
 #include <dlfcn.h>
-#include <sys/stat.h>
 
 using namespace v8;
 using namespace std;
 using namespace tns;
 
 ModuleInternal::ModuleInternal()
-    : m_isolate(nullptr), m_requireFunction(nullptr), m_requireFactoryFunction(nullptr) {
+    : m_isolate(nullptr), m_requireFunction(nullptr), m_requireFactoryFunction(nullptr), m_backgroundCompiler(MODULE_PROLOGUE, MODULE_EPILOGUE) {
 }
 
 ModuleInternal::~ModuleInternal() {
@@ -53,6 +56,8 @@ void ModuleInternal::Init(Isolate* isolate, const string& baseDir) {
     }
 
     m_isolate = isolate;
+    m_backgroundCompiler.Init(isolate);
+    m_resolver.Init(Constants::APP_ROOT_FOLDER_PATH);
 
     string requireFactoryScript =
         "(function () { "
@@ -198,6 +203,18 @@ void ModuleInternal::RequireNativeCallback(const v8::FunctionCallbackInfo<v8::Va
     funcPtr(args);
 }
 
+void ModuleInternal::StartPreloading(const string& manifestPath) {
+    m_preloader.Start(manifestPath, m_backgroundCompiler);
+}
+
+void ModuleInternal::FinishPreloading() {
+    m_preloader.Finish(m_backgroundCompiler);
+}
+
+void ModuleInternal::InvalidateResolvedPaths() {
+    m_resolver.Invalidate();
+}
+
 void ModuleInternal::Load(Local<Context> context, const string& path) {
     TNSPERF();
     auto isolate = m_isolate;
@@ -231,6 +248,27 @@ void ModuleInternal::CheckFileExists(Isolate* isolate, const std::string& path,
     env.CallStaticObjectMethod(MODULE_CLASS, RESOLVE_PATH_METHOD_ID, (jstring) jsModulename, (jstring) jsBaseDir);
 }
 
+string ModuleInternal::ResolvePath(const string& moduleName, const string& baseDir) {
+    string path;
+    string errorMessage;
+    auto resolution = m_resolver.Resolve(moduleName, baseDir, path, errorMessage);
+    if (resolution == ModuleResolver::Resolution::Found) {
+        return path;
+    }
+
+    if (resolution == ModuleResolver::Resolution::NotFound) {
+        // the same message as the Java exception Module.resolvePath throws converts to
+        throw NativeScriptException("com.tns.NativeScriptException: " + errorMessage);
+    }
+
+    JEnv env;
+    JniLocalRef jsModulename(env.NewStringUTF(moduleName.c_str()));
+    JniLocalRef jsBaseDir(env.NewStringUTF(baseDir.c_str()));
+    JniLocalRef jsModulePath(env.CallStaticObjectMethod(MODULE_CLASS, RESOLVE_PATH_METHOD_ID, (jstring) jsModulename, (jstring) jsBaseDir));
+
+    return ArgConverter::jstringToString((jstring) jsModulePath);
+}
+
 Local<Object> ModuleInternal::LoadImpl(Isolate* isolate, const string& moduleName, const string& baseDir, bool& isData) {
     auto pathKind = GetModulePathKind(moduleName);
     auto cachePathKey = (pathKind == ModulePathKind::Global) ? moduleName : (baseDir + "*" + moduleName);
@@ -242,12 +280,7 @@ Local<Object> ModuleInternal::LoadImpl(Isolate* isolate, const string& moduleNam
     auto it = m_loadedModules.find(cachePathKey);
 
     if (it == m_loadedModules.end()) {
-        JEnv env;
-        JniLocalRef jsModulename(env.NewStringUTF(moduleName.c_str()));
-        JniLocalRef jsBaseDir(env.NewStringUTF(baseDir.c_str()));
-        JniLocalRef jsModulePath(env.CallStaticObjectMethod(MODULE_CLASS, RESOLVE_PATH_METHOD_ID, (jstring) jsModulename, (jstring) jsBaseDir));
-
-        auto path = ArgConverter::jstringToString((jstring) jsModulePath);
+        auto path = ResolvePath(moduleName, baseDir);
 
         auto it2 = m_loadedModules.find(path);
 
@@ -295,14 +328,11 @@ Local<Object> ModuleInternal::LoadModule(Isolate* isolate, const string& moduleP
     TryCatch tc(isolate);
 
     Local<Function> moduleFunc;
+    uint64_t sourceHash = 0;
+    vector<string> dependencies;
 
     if (Util::EndsWith(modulePath, ".js")) {
-        auto script = LoadScript(isolate, modulePath, fullRequiredModulePath);
-
-        moduleFunc = script->Run(context).ToLocalChecked().As<Function>();
-        if (tc.HasCaught()) {
-            throw NativeScriptException(tc, "Error running script " + modulePath);
-        }
+        moduleFunc = LoadScript(isolate, modulePath, sourceHash, dependencies);
     } else if (Util::EndsWith(modulePath, ".so")) {
         auto handle = dlopen(modulePath.c_str(), RTLD_LAZY);
         if (handle == nullptr) {
@@ -336,7 +366,7 @@ Local<Object> ModuleInternal::LoadModule(Isolate* isolate, const string& moduleP
     auto dirName = ArgConverter::ConvertToV8String(isolate, strDirName);
     auto require = GetRequireFunction(isolate, strDirName);
     Local<Value> requireArgs[5] {
-        moduleObj, exportsObj, require, fileName, dirName
+        exportsObj, require, moduleObj, fileName, dirName
     };
 
     moduleObj->Set(context, ArgConverter::ConvertToV8String(isolate, "require"), require);
@@ -351,7 +381,13 @@ Local<Object> ModuleInternal::LoadModule(Isolate* isolate, const string& moduleP
     auto thiz = Object::New(isolate);
     auto extendsName = ArgConverter::ConvertToV8String(isolate, "__extends");
     thiz->Set(context, extendsName, context->Global()->Get(context, extendsName).ToLocalChecked());
+    m_preloader.OnModuleLoaded(modulePath, sourceHash, m_runningModules.empty() ? string() : m_runningModules.back(), m_backgroundCompiler);
+
+    m_runningModules.push_back(modulePath);
     moduleFunc->Call(context, thiz, sizeof(requireArgs) / sizeof(Local<Value> ), requireArgs);
+    m_runningModules.pop_back();
+
+    m_backgroundCompiler.Discard(dependencies);
 
     if (tc.HasCaught()) {
         throw NativeScriptException(tc, "Error calling module function ");
@@ -363,45 +399,176 @@ Local<Object> ModuleInternal::LoadModule(Isolate* isolate, const string& moduleP
     return result;
 }
 
-Local<Script> ModuleInternal::LoadScript(Isolate* isolate, const string& path, const Local<String>& fullRequiredModulePath) {
+Local<Function> ModuleInternal::LoadScript(Isolate* isolate, const string& path, uint64_t& sourceHash, vector<string>& dependencies) {
     string frameName("LoadScript " + path);
     tns::instrumentation::Frame frame(frameName.c_str());
-    Local<Script> script;
+    Local<Function> moduleFunc;
 
     TryCatch tc(isolate);
 
-    auto scriptText = ModuleInternal::WrapModuleContent(path);
+    auto context = isolate->GetCurrentContext();
+    auto fullRequiredModulePathWithSchema = ArgConverter::ConvertToV8String(isolate, "file://" + path);
+    unique_ptr<ModuleSource> source;
+
+    // the scripts compiled in the background are wrapped, the column offset hides the prologue
+    ScriptOrigin wrappedOrigin(fullRequiredModulePathWithSchema, Integer::New(isolate, 0), Integer::New(isolate, -MODULE_PROLOGUE_LENGTH));
+    Local<Script> script;
+
+    if (m_backgroundCompiler.Finish(context, path, wrappedOrigin, script, source)) {
+        if (script.IsEmpty() || tc.HasCaught()) {
+            throw NativeScriptException(tc, "Cannot compile " + path);
+        }
+        RUNTIME_STATS_INCREMENT(isolate, BackgroundCompilations);
+
+        sourceHash = source->GetHash();
+        CompileDependenciesInBackground(path, *source, dependencies);
+
+        auto maybeFunc = script->Run(context);
+        if (maybeFunc.IsEmpty() || tc.HasCaught()) {
+            throw NativeScriptException(tc, "Error running script " + path);
+        }
+
+        // V8 caches the streamed scripts as scripts, only CompileUnboundScript consumes them
+        auto unboundScript = script->GetUnboundScript();
+        SaveCodeCache(Constants::V8_CACHE_COMPILED_CODE ? ScriptCompiler::CreateCodeCache(unboundScript) : nullptr, path, sourceHash, CodeCacheBundle::CacheKind::Script);
+
+        return maybeFunc.ToLocalChecked().As<Function>();
+    }
+
+    auto runtime = Runtime::GetRuntime(isolate);
+    runtime->Lock();
+    source = ModuleSource::Open(path);
+    runtime->Unlock();
+
+    if (source == nullptr) {
+        throw NativeScriptException("Cannot read module " + path);
+    }
+
+    sourceHash = source->GetHash();
+    CompileDependenciesInBackground(path, *source, dependencies);
+
+    Local<String> scriptText;
+    if (!ModuleSource::ToV8String(isolate, move(source)).ToLocal(&scriptText)) {
+        throw NativeScriptException(tc, "Cannot read module " + path);
+    }
 
     DEBUG_WRITE("Compiling script (module %s)", path.c_str());
     //
-    auto cacheData = TryLoadScriptCache(path);
+    auto cacheKind = CodeCacheBundle::CacheKind::Function;
+    auto cacheData = TryLoadScriptCache(path, sourceHash, cacheKind);
+
+    if (cacheData != nullptr && cacheKind == CodeCacheBundle::CacheKind::Script) {
+        return LoadCachedScript(isolate, path, scriptText, wrappedOrigin, cacheData, sourceHash);
+    }
 
-    auto fullRequiredModulePathWithSchema = ArgConverter::ConvertToV8String(isolate, "file://" + path);
     ScriptOrigin origin(fullRequiredModulePathWithSchema);
-    ScriptCompiler::Source source(scriptText, origin, cacheData);
-    ScriptCompiler::CompileOptions option = ScriptCompiler::kNoCompileOptions;
-
-    if (cacheData != nullptr) {
-        tns::instrumentation::Frame frame("Compile, cached");
-        option = ScriptCompiler::kConsumeCodeCache;
-        auto maybeScript = ScriptCompiler::Compile(isolate->GetCurrentContext(), &source, option);
-        if (maybeScript.IsEmpty() || tc.HasCaught()) {
+    ScriptCompiler::Source compilerSource(scriptText, origin, cacheData);
+    auto option = (cacheData != nullptr) ? ScriptCompiler::kConsumeCodeCache : ScriptCompiler::kNoCompileOptions;
+
+    Local<String> parameters[] = {
+        String::NewFromUtf8Literal(isolate, "exports", NewStringType::kInternalized),
+        String::NewFromUtf8Literal(isolate, "require", NewStringType::kInternalized),
+        String::NewFromUtf8Literal(isolate, "module", NewStringType::kInternalized),
+        String::NewFromUtf8Literal(isolate, "__filename", NewStringType::kInternalized),
+        String::NewFromUtf8Literal(isolate, "__dirname", NewStringType::kInternalized)
+    };
+
+    {
+        tns::instrumentation::Frame frame(cacheData != nullptr ? "Compile, cached" : "Compile, no cache");
+        auto maybeFunc = ScriptCompiler::CompileFunctionInContext(context, &compilerSource, sizeof(parameters) / sizeof(Local<String>), parameters, 0, nullptr, option);
+        if (!maybeFunc.ToLocal(&moduleFunc) || tc.HasCaught()) {
             throw NativeScriptException(tc, "Cannot compile " + path);
         }
-        script = maybeScript.ToLocalChecked();
-    } else {
-        tns::instrumentation::Frame frame("Compile, no cache");
-        auto maybeScript = ScriptCompiler::Compile(isolate->GetCurrentContext(), &source, option);
-        if (maybeScript.IsEmpty() || tc.HasCaught()) {
+    }
+
+    // a rejected cache was created by another V8 version or with other flags
+    bool isRejected = cacheData != nullptr && compilerSource.GetCachedData()->rejected;
+    if (isRejected) {
+        RUNTIME_STATS_INCREMENT(isolate, CodeCacheRejected);
+    }
+    if (cacheData == nullptr || isRejected) {
+        SaveCodeCache(Constants::V8_CACHE_COMPILED_CODE ? ScriptCompiler::CreateCodeCacheForFunction(moduleFunc) : nullptr, path, sourceHash, CodeCacheBundle::CacheKind::Function);
+    }
+
+    DEBUG_WRITE("Compiled script (module %s)", path.c_str());
+
+    return moduleFunc;
+}
+
+Local<Function> ModuleInternal::LoadCachedScript(Isolate* isolate, const string& path, Local<String> scriptText, const ScriptOrigin& wrappedOrigin, ScriptCompiler::CachedData* cacheData, uint64_t sourceHash) {
+    TryCatch tc(isolate);
+    auto context = isolate->GetCurrentContext();
+
+    // the same source as BackgroundCompiler streamed
+    auto prologue = ArgConverter::ConvertToV8String(isolate, MODULE_PROLOGUE);
+    auto epilogue = ArgConverter::ConvertToV8String(isolate, MODULE_EPILOGUE);
+    auto wrappedText = String::Concat(isolate, String::Concat(isolate, prologue, scriptText), epilogue);
+
+    ScriptCompiler::Source compilerSource(wrappedText, wrappedOrigin, cacheData);
+    Local<UnboundScript> unboundScript;
+    {
+        tns::instrumentation::Frame frame("Compile, cached script");
+        if (!ScriptCompiler::CompileUnboundScript(isolate, &compilerSource, ScriptCompiler::kConsumeCodeCache).ToLocal(&unboundScript) || tc.HasCaught()) {
             throw NativeScriptException(tc, "Cannot compile " + path);
         }
-        script = maybeScript.ToLocalChecked();
-        SaveScriptCache(script, path);
     }
 
-    DEBUG_WRITE("Compiled script (module %s)", path.c_str());
+    Local<Value> result;
+    if (!unboundScript->BindToCurrentContext()->Run(context).ToLocal(&result) || tc.HasCaught()) {
+        throw NativeScriptException(tc, "Error running script " + path);
+    }
+
+    if (compilerSource.GetCachedData()->rejected) {
+        RUNTIME_STATS_INCREMENT(isolate, CodeCacheRejected);
+        SaveCodeCache(ScriptCompiler::CreateCodeCache(unboundScript), path, sourceHash, CodeCacheBundle::CacheKind::Script);
+    }
+
+    return result.As<Function>();
+}
+
+void ModuleInternal::CompileDependenciesInBackground(const string& modulePath, const ModuleSource& moduleSource, vector<string>& dependencies) {
+    static const char requireCall[] = "require(";
+    static const size_t requireCallLength = sizeof(requireCall) - 1;
+
+    auto dirName = modulePath.substr(0, modulePath.find_last_of('/'));
+    auto source = moduleSource.data();
+    auto length = moduleSource.length();
+    size_t pos = 0;
+
+    while (m_backgroundCompiler.PendingCount() < MAX_BACKGROUND_COMPILATIONS) {
+        auto call = static_cast<const char*>(memmem(source + pos, length - pos, requireCall, requireCallLength));
+        if (call == nullptr) {
+            break;
+        }
+
+        pos = call - source;
+        bool isCall = (pos == 0) || !(isalnum(source[pos - 1]) || source[pos - 1] == '_' || source[pos - 1] == '$' || source[pos - 1] == '.');
+        pos += requireCallLength;
+
+        auto quote = (pos < length) ? source[pos] : 0;
+        if (!isCall || (quote != '"' && quote != '\'')) {
+            continue;
+        }
 
-    return script;
+        auto end = static_cast<const char*>(memchr(source + pos + 1, quote, length - pos - 1));
+        if (end == nullptr) {
+            break;
+        }
+
+        string name(source + pos + 1, end);
+        pos = end - source;
+
+        string path;
+        string errorMessage;
+        if (m_resolver.Resolve(name, dirName, path, errorMessage) != ModuleResolver::Resolution::Found || !Util::EndsWith(path, ".js")) {
+            continue;
+        }
+
+        if (m_loadedModules.find(path) == m_loadedModules.end() && !m_backgroundCompiler.IsStarted(path)) {
+            m_backgroundCompiler.Start(path);
+            dependencies.push_back(path);
+        }
+    }
 }
 
 Local<Object> ModuleInternal::LoadData(Isolate* isolate, const string& path) {
@@ -409,11 +576,21 @@ Local<Object> ModuleInternal::LoadData(Isolate* isolate, const string& path) {
     tns::instrumentation::Frame frame(frameName.c_str());
     Local<Object> json;
 
-    auto jsonData = Runtime::GetRuntime(m_isolate)->ReadFileText(path);
+    auto runtime = Runtime::GetRuntime(m_isolate);
+    runtime->Lock();
+    MappedFile file(path, FileAccess::Sequential);
+    runtime->Unlock();
+
+    if (!file.IsOpen()) {
+        throw NativeScriptException("Cannot read JSON file " + path);
+    }
+
+    auto sourceHash = CodeCacheBundle::Hash(file.Data(), file.Size());
+    m_preloader.OnModuleLoaded(path, sourceHash, m_runningModules.empty() ? string() : m_runningModules.back(), m_backgroundCompiler);
 
     TryCatch tc(isolate);
 
-    auto jsonStr = ArgConverter::ConvertToV8String(isolate, jsonData);
+    auto jsonStr = String::NewFromUtf8(isolate, file.Data(), NewStringType::kNormal, static_cast<int>(file.Size())).ToLocalChecked();
 
     auto context = isolate->GetCurrentContext();
     auto maybeValue = JSON::Parse(context, jsonStr);
@@ -439,62 +616,31 @@ Local<Object> ModuleInternal::LoadData(Isolate* isolate, const string& path) {
     return json;
 }
 
-Local<String> ModuleInternal::WrapModuleContent(const string& path) {
-    TNSPERF();
-
-    string content = Runtime::GetRuntime(m_isolate)->ReadFileText(path);
-
-    // TODO: Use statically allocated buffer for better performance
-    string result(MODULE_PROLOGUE);
-    result.reserve(content.length() + 1024);
-    result += content;
-    result += MODULE_EPILOGUE;
-
-    return ArgConverter::ConvertToV8String(m_isolate, result);
-}
-
-ScriptCompiler::CachedData* ModuleInternal::TryLoadScriptCache(const std::string& path) {
+ScriptCompiler::CachedData* ModuleInternal::TryLoadScriptCache(const std::string& path, uint64_t sourceHash, CodeCacheBundle::CacheKind& kind) {
     TNSPERF();
     if (!Constants::V8_CACHE_COMPILED_CODE) {
         return nullptr;
     }
 
-    auto cachePath = path + ".cache";
-
-    struct stat result;
-    if (stat(cachePath.c_str(), &result) == 0) {
-        auto cacheLastModifiedTime = result.st_mtime;
-        if (stat(path.c_str(), &result) == 0) {
-            auto jsLastModifiedTime = result.st_mtime;
-            if (jsLastModifiedTime > 0 && cacheLastModifiedTime > 0 && jsLastModifiedTime > cacheLastModifiedTime) {
-                // The javascript file is more recent than the cache file => ignore the cache
-                return nullptr;
-            }
-        }
-    }
-
-    int length = 0;
-    auto data = File::ReadBinary(cachePath, length);
-    if (!data) {
-        return nullptr;
+    // the cache is looked up by the hash of the module source, so no file has to be stat-ed
+    auto cachedData = CodeCacheBundle::GetInstance()->Get(path, sourceHash, kind);
+    if (cachedData != nullptr) {
+        RUNTIME_STATS_INCREMENT(m_isolate, CodeCacheHits);
+    } else {
+        RUNTIME_STATS_INCREMENT(m_isolate, CodeCacheMisses);
     }
 
-    return new ScriptCompiler::CachedData(reinterpret_cast<uint8_t*>(data), length, ScriptCompiler::CachedData::BufferOwned);
+    return cachedData;
 }
 
-void ModuleInternal::SaveScriptCache(const Local<Script> script, const std::string& path) {
-    if (!Constants::V8_CACHE_COMPILED_CODE) {
+void ModuleInternal::SaveCodeCache(ScriptCompiler::CachedData* cachedData, const std::string& path, uint64_t sourceHash, CodeCacheBundle::CacheKind kind) {
+    if (cachedData == nullptr) {
         return;
     }
 
-    tns::instrumentation::Frame frame("SaveScriptCache");
-
-    Local<UnboundScript> unboundScript = script->GetUnboundScript();
-    ScriptCompiler::CachedData* cachedData = ScriptCompiler::CreateCodeCache(unboundScript);
+    tns::instrumentation::Frame frame("SaveCodeCache");
 
-    int length = cachedData->length;
-    auto cachePath = path + ".cache";
-    File::WriteBinary(cachePath, cachedData->data, length);
+    CodeCacheBundle::GetInstance()->Put(path, sourceHash, kind, unique_ptr<ScriptCompiler::CachedData>(cachedData));
 }
 
 ModuleInternal::ModulePathKind ModuleInternal::GetModulePathKind(const std::string& path) {
@@ -516,6 +662,6 @@ ModuleInternal::ModulePathKind ModuleInternal::GetModulePathKind(const std::stri
 jclass ModuleInternal::MODULE_CLASS = nullptr;
 jmethodID ModuleInternal::RESOLVE_PATH_METHOD_ID = nullptr;
 
-const char* ModuleInternal::MODULE_PROLOGUE = "(function(module, exports, require, __filename, __dirname){ ";
+const char* ModuleInternal::MODULE_PROLOGUE = "(function(exports, require, module, __filename, __dirname){ ";
 const char* ModuleInternal::MODULE_EPILOGUE = "\n})";
 int ModuleInternal::MODULE_PROLOGUE_LENGTH = std::string(ModuleInternal::MODULE_PROLOGUE).length();
@@ -10,9 +10,15 @@
 
 #include "JEnv.h"
 #include "v8.h"
+#include "BackgroundCompiler.h"
+#include "CodeCacheBundle.h"
+#include "ModulePreloader.h"
+#include "ModuleSource.h"
+#include "ModuleResolver.h"
 
 #include <string>
 #include <map>
+#include <vector>
 
 namespace tns {
 class ModuleInternal {
@@ -31,13 +37,25 @@ class ModuleInternal {
          */
         void LoadWorker(v8::Local<v8::Context> context, const std::string& path);
 
+        /*
+         * Starts preloading the modules recorded in the given manifest and recording the modules
+         * loaded until FinishPreloading is called, for the next launches.
+         */
+        void StartPreloading(const std::string& manifestPath);
+
+        void FinishPreloading();
+
+        /*
+         * Drops the resolved module paths, e.g. after livesync changed the application files.
+         * Can be called from any thread.
+         */
+        void InvalidateResolvedPaths();
+
         /*
          * Checks if target script exists, will throw if negative
          * Used before initializing workers, to ensure a thread will not be created, when the file doesn't exist
          */
         static void CheckFileExists(v8::Isolate* isolate, const std::string& path, const std::string& baseDir);
-
-        static int MODULE_PROLOGUE_LENGTH;
     private:
         enum class ModulePathKind;
 
@@ -49,7 +67,11 @@ class ModuleInternal {
 
         void RequireCallbackImpl(const v8::FunctionCallbackInfo<v8::Value>& args);
 
-        v8::Local<v8::String> WrapModuleContent(const std::string& path);
+        /*
+         * Resolves the module natively, falling back to Module.resolvePath in the cases the native lookup leaves to it.
+         * Throws if the module cannot be found.
+         */
+        std::string ResolvePath(const std::string& moduleName, const std::string& baseDir);
 
         v8::Local<v8::Object> LoadImpl(v8::Isolate* isolate, const std::string& moduleName, const std::string& baseDir, bool& isData);
 
@@ -57,13 +79,33 @@ class ModuleInternal {
 
         v8::Local<v8::Object> LoadData(v8::Isolate* isolate, const std::string& path);
 
-        v8::Local<v8::Script> LoadScript(v8::Isolate* isolate, const std::string& modulePath, const v8::Local<v8::String>& fullRequiredModulePath);
+        /*
+         * Compiles the module into a function taking exports, require, module, __filename and __dirname,
+         * and starts compiling its dependencies in the background.
+         */
+        v8::Local<v8::Function> LoadScript(v8::Isolate* isolate, const std::string& modulePath, uint64_t& sourceHash, std::vector<std::string>& dependencies);
+
+        /*
+         * Compiles the module from the cache of the wrapped script, which was created when the module was
+         * compiled in the background, and returns the module function.
+         */
+        v8::Local<v8::Function> LoadCachedScript(v8::Isolate* isolate, const std::string& path, v8::Local<v8::String> scriptText,
+                const v8::ScriptOrigin& wrappedOrigin, v8::ScriptCompiler::CachedData* cacheData, uint64_t sourceHash);
+
+        /*
+         * Starts compiling the modules required with a string literal in the given module source
+         * in the background, so they are likely compiled by the time the module body requires them.
+         */
+        void CompileDependenciesInBackground(const std::string& modulePath, const ModuleSource& source, std::vector<std::string>& dependencies);
 
         v8::Local<v8::Function> GetRequireFunction(v8::Isolate* isolate, const std::string& dirName);
 
-        v8::ScriptCompiler::CachedData* TryLoadScriptCache(const std::string& path);
+        v8::ScriptCompiler::CachedData* TryLoadScriptCache(const std::string& path, uint64_t sourceHash, CodeCacheBundle::CacheKind& kind);
 
-        void SaveScriptCache(const v8::Local<v8::Script> script, const std::string& path);
+        /*
+         * Hands the cache, if any, to the bundle, which writes it in the background.
+         */
+        void SaveCodeCache(v8::ScriptCompiler::CachedData* cachedData, const std::string& path, uint64_t sourceHash, CodeCacheBundle::CacheKind kind);
 
         ModulePathKind GetModulePathKind(const std::string& path);
 
@@ -71,12 +113,19 @@ class ModuleInternal {
         static jmethodID RESOLVE_PATH_METHOD_ID;
         static const char* MODULE_PROLOGUE;
         static const char* MODULE_EPILOGUE;
+        static int MODULE_PROLOGUE_LENGTH;
+        static const size_t MAX_BACKGROUND_COMPILATIONS = 16;
 
         v8::Isolate* m_isolate;
         v8::Persistent<v8::Function>* m_requireFunction;
         v8::Persistent<v8::Function>* m_requireFactoryFunction;
         std::map<std::string, v8::Persistent<v8::Function>*> m_requireCache;
         std::map<std::string, ModuleCacheEntry> m_loadedModules;
+        BackgroundCompiler m_backgroundCompiler;
+        ModuleResolver m_resolver;
+        ModulePreloader m_preloader;
+        // the modules whose bodies are running, the innermost last
+        std::vector<std::string> m_runningModules;
 
         class TempModule {
             public:
@@ -0,0 +1,226 @@
+#include "ModulePreloader.h"
+#include "CodeCacheBundle.h"
+#include "Constants.h"
+#include "File.h"
+#include "NativeScriptAssert.h"
+#include "Runtime.h"
+#include "Util.h"
+#include "v8-platform.h"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace v8;
+using namespace std;
+using namespace tns;
+
+namespace {
+/*
+ * Reads the files ahead into the page cache, on a worker thread.
+ */
+class PrefetchTask : public Task {
+    public:
+        PrefetchTask(vector<string>&& paths)
+            : m_paths(move(paths)) {
+        }
+
+        void Run() override {
+            for (const auto& path : m_paths) {
+                int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                if (fd == -1) {
+                    continue;
+                }
+
+                struct stat st;
+                if (fstat(fd, &st) == 0) {
+                    readahead(fd, 0, st.st_size);
+                }
+
+                close(fd);
+            }
+        }
+
+    private:
+        vector<string> m_paths;
+};
+
+template<typename T>
+void Append(string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool Read(const uint8_t* data, size_t length, size_t& pos, T& value) {
+    if (pos + sizeof(T) > length) {
+        return false;
+    }
+    memcpy(&value, data + pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+}
+
+const char ModulePreloader::MAGIC[4] = { 'N', 'S', 'R', 'G' };
+
+ModulePreloader::ModulePreloader()
+    : m_isRecording(false), m_isStale(false), m_nextToCompile(0) {
+}
+
+void ModulePreloader::Start(const string& manifestPath, BackgroundCompiler& compiler) {
+    if (m_isRecording) {
+        return;
+    }
+
+    m_manifestPath = manifestPath;
+    m_isRecording = true;
+    m_nextToCompile = 0;
+    m_isStale = !ReadManifest(m_manifestPath, m_manifest);
+
+    if (m_isStale) {
+        DEBUG_WRITE("No module preloading manifest, recording one");
+        return;
+    }
+
+    Prefetch(m_manifest);
+    CompileAhead(compiler);
+}
+
+void ModulePreloader::OnModuleLoaded(const string& path, uint64_t sourceHash, const string& parentPath, BackgroundCompiler& compiler) {
+    if (!m_isRecording || m_recordedPaths.find(path) != m_recordedPaths.end()) {
+        return;
+    }
+
+    uint32_t parent = NO_PARENT;
+    for (size_t i = m_recorded.size(); i > 0; i--) {
+        if (m_recorded[i - 1].path == parentPath) {
+            parent = static_cast<uint32_t>(i - 1);
+            break;
+        }
+    }
+
+    auto index = m_recorded.size();
+    m_recorded.push_back({ path, sourceHash, parent });
+    m_recordedPaths.insert(path);
+
+    if (m_isStale) {
+        return;
+    }
+
+    if (index >= m_manifest.size() || m_manifest[index].path != path || m_manifest[index].sourceHash != sourceHash) {
+        // the application has changed, the modules compiled ahead are still correct, as they are compiled from the files
+        DEBUG_WRITE("The module preloading manifest is stale at %s", path.c_str());
+        m_isStale = true;
+        return;
+    }
+
+    CompileAhead(compiler);
+}
+
+void ModulePreloader::Finish(BackgroundCompiler& compiler) {
+    if (!m_isRecording) {
+        return;
+    }
+
+    m_isRecording = false;
+    compiler.Discard(m_compiledAhead);
+
+    if (m_isStale || m_recorded.size() != m_manifest.size()) {
+        if (!WriteManifest(m_manifestPath, m_recorded)) {
+            DEBUG_WRITE("Cannot write the module preloading manifest %s", m_manifestPath.c_str());
+        }
+    }
+
+    m_manifest.clear();
+    m_recorded.clear();
+    m_recordedPaths.clear();
+    m_compiledAhead.clear();
+}
+
+void ModulePreloader::CompileAhead(BackgroundCompiler& compiler) {
+    while (m_nextToCompile < m_manifest.size() && compiler.PendingCount() < MAX_COMPILED_AHEAD) {
+        const auto& path = m_manifest[m_nextToCompile++].path;
+        if (!Util::EndsWith(path, ".js") || m_recordedPaths.find(path) != m_recordedPaths.end() || compiler.IsStarted(path)) {
+            continue;
+        }
+
+        compiler.Start(path);
+        m_compiledAhead.push_back(path);
+    }
+}
+
+void ModulePreloader::Prefetch(const vector<Entry>& entries) {
+    vector<string> paths;
+    paths.reserve(entries.size());
+    for (const auto& entry : entries) {
+        paths.push_back(entry.path);
+    }
+
+    if (Constants::V8_CACHE_COMPILED_CODE) {
+        CodeCacheBundle::GetInstance()->Prefetch(paths);
+    }
+
+    Runtime::platform->CallOnWorkerThread(unique_ptr<Task>(new PrefetchTask(move(paths))));
+}
+
+bool ModulePreloader::ReadManifest(const string& manifestPath, vector<Entry>& entries) {
+    MappedFile file(manifestPath, FileAccess::Sequential);
+    if (!file.IsOpen()) {
+        return false;
+    }
+
+    auto data = reinterpret_cast<const uint8_t*>(file.Data());
+    size_t size = file.Size();
+    size_t pos = 0;
+    bool isValid = size >= sizeof(MAGIC) + sizeof(uint64_t) && memcmp(data, MAGIC, sizeof(MAGIC)) == 0;
+
+    uint64_t checksum = 0;
+    if (isValid) {
+        memcpy(&checksum, data + size - sizeof(uint64_t), sizeof(uint64_t));
+        size -= sizeof(uint64_t);
+        isValid = checksum == CodeCacheBundle::Hash(reinterpret_cast<const char*>(data), size);
+        pos = sizeof(MAGIC);
+    }
+
+    uint32_t version = 0;
+    uint32_t count = 0;
+    isValid = isValid && Read(data, size, pos, version) && version == VERSION && Read(data, size, pos, count);
+
+    for (uint32_t i = 0; isValid && i < count; i++) {
+        Entry entry;
+        uint32_t pathLength = 0;
+        isValid = Read(data, size, pos, entry.sourceHash) && Read(data, size, pos, entry.parent) && Read(data, size, pos, pathLength)
+                  && pos + pathLength <= size;
+        if (isValid) {
+            entry.path.assign(reinterpret_cast<const char*>(data + pos), pathLength);
+            pos += pathLength;
+            entries.push_back(move(entry));
+        }
+    }
+
+    if (!isValid) {
+        entries.clear();
+    }
+
+    return isValid;
+}
+
+bool ModulePreloader::WriteManifest(const string& manifestPath, const vector<Entry>& entries) {
+    string buffer(MAGIC, sizeof(MAGIC));
+    Append(buffer, VERSION);
+    Append(buffer, static_cast<uint32_t>(entries.size()));
+
+    for (const auto& entry : entries) {
+        Append(buffer, entry.sourceHash);
+        Append(buffer, entry.parent);
+        Append(buffer, static_cast<uint32_t>(entry.path.size()));
+        buffer += entry.path;
+    }
+
+    Append(buffer, CodeCacheBundle::Hash(buffer.data(), buffer.size()));
+
+    // replaced at once, so an interrupted write leaves the previous manifest
+    auto tmpPath = manifestPath + ".tmp";
+    return File::WriteBinary(tmpPath, buffer.data(), buffer.size()) && rename(tmpPath.c_str(), manifestPath.c_str()) == 0;
+}
@@ -0,0 +1,81 @@
+#ifndef MODULEPRELOADER_H_
+#define MODULEPRELOADER_H_
+
+#include "BackgroundCompiler.h"
+#include <cstdint>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace tns {
+/*
+ * Records the modules loaded while the application starts: their paths, the hashes of their
+ * sources, the modules which required them and the order. The record is kept in a manifest, which
+ * the next launches use to prefetch the module files and to compile the upcoming modules in the
+ * background ahead of the require() calls.
+ *
+ * The manifest is only a prediction. The modules are always loaded from the files, so a stale
+ * manifest costs some wasted work only. Once a module differs from the manifest, the preloading
+ * stops and the manifest is replaced by the record of the launch.
+ */
+class ModulePreloader {
+    public:
+        ModulePreloader();
+
+        /*
+         * Reads the manifest of the previous launch, starts prefetching its files and starts recording.
+         */
+        void Start(const std::string& manifestPath, BackgroundCompiler& compiler);
+
+        /*
+         * Records a module which has been compiled and is about to run, and compiles the next ones ahead.
+         */
+        void OnModuleLoaded(const std::string& path, uint64_t sourceHash, const std::string& parentPath, BackgroundCompiler& compiler);
+
+        /*
+         * Stops recording and writes the manifest if the launch differed from it.
+         */
+        void Finish(BackgroundCompiler& compiler);
+
+    private:
+        struct Entry {
+            std::string path;
+            uint64_t sourceHash;
+            uint32_t parent;
+        };
+
+        void CompileAhead(BackgroundCompiler& compiler);
+
+        static void Prefetch(const std::vector<Entry>& entries);
+
+        static bool ReadManifest(const std::string& manifestPath, std::vector<Entry>& entries);
+
+        static bool WriteManifest(const std::string& manifestPath, const std::vector<Entry>& entries);
+
+        std::string m_manifestPath;
+
+        bool m_isRecording;
+
+        bool m_isStale;
+
+        std::vector<Entry> m_manifest;
+
+        size_t m_nextToCompile;
+
+        std::vector<Entry> m_recorded;
+
+        std::unordered_set<std::string> m_recordedPaths;
+
+        std::vector<std::string> m_compiledAhead;
+
+        static const uint32_t NO_PARENT = 0xFFFFFFFF;
+
+        static const size_t MAX_COMPILED_AHEAD = 8;
+
+        static const uint32_t VERSION = 1;
+
+        static const char MAGIC[4];
+};
+}
+
+#endif /* MODULEPRELOADER_H_ */
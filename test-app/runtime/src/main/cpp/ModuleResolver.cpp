@@ -0,0 +1,659 @@
+#include "ModuleResolver.h"
+#include "ApkFileSystem.h"
+#include "File.h"
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace tns;
+
+namespace {
+/*
+ * A minimal strict JSON reader, enough to pick the top level "main" entry of a package.json.
+ */
+class JsonReader {
+    public:
+        JsonReader(const string& json)
+            : m_json(json), m_pos(0) {
+            // org.json skips the byte order mark as well
+            if (m_json.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+                m_pos = 3;
+            }
+        }
+
+        void SkipWhitespace() {
+            while (m_pos < m_json.size() && (m_json[m_pos] == ' ' || m_json[m_pos] == '\t' || m_json[m_pos] == '\n' || m_json[m_pos] == '\r')) {
+                m_pos++;
+            }
+        }
+
+        bool Consume(char c) {
+            SkipWhitespace();
+            if (m_pos < m_json.size() && m_json[m_pos] == c) {
+                m_pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool Peek(char c) {
+            SkipWhitespace();
+            return m_pos < m_json.size() && m_json[m_pos] == c;
+        }
+
+        bool IsAtEnd() {
+            SkipWhitespace();
+            return m_pos == m_json.size();
+        }
+
+        bool ReadString(string& value) {
+            if (!Consume('"')) {
+                return false;
+            }
+
+            while (m_pos < m_json.size()) {
+                unsigned char c = m_json[m_pos++];
+                if (c == '"') {
+                    return true;
+                }
+                if (c < 0x20) {
+                    return false;
+                }
+                if (c != '\\') {
+                    value += c;
+                    continue;
+                }
+                if (m_pos >= m_json.size()) {
+                    return false;
+                }
+
+                char escaped = m_json[m_pos++];
+                switch (escaped) {
+                    case '"':
+                    case '\\':
+                    case '/':
+                        value += escaped;
+                        break;
+                    case 'b':
+                        value += '\b';
+                        break;
+                    case 'f':
+                        value += '\f';
+                        break;
+                    case 'n':
+                        value += '\n';
+                        break;
+                    case 'r':
+                        value += '\r';
+                        break;
+                    case 't':
+                        value += '\t';
+                        break;
+                    case 'u': {
+                            uint32_t codePoint;
+                            if (!ReadCodePoint(codePoint)) {
+                                return false;
+                            }
+                            AppendUtf8(codePoint, value);
+                            break;
+                        }
+                    default:
+                        return false;
+                }
+            }
+
+            return false;
+        }
+
+        bool SkipValue(int depth) {
+            if (depth > MAX_DEPTH) {
+                return false;
+            }
+
+            SkipWhitespace();
+            if (m_pos >= m_json.size()) {
+                return false;
+            }
+
+            char c = m_json[m_pos];
+            if (c == '"') {
+                string ignored;
+                return ReadString(ignored);
+            }
+
+            if (c == '{' || c == '[') {
+                char close = (c == '{') ? '}' : ']';
+                m_pos++;
+                if (Consume(close)) {
+                    return true;
+                }
+                do {
+                    if (c == '{') {
+                        string key;
+                        if (!ReadString(key) || !Consume(':')) {
+                            return false;
+                        }
+                    }
+                    if (!SkipValue(depth + 1)) {
+                        return false;
+                    }
+                } while (Consume(','));
+                return Consume(close);
+            }
+
+            static const char* literals[] = { "true", "false", "null" };
+            for (auto literal : literals) {
+                auto length = strlen(literal);
+                if (m_json.compare(m_pos, length, literal) == 0) {
+                    m_pos += length;
+                    return true;
+                }
+            }
+
+            auto start = m_pos;
+            while (m_pos < m_json.size() && strchr("+-.eE0123456789", m_json[m_pos]) != nullptr && m_json[m_pos] != '\0') {
+                m_pos++;
+            }
+            return m_pos > start;
+        }
+
+    private:
+        bool ReadHex(uint32_t& value) {
+            if (m_pos + 4 > m_json.size()) {
+                return false;
+            }
+            value = 0;
+            for (int i = 0; i < 4; i++) {
+                char c = m_json[m_pos++];
+                value <<= 4;
+                if (c >= '0' && c <= '9') {
+                    value |= c - '0';
+                } else if (c >= 'a' && c <= 'f') {
+                    value |= c - 'a' + 10;
+                } else if (c >= 'A' && c <= 'F') {
+                    value |= c - 'A' + 10;
+                } else {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool ReadCodePoint(uint32_t& codePoint) {
+            if (!ReadHex(codePoint)) {
+                return false;
+            }
+
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF && m_json.compare(m_pos, 2, "\\u") == 0) {
+                auto pos = m_pos;
+                m_pos += 2;
+                uint32_t low;
+                if (ReadHex(low) && low >= 0xDC00 && low <= 0xDFFF) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                } else {
+                    m_pos = pos;
+                }
+            }
+
+            return true;
+        }
+
+        static void AppendUtf8(uint32_t codePoint, string& out) {
+            if (codePoint < 0x80) {
+                out += static_cast<char>(codePoint);
+            } else if (codePoint < 0x800) {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        const string& m_json;
+        size_t m_pos;
+
+        static const int MAX_DEPTH = 64;
+};
+}
+
+ModuleResolver::ModuleResolver()
+    : m_rootDirsCount(0), m_isUnsupported(false), m_resolveCount(0), m_isInvalidated(false) {
+}
+
+void ModuleResolver::Init(const string& appRootFolderPath) {
+    char canonicalPath[PATH_MAX];
+    string appRoot = (realpath(appRootFolderPath.c_str(), canonicalPath) != nullptr) ? canonicalPath : JoinPath(appRootFolderPath, "");
+
+    // the same paths as in Module.init
+    m_applicationFilesPath = appRoot.substr(0, appRoot.find_last_of('/'));
+    m_modulesPath = m_applicationFilesPath + "/app/";
+    m_nativeScriptModulesPath = m_applicationFilesPath + "/app/tns_modules/tns-core-modules";
+
+    // the number of the tokens (ApplicationFilesPath + "/app").split("/") returns
+    auto rootDir = m_applicationFilesPath + "/app";
+    m_rootDirsCount = 1;
+    for (auto c : rootDir) {
+        if (c == '/') {
+            m_rootDirsCount++;
+        }
+    }
+}
+
+ModuleResolver::Resolution ModuleResolver::Resolve(const string& name, const string& baseDir, string& resolvedPath, string& errorMessage) {
+    if (m_isInvalidated.exchange(false)) {
+        m_resolved.clear();
+        m_packages.clear();
+        // the application package does not change
+        for (auto it = m_directories.begin(); it != m_directories.end();) {
+            it = it->second.isMounted ? next(it) : m_directories.erase(it);
+        }
+    }
+
+    auto key = baseDir + "*" + name;
+
+    auto it = m_resolved.find(key);
+    if (it != m_resolved.end()) {
+        resolvedPath = it->second;
+        return Resolution::Found;
+    }
+
+    m_resolveCount++;
+    m_isUnsupported = false;
+    string foundPath;
+    string searchDir;
+    bool isFound = ResolveImpl(name, baseDir, foundPath, searchDir);
+
+    if (m_isUnsupported) {
+        return Resolution::Unsupported;
+    }
+
+    if (!isFound) {
+        // the same message as in Module.resolveFromFileOrDirectory
+        if (StartsWith(name, "~/")) {
+            errorMessage = "Failed to find module: \"" + name + "\", relative to: /app/";
+        } else if (searchDir.size() > m_applicationFilesPath.size()) {
+            errorMessage = "Failed to find module: \"" + name + "\", relative to: " + searchDir.substr(m_applicationFilesPath.size() + 1) + "/";
+        } else {
+            return Resolution::Unsupported;
+        }
+
+        return Resolution::NotFound;
+    }
+
+    char canonicalPath[PATH_MAX];
+    if (realpath(foundPath.c_str(), canonicalPath) != nullptr) {
+        resolvedPath = canonicalPath;
+    } else if (ApkFileSystem::IsMounted(foundPath)) {
+        // the package holds no symbolic links
+        resolvedPath = ApkFileSystem::NormalizePath(foundPath);
+    } else {
+        return Resolution::Unsupported;
+    }
+
+    m_resolved.emplace(key, resolvedPath);
+
+    return Resolution::Found;
+}
+
+void ModuleResolver::Invalidate() {
+    m_isInvalidated = true;
+}
+
+bool ModuleResolver::ResolveImpl(const string& name, const string& baseDir, string& foundPath, string& searchDir) {
+    auto startDir = (baseDir.empty() || StartsWith(name, "~/")) ? m_modulesPath : baseDir;
+
+    if (StartsWith(name, "./") || StartsWith(name, "../") || StartsWith(name, "~/") || StartsWith(name, "/")) {
+        string fileOrDirectory;
+        if (StartsWith(name, "/")) {
+            fileOrDirectory = JoinPath(name, "");
+        } else if (StartsWith(name, "~/")) {
+            fileOrDirectory = JoinPath(m_modulesPath, name.substr(2));
+        } else {
+            fileOrDirectory = JoinPath(startDir, name);
+        }
+
+        searchDir = startDir;
+        return ResolveFromFileOrDirectory(fileOrDirectory, foundPath, 0);
+    }
+
+    searchDir = m_nativeScriptModulesPath;
+    if (ResolveFromFileOrDirectory(JoinPath(m_nativeScriptModulesPath, name), foundPath, 0) || m_isUnsupported) {
+        return !m_isUnsupported;
+    }
+
+    vector<string> searchDirs;
+    GetNodeModulesPaths(startDir, searchDirs);
+
+    for (const auto& dir : searchDirs) {
+        searchDir = dir;
+        if (ResolveFromFileOrDirectory(JoinPath(dir, name), foundPath, 0) || m_isUnsupported) {
+            return !m_isUnsupported;
+        }
+    }
+
+    return false;
+}
+
+bool ModuleResolver::ResolveFromFileOrDirectory(const string& fileOrDirectory, string& foundPath, int depth) {
+    return LoadAsFile(fileOrDirectory, foundPath) || LoadAsDirectory(fileOrDirectory, foundPath, depth);
+}
+
+bool ModuleResolver::LoadAsFile(const string& path, string& foundPath) {
+    bool hasExtension = EndsWith(path, ".js") || EndsWith(path, ".json") || EndsWith(path, ".so");
+    auto filePath = hasExtension ? path : path + ".js";
+
+    if (IsFile(filePath)) {
+        foundPath = filePath;
+        return true;
+    }
+
+    return false;
+}
+
+bool ModuleResolver::LoadAsDirectory(const string& path, string& foundPath, int depth) {
+    auto packageFilePath = JoinPath(path, "package.json");
+
+    if (Exists(packageFilePath)) {
+        const Package& package = GetPackage(packageFilePath);
+        if (!package.isSupported || depth >= MAX_PACKAGE_MAIN_DEPTH) {
+            m_isUnsupported = true;
+            return false;
+        }
+
+        if (package.hasMain) {
+            if (ResolveFromFileOrDirectory(JoinPath(path, package.main), foundPath, depth + 1)) {
+                return true;
+            }
+            if (m_isUnsupported) {
+                return false;
+            }
+        }
+    }
+
+    auto indexPath = JoinPath(path, "index.js");
+    if (Exists(indexPath)) {
+        foundPath = indexPath;
+        return true;
+    }
+
+    return false;
+}
+
+void ModuleResolver::GetNodeModulesPaths(const string& startDir, vector<string>& paths) {
+    // the same directories as Module.nodeModulesPaths lists
+    auto absoluteStartDir = JoinPath(startDir, "");
+
+    vector<string> dirs;
+    size_t start = 0;
+    while (true) {
+        auto end = absoluteStartDir.find('/', start);
+        dirs.push_back(absoluteStartDir.substr(start, end - start));
+        if (end == string::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+
+    while (dirs.size() >= m_rootDirsCount && !dirs.empty()) {
+        const auto& lastDir = dirs.back();
+        if (lastDir == "node_modules" || lastDir == "tns_modules") {
+            dirs.pop_back();
+            continue;
+        }
+
+        string currentDir;
+        for (size_t i = 0; i < dirs.size(); i++) {
+            if (i > 0) {
+                currentDir += '/';
+            }
+            currentDir += dirs[i];
+        }
+
+        paths.push_back(currentDir + ((lastDir == "app") ? "/tns_modules" : "/node_modules"));
+
+        dirs.pop_back();
+    }
+}
+
+bool ModuleResolver::Exists(const string& path) {
+    EntryKind kind;
+    return GetEntryKind(path, kind);
+}
+
+bool ModuleResolver::IsFile(const string& path) {
+    EntryKind kind;
+    return GetEntryKind(path, kind) && kind == EntryKind::File;
+}
+
+bool ModuleResolver::GetEntryKind(const string& path, EntryKind& kind) {
+    auto separator = path.find_last_of('/');
+    if (separator == string::npos) {
+        return false;
+    }
+
+    auto dir = (separator == 0) ? string("/") : path.substr(0, separator);
+    auto name = path.substr(separator + 1);
+    if (name.empty()) {
+        kind = EntryKind::Directory;
+        return true;
+    }
+
+    auto directory = GetDirectory(dir);
+    if (directory == nullptr) {
+        return false;
+    }
+
+    auto& entries = directory->entries;
+    auto entry = entries.find(name);
+    if (entry == entries.end()) {
+        return false;
+    }
+
+    if (entry->second == EntryKind::Unknown) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            // a dangling symbolic link
+            entries.erase(entry);
+            return false;
+        }
+        entry->second = S_ISREG(st.st_mode) ? EntryKind::File : (S_ISDIR(st.st_mode) ? EntryKind::Directory : EntryKind::Other);
+    }
+
+    kind = entry->second;
+    return true;
+}
+
+ModuleResolver::Directory* ModuleResolver::GetDirectory(const string& dir) {
+    auto it = m_directories.find(dir);
+    if (it != m_directories.end()) {
+        auto& directory = it->second;
+        if (directory.isMounted || directory.checkedResolveCount == m_resolveCount) {
+            return &directory;
+        }
+
+        // a folder on the disk is checked once per lookup
+        int64_t modificationTime;
+        if (directory.modificationTime != -1 && GetModificationTime(dir, modificationTime) && modificationTime == directory.modificationTime) {
+            directory.checkedResolveCount = m_resolveCount;
+            return &directory;
+        }
+
+        m_directories.erase(it);
+    }
+
+    if (m_missingMountedDirectories.find(dir) != m_missingMountedDirectories.end()) {
+        return nullptr;
+    }
+
+    Directory directory;
+    if (!ListDirectory(dir, directory)) {
+        if (directory.isMounted) {
+            m_missingMountedDirectories.insert(dir);
+        }
+        return nullptr;
+    }
+
+    return &(m_directories[dir] = move(directory));
+}
+
+bool ModuleResolver::ListDirectory(const string& dir, Directory& directory) {
+    directory.isMounted = ApkFileSystem::IsMounted(dir);
+    directory.modificationTime = -1;
+    directory.checkedResolveCount = m_resolveCount;
+
+    if (directory.isMounted) {
+        vector<pair<string, bool>> apkEntries;
+        if (!ApkFileSystem::ListDirectory(dir, apkEntries)) {
+            return false;
+        }
+
+        for (const auto& apkEntry : apkEntries) {
+            directory.entries.emplace(apkEntry.first, apkEntry.second ? EntryKind::Directory : EntryKind::File);
+        }
+
+        return true;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    int64_t modificationTime;
+    if (!GetModificationTime(dir, modificationTime)) {
+        return false;
+    }
+
+    auto dirStream = opendir(dir.c_str());
+    if (dirStream == nullptr) {
+        return false;
+    }
+
+    while (auto entry = readdir(dirStream)) {
+        EntryKind entryKind;
+        switch (entry->d_type) {
+            case DT_REG:
+                entryKind = EntryKind::File;
+                break;
+            case DT_DIR:
+                entryKind = EntryKind::Directory;
+                break;
+            case DT_LNK:
+            case DT_UNKNOWN:
+                entryKind = EntryKind::Unknown;
+                break;
+            default:
+                entryKind = EntryKind::Other;
+                break;
+        }
+        directory.entries.emplace(entry->d_name, entryKind);
+    }
+    closedir(dirStream);
+
+    // otherwise the folder is listed again by the next lookup
+    int64_t listingTime = static_cast<int64_t>(now.tv_sec) * 1000000000LL + now.tv_nsec;
+    if (modificationTime + RACY_LISTING_INTERVAL_NS <= listingTime) {
+        directory.modificationTime = modificationTime;
+    }
+
+    return true;
+}
+
+bool ModuleResolver::GetModificationTime(const string& path, int64_t& modificationTime) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+
+    modificationTime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+    return true;
+}
+
+const ModuleResolver::Package& ModuleResolver::GetPackage(const string& packageFilePath) {
+    auto it = m_packages.find(packageFilePath);
+    if (it != m_packages.end()) {
+        return it->second;
+    }
+
+    Package& package = m_packages[packageFilePath];
+    package.isSupported = false;
+    package.hasMain = false;
+
+    MappedFile file(packageFilePath, FileAccess::Sequential);
+    if (file.IsOpen()) {
+        package.isSupported = ParsePackageMain(string(file.Data(), file.Size()), package.hasMain, package.main);
+    }
+
+    return package;
+}
+
+bool ModuleResolver::ParsePackageMain(const string& json, bool& hasMain, string& main) {
+    JsonReader reader(json);
+    hasMain = false;
+
+    if (!reader.Consume('{')) {
+        return false;
+    }
+
+    if (!reader.Consume('}')) {
+        do {
+            string key;
+            if (!reader.ReadString(key) || !reader.Consume(':')) {
+                return false;
+            }
+
+            if (key == "main") {
+                // the duplicate keys and the values org.json converts to strings are left to it
+                if (hasMain || !reader.Peek('"') || !reader.ReadString(main)) {
+                    return false;
+                }
+                hasMain = true;
+            } else if (!reader.SkipValue(0)) {
+                return false;
+            }
+        } while (reader.Consume(','));
+
+        if (!reader.Consume('}')) {
+            return false;
+        }
+    }
+
+    return reader.IsAtEnd();
+}
+
+string ModuleResolver::JoinPath(const string& parent, const string& child) {
+    string joined = child.empty() ? parent : (parent + "/" + child);
+
+    string result;
+    result.reserve(joined.size());
+    for (auto c : joined) {
+        if (c == '/' && !result.empty() && result.back() == '/') {
+            continue;
+        }
+        result += c;
+    }
+
+    if (result.size() > 1 && result.back() == '/') {
+        result.pop_back();
+    }
+
+    return result;
+}
+
+bool ModuleResolver::StartsWith(const string& str, const string& prefix) {
+    return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool ModuleResolver::EndsWith(const string& str, const string& suffix) {
+    return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
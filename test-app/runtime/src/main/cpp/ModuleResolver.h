@@ -0,0 +1,160 @@
+#ifndef MODULERESOLVER_H_
+#define MODULERESOLVER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tns {
+/*
+ * Resolves the module names passed to require() the same way as com.tns.Module.resolvePath,
+ * without leaving the native side.
+ *
+ * The existence checks are answered from the listings of the directories. A folder on the disk is
+ * listed again once its modification time changes, so the files written after startup, e.g. by
+ * livesync or the hot module replacement, are found, while the folders mounted by ApkFileSystem are
+ * listed once from the application package. The "main" entries of the package.json files and the
+ * resolved paths are cached until Invalidate is called, the failed lookups are not cached. A module
+ * which is not found is reported with the message of the exception Module.resolvePath throws. The
+ * rare cases, e.g. a package.json which is not strict JSON, are left to Module.resolvePath, which
+ * the caller falls back to.
+ *
+ * Depends on POSIX and zlib only, so it can be exercised on the host against a fixture tree or
+ * a zip fixture.
+ */
+class ModuleResolver {
+    public:
+        enum class Resolution {
+            Found,
+            NotFound,
+            // left to Module.resolvePath
+            Unsupported
+        };
+
+        ModuleResolver();
+
+        /*
+         * The application root folder is the "app" folder in the application files directory.
+         */
+        void Init(const std::string& appRootFolderPath);
+
+        /*
+         * Resolves the module name, as passed to require() from a module in baseDir, to a canonical path.
+         * Sets the error message instead when the module is not found.
+         */
+        Resolution Resolve(const std::string& name, const std::string& baseDir, std::string& resolvedPath, std::string& errorMessage);
+
+        /*
+         * Drops the cached package.json entries, resolved paths and directory listings, e.g. after livesync
+         * changed the application files. Can be called from any thread, the caches are dropped by the next Resolve.
+         */
+        void Invalidate();
+
+        /*
+         * Extracts the top level "main" string from the content of a package.json file. Returns false
+         * if the content is not strict JSON or "main" is not a string.
+         */
+        static bool ParsePackageMain(const std::string& json, bool& hasMain, std::string& main);
+
+    private:
+        enum class EntryKind {
+            File,
+            Directory,
+            Other,
+            // a symbolic link or a file system which does not report the kind, stat-ed when first queried
+            Unknown
+        };
+
+        struct Directory {
+            std::unordered_map<std::string, EntryKind> entries;
+            bool isMounted;
+            // in nanoseconds, -1 when the folder may have changed in the same tick as it was listed
+            int64_t modificationTime;
+            // the number of the Resolve call which last checked the modification time
+            uint64_t checkedResolveCount;
+        };
+
+        struct Package {
+            bool isSupported;
+            bool hasMain;
+            std::string main;
+        };
+
+        /*
+         * Sets searchDir to the folder Module.resolvePath names in its error, the last one searched.
+         */
+        bool ResolveImpl(const std::string& name, const std::string& baseDir, std::string& foundPath, std::string& searchDir);
+
+        bool ResolveFromFileOrDirectory(const std::string& fileOrDirectory, std::string& foundPath, int depth);
+
+        bool LoadAsFile(const std::string& path, std::string& foundPath);
+
+        bool LoadAsDirectory(const std::string& path, std::string& foundPath, int depth);
+
+        void GetNodeModulesPaths(const std::string& startDir, std::vector<std::string>& paths);
+
+        bool Exists(const std::string& path);
+
+        bool IsFile(const std::string& path);
+
+        /*
+         * Returns false if the path does not exist.
+         */
+        bool GetEntryKind(const std::string& path, EntryKind& kind);
+
+        /*
+         * Returns nullptr if the directory does not exist.
+         */
+        Directory* GetDirectory(const std::string& dir);
+
+        bool ListDirectory(const std::string& dir, Directory& directory);
+
+        static bool GetModificationTime(const std::string& path, int64_t& modificationTime);
+
+        const Package& GetPackage(const std::string& packageFilePath);
+
+        /*
+         * Joins the paths the way java.io.File does, collapsing the duplicate and trailing separators.
+         */
+        static std::string JoinPath(const std::string& parent, const std::string& child);
+
+        static bool StartsWith(const std::string& str, const std::string& prefix);
+
+        static bool EndsWith(const std::string& str, const std::string& suffix);
+
+        std::string m_applicationFilesPath;
+
+        std::string m_modulesPath;
+
+        std::string m_nativeScriptModulesPath;
+
+        size_t m_rootDirsCount;
+
+        // set when the lookup reaches a case left to Module.resolvePath
+        bool m_isUnsupported;
+
+        uint64_t m_resolveCount;
+
+        std::atomic<bool> m_isInvalidated;
+
+        std::unordered_map<std::string, Directory> m_directories;
+
+        // the folders missing in the application package
+        std::unordered_set<std::string> m_missingMountedDirectories;
+
+        std::unordered_map<std::string, Package> m_packages;
+
+        // baseDir + "*" + name -> canonical path
+        std::unordered_map<std::string, std::string> m_resolved;
+
+        static const int MAX_PACKAGE_MAIN_DEPTH = 16;
+
+        // a listing made this close to the modification time of the folder may miss a file added in the same tick
+        static const int64_t RACY_LISTING_INTERVAL_NS = 2000000000LL;
+};
+}
+
+#endif /* MODULERESOLVER_H_ */
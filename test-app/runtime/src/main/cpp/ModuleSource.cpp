@@ -0,0 +1,66 @@
+#include "ModuleSource.h"
+#include "CodeCacheBundle.h"
+#include <cstring>
+
+using namespace v8;
+using namespace std;
+using namespace tns;
+
+unique_ptr<ModuleSource> ModuleSource::Open(const string& path) {
+    unique_ptr<ModuleSource> source(new ModuleSource(path));
+    if (!source->m_file.IsOpen()) {
+        return nullptr;
+    }
+
+    return source;
+}
+
+ModuleSource::ModuleSource(const string& path)
+    : m_file(path, m_buffer, FileAccess::Sequential), m_isAscii(IsAscii(m_file.Data(), m_file.Size())),
+      m_hash(CodeCacheBundle::Hash(m_file.Data(), m_file.Size())) {
+}
+
+const char* ModuleSource::data() const {
+    return m_file.Data();
+}
+
+size_t ModuleSource::length() const {
+    return m_file.Size();
+}
+
+uint64_t ModuleSource::GetHash() const {
+    return m_hash;
+}
+
+bool ModuleSource::IsAscii() const {
+    return m_isAscii;
+}
+
+MaybeLocal<String> ModuleSource::ToV8String(Isolate* isolate, unique_ptr<ModuleSource> source) {
+    if (source->m_isAscii && source->length() <= static_cast<size_t>(String::kMaxLength)) {
+        return String::NewExternalOneByte(isolate, source.release());
+    }
+
+    return String::NewFromUtf8(isolate, source->data(), NewStringType::kNormal, static_cast<int>(source->length()));
+}
+
+bool ModuleSource::IsAscii(const char* data, size_t length) {
+    static const uint64_t highBits = 0x8080808080808080ull;
+
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= length; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if ((word & highBits) != 0) {
+            return false;
+        }
+    }
+
+    for (; i < length; i++) {
+        if (static_cast<unsigned char>(data[i]) >= 0x80) {
+            return false;
+        }
+    }
+
+    return true;
+}
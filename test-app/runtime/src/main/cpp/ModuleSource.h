@@ -0,0 +1,55 @@
+#ifndef MODULESOURCE_H_
+#define MODULESOURCE_H_
+
+#include "v8.h"
+#include "File.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tns {
+/*
+ * The content of a module file, mapped into memory or read into a buffer of its own when small.
+ *
+ * An ASCII source is handed to V8 as an external one-byte string over the content, so it is
+ * neither copied nor decoded, and the content lives as long as the string. Other sources are
+ * decoded from UTF-8, as the one-byte strings of V8 are Latin-1.
+ */
+class ModuleSource : public v8::String::ExternalOneByteStringResource {
+    public:
+        /*
+         * Returns nullptr if the file cannot be read.
+         */
+        static std::unique_ptr<ModuleSource> Open(const std::string& path);
+
+        const char* data() const override;
+
+        size_t length() const override;
+
+        uint64_t GetHash() const;
+
+        bool IsAscii() const;
+
+        /*
+         * Creates the V8 string of the source. An ASCII source is owned by the string afterwards.
+         */
+        static v8::MaybeLocal<v8::String> ToV8String(v8::Isolate* isolate, std::unique_ptr<ModuleSource> source);
+
+    private:
+        ModuleSource(const std::string& path);
+
+        static bool IsAscii(const char* data, size_t length);
+
+        // holds the content of the small files, declared before the file reading into it
+        std::vector<char> m_buffer;
+
+        MappedFile m_file;
+
+        bool m_isAscii;
+
+        uint64_t m_hash;
+};
+}
+
+#endif /* MODULESOURCE_H_ */
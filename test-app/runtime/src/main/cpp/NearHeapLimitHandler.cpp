@@ -0,0 +1,124 @@
+#include "NearHeapLimitHandler.h"
+#include "NativeScriptAssert.h"
+#include "NativeScriptException.h"
+#include "ObjectManager.h"
+#include "Profiler.h"
+#include "RuntimeStats.h"
+#include <sstream>
+
+using namespace v8;
+using namespace std;
+using namespace tns;
+
+NearHeapLimitHandler::NearHeapLimitHandler()
+    :
+    m_isolate(nullptr), m_javaRuntime(nullptr), m_objectManager(nullptr), m_writeHeapSnapshot(false),
+    m_isReclaimPending(false), m_raiseCount(0), m_initialHeapLimit(0),
+    SYSTEM_CLASS(nullptr), SYSTEM_GC_METHOD_ID(nullptr) {
+}
+
+void NearHeapLimitHandler::Init(Isolate* isolate, jobject javaRuntime, ObjectManager* objectManager, const string& appName, const string& snapshotDir) {
+    m_isolate = isolate;
+    m_javaRuntime = javaRuntime;
+    m_objectManager = objectManager;
+    m_appName = appName;
+    m_snapshotDir = snapshotDir;
+
+    JEnv env;
+    auto runtimeClass = env.FindClass("com/tns/Runtime");
+    assert(runtimeClass != nullptr);
+
+    auto getHeapSnapshotNearHeapLimitMethodID = env.GetMethodID(runtimeClass, "getHeapSnapshotNearHeapLimit", "()Z");
+    assert(getHeapSnapshotNearHeapLimitMethodID != nullptr);
+    m_writeHeapSnapshot = env.CallBooleanMethod(m_javaRuntime, getHeapSnapshotNearHeapLimitMethodID) == JNI_TRUE;
+
+    SYSTEM_CLASS = env.FindClass("java/lang/System");
+    assert(SYSTEM_CLASS != nullptr);
+
+    SYSTEM_GC_METHOD_ID = env.GetStaticMethodID(SYSTEM_CLASS, "gc", "()V");
+    assert(SYSTEM_GC_METHOD_ID != nullptr);
+
+    isolate->AddNearHeapLimitCallback(NearHeapLimitCallback, this);
+}
+
+size_t NearHeapLimitHandler::NearHeapLimitCallback(void* data, size_t currentHeapLimit, size_t initialHeapLimit) {
+    auto thiz = static_cast<NearHeapLimitHandler*>(data);
+    return thiz->OnNearHeapLimit(currentHeapLimit, initialHeapLimit);
+}
+
+void NearHeapLimitHandler::ReclaimInterruptCallback(Isolate* isolate, void* data) {
+    try {
+        auto thiz = static_cast<NearHeapLimitHandler*>(data);
+        thiz->Reclaim();
+    } catch (NativeScriptException& e) {
+        e.ReThrowToV8();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToV8();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToV8();
+    }
+}
+
+/*
+ * Called by V8 in the middle of a GC, so no JavaScript can run, no other GC can be started
+ * and Java is not called here.
+ * */
+size_t NearHeapLimitHandler::OnNearHeapLimit(size_t currentHeapLimit, size_t initialHeapLimit) {
+    RUNTIME_STATS_INCREMENT(m_isolate, NearHeapLimitEvents);
+
+    DEBUG_WRITE_FORCE("JS heap is near its limit: limit=%zu, initial limit=%zu, raised %d time(s)",
+                      currentHeapLimit, initialHeapLimit, m_raiseCount);
+
+    if (m_raiseCount >= MAX_HEAP_LIMIT_RAISES) {
+        if (m_writeHeapSnapshot) {
+            // disabled before taking the snapshot, as it allocates and may get here again
+            m_writeHeapSnapshot = false;
+            bool success = Profiler::WriteHeapSnapshot(m_isolate, m_appName, m_snapshotDir);
+            DEBUG_WRITE_FORCE("JS heap snapshot %s written to %s", success ? "was" : "was not", m_snapshotDir.c_str());
+        }
+
+        return currentHeapLimit;
+    }
+
+    m_initialHeapLimit = initialHeapLimit;
+    m_raiseCount++;
+
+    if (!m_isReclaimPending) {
+        m_isReclaimPending = true;
+        m_isolate->RequestInterrupt(ReclaimInterruptCallback, this);
+    }
+
+    return currentHeapLimit + initialHeapLimit / 2;
+}
+
+void NearHeapLimitHandler::Reclaim() {
+    if (!m_isReclaimPending) {
+        return;
+    }
+
+    RUNTIME_STATS_INCREMENT(m_isolate, HeapReclaims);
+
+    m_isolate->LowMemoryNotification();
+    m_objectManager->FinishPendingMarking();
+
+    JEnv env;
+    env.CallStaticVoidMethod(SYSTEM_CLASS, SYSTEM_GC_METHOD_ID);
+
+    m_isolate->LowMemoryNotification();
+    m_objectManager->FinishPendingMarking();
+
+    HeapStatistics stats;
+    m_isolate->GetHeapStatistics(&stats);
+    DEBUG_WRITE_FORCE("JS heap reclaimed: used=%zu, limit=%zu", stats.used_heap_size(), stats.heap_size_limit());
+
+    // V8 does not restore a limit lower than the live objects need
+    m_isolate->RemoveNearHeapLimitCallback(NearHeapLimitCallback, m_initialHeapLimit);
+    m_isolate->AddNearHeapLimitCallback(NearHeapLimitCallback, this);
+
+    m_raiseCount = 0;
+    m_isReclaimPending = false;
+}
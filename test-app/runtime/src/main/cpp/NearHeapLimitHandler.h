@@ -0,0 +1,69 @@
+#ifndef NEARHEAPLIMITHANDLER_H_
+#define NEARHEAPLIMITHANDLER_H_
+
+#include "v8.h"
+#include "JEnv.h"
+#include <string>
+
+namespace tns {
+class ObjectManager;
+
+/*
+ * Keeps the isolate alive when its heap gets close to the limit because of memory that is
+ * actually held through Java references.
+ *
+ * The limit is raised temporarily and a coordinated collection is requested as an interrupt, so it runs
+ * on the JS thread at the next safe point, even in the middle of a long running script:
+ * a full JS GC, after which the ObjectManager makes the Java instances unreachable from JS weak,
+ * a Java GC, and a second full JS GC which releases the JS objects of the collected Java instances.
+ * The original limit is restored afterwards.
+ *
+ * Until then the heap may grow by at most MAX_HEAP_LIMIT_RAISES * initial limit / 2 over the initial limit.
+ * If the limit is reached again before the collection runs, the process is let die, optionally after
+ * writing a heap snapshot.
+ */
+class NearHeapLimitHandler {
+    public:
+        NearHeapLimitHandler();
+
+        void Init(v8::Isolate* isolate, jobject javaRuntime, ObjectManager* objectManager, const std::string& appName, const std::string& snapshotDir);
+
+    private:
+        static size_t NearHeapLimitCallback(void* data, size_t currentHeapLimit, size_t initialHeapLimit);
+
+        static void ReclaimInterruptCallback(v8::Isolate* isolate, void* data);
+
+        /*
+         * Runs the coordinated collection, on the JS thread.
+         */
+        void Reclaim();
+
+        size_t OnNearHeapLimit(size_t currentHeapLimit, size_t initialHeapLimit);
+
+        v8::Isolate* m_isolate;
+
+        jobject m_javaRuntime;
+
+        ObjectManager* m_objectManager;
+
+        std::string m_appName;
+
+        std::string m_snapshotDir;
+
+        bool m_writeHeapSnapshot;
+
+        bool m_isReclaimPending;
+
+        int m_raiseCount;
+
+        size_t m_initialHeapLimit;
+
+        static const int MAX_HEAP_LIMIT_RAISES = 2;
+
+        jclass SYSTEM_CLASS;
+
+        jmethodID SYSTEM_GC_METHOD_ID;
+};
+}
+
+#endif /* NEARHEAPLIMITHANDLER_H_ */
@@ -14,6 +14,17 @@ using namespace tns;
 void NumericCasts::CreateGlobalCastFunctions(Isolate* isolate, const Local<ObjectTemplate>& globalTemplate) {
     auto ext = External::New(isolate, this);
 
+    auto castTemplate = FunctionTemplate::New(isolate);
+    castTemplate->InstanceTemplate()->SetInternalFieldCount(static_cast<int>(CastKeys::END));
+    castTemplate->InstanceTemplate()->Set(V8StringConstants::GetValue(isolate), Undefined(isolate));
+
+    auto itFound = s_castTemplateCache.find(isolate);
+    if (itFound != s_castTemplateCache.end()) {
+        itFound->second->Reset(isolate, castTemplate);
+    } else {
+        s_castTemplateCache.insert(make_pair(isolate, new Persistent<FunctionTemplate>(isolate, castTemplate)));
+    }
+
     globalTemplate->Set(ArgConverter::ConvertToV8String(isolate, "long"), FunctionTemplate::New(isolate, NumericCasts::MarkAsLongCallbackStatic, ext));
     globalTemplate->Set(ArgConverter::ConvertToV8String(isolate, "byte"), FunctionTemplate::New(isolate, NumericCasts::MarkAsByteCallbackStatic, ext));
     globalTemplate->Set(ArgConverter::ConvertToV8String(isolate, "short"), FunctionTemplate::New(isolate, NumericCasts::MarkAsShortCallbackStatic, ext));
@@ -24,12 +35,18 @@ void NumericCasts::CreateGlobalCastFunctions(Isolate* isolate, const Local<Objec
 
 CastType NumericCasts::GetCastType(Isolate* isolate, const Local<Object>& object) {
     auto ret = CastType::None;
-    auto key = ArgConverter::ConvertToV8String(isolate, s_castMarker);
-    Local<Value> hidden;
-    V8GetPrivateValue(isolate, object, key, hidden);
-    if (!hidden.IsEmpty()) {
-        auto context = isolate->GetCurrentContext();
-        ret = static_cast<CastType>(hidden->Int32Value(context).ToChecked());
+    if (object->InternalFieldCount() != static_cast<int>(CastKeys::END)) {
+        return ret;
+    }
+
+    auto itFound = s_castTemplateCache.find(isolate);
+    if (itFound == s_castTemplateCache.end() || !Local<FunctionTemplate>::New(isolate, *itFound->second)->HasInstance(object)) {
+        return ret;
+    }
+
+    auto castType = object->GetInternalField(static_cast<int>(CastKeys::Type));
+    if (!castType.IsEmpty() && castType->IsInt32()) {
+        ret = static_cast<CastType>(castType.As<Int32>()->Value());
     }
 
     return ret;
@@ -47,6 +64,35 @@ void NumericCasts::MarkAsLong(Isolate* isolate, const v8::Local<v8::Object>& obj
     MarkJsObject(isolate, object, CastType::Long, value);
 }
 
+void NumericCasts::InheritCastTemplate(Isolate* isolate, const Local<FunctionTemplate>& functionTemplate) {
+    auto itFound = s_castTemplateCache.find(isolate);
+    assert(itFound != s_castTemplateCache.end());
+
+    functionTemplate->Inherit(Local<FunctionTemplate>::New(isolate, *itFound->second));
+    functionTemplate->InstanceTemplate()->SetInternalFieldCount(static_cast<int>(CastKeys::END));
+}
+
+void NumericCasts::onDisposeIsolate(Isolate* isolate) {
+    auto itFound = s_castTemplateCache.find(isolate);
+    if (itFound != s_castTemplateCache.end()) {
+        itFound->second->Reset();
+        delete itFound->second;
+        s_castTemplateCache.erase(itFound);
+    }
+}
+
+Local<Object> NumericCasts::NewCastObject(Isolate* isolate, CastType castType, const Local<Value>& value) {
+    auto itFound = s_castTemplateCache.find(isolate);
+    assert(itFound != s_castTemplateCache.end());
+
+    auto context = isolate->GetCurrentContext();
+    auto castTemplate = Local<FunctionTemplate>::New(isolate, *itFound->second);
+    auto cast = castTemplate->InstanceTemplate()->NewInstance(context).ToLocalChecked();
+    MarkJsObject(isolate, cast, castType, value);
+
+    return cast;
+}
+
 NumericCasts* NumericCasts::GetThis(const v8::FunctionCallbackInfo<Value>& args) {
     auto ext = args.Data().As<External>();
 
@@ -182,8 +228,7 @@ void NumericCasts::MarkAsLongCallback(const v8::FunctionCallbackInfo<Value>& arg
             value = args[0]->ToString(context).ToLocalChecked();
         }
 
-        auto cast = Object::New(isolate);
-        MarkJsObject(isolate, cast, CastType::Long, value);
+        auto cast = NewCastObject(isolate, CastType::Long, value);
         args.GetReturnValue().Set(cast);
     } catch (NativeScriptException& e) {
         e.ReThrowToV8();
@@ -217,8 +262,7 @@ void NumericCasts::MarkAsByteCallback(const v8::FunctionCallbackInfo<Value>& arg
             value = args[0]->ToString(context).ToLocalChecked();
         }
 
-        auto cast = Object::New(isolate);
-        MarkJsObject(isolate, cast, CastType::Byte, value);
+        auto cast = NewCastObject(isolate, CastType::Byte, value);
         args.GetReturnValue().Set(cast);
     } catch (NativeScriptException& e) {
         e.ReThrowToV8();
@@ -253,8 +297,7 @@ void NumericCasts::MarkAsShortCallback(const v8::FunctionCallbackInfo<Value>& ar
             value = args[0]->ToString(context).ToLocalChecked();
         }
 
-        auto cast = Object::New(isolate);
-        MarkJsObject(isolate, cast, CastType::Short, value);
+        auto cast = NewCastObject(isolate, CastType::Short, value);
         args.GetReturnValue().Set(cast);
     } catch (NativeScriptException& e) {
         e.ReThrowToV8();
@@ -286,8 +329,7 @@ void NumericCasts::MarkAsCharCallback(const v8::FunctionCallbackInfo<Value>& arg
             throw NativeScriptException(string("char(x) should be called with single parameter containing a single char"));
         }
 
-        auto cast = Object::New(isolate);
-        MarkJsObject(isolate, cast, CastType::Char, value);
+        auto cast = NewCastObject(isolate, CastType::Char, value);
         args.GetReturnValue().Set(cast);
     } catch (NativeScriptException& e) {
         e.ReThrowToV8();
@@ -315,8 +357,7 @@ void NumericCasts::MarkAsFloatCallback(const v8::FunctionCallbackInfo<Value>& ar
 
         auto context = isolate->GetCurrentContext();
         auto value = args[0]->ToNumber(context).ToLocalChecked();
-        auto cast = Object::New(isolate);
-        MarkJsObject(isolate, cast, CastType::Float, value);
+        auto cast = NewCastObject(isolate, CastType::Float, value);
         args.GetReturnValue().Set(cast);
     } catch (NativeScriptException& e) {
         e.ReThrowToV8();
@@ -344,8 +385,7 @@ void NumericCasts::MarkAsDoubleCallback(const v8::FunctionCallbackInfo<Value>& a
 
         auto context = isolate->GetCurrentContext();
         auto value = args[0]->ToNumber(context).ToLocalChecked();
-        auto cast = Object::New(isolate);
-        MarkJsObject(isolate, cast, CastType::Double, value);
+        auto cast = NewCastObject(isolate, CastType::Double, value);
         args.GetReturnValue().Set(cast);
     } catch (NativeScriptException& e) {
         e.ReThrowToV8();
@@ -361,13 +401,14 @@ void NumericCasts::MarkAsDoubleCallback(const v8::FunctionCallbackInfo<Value>& a
 }
 
 void NumericCasts::MarkJsObject(Isolate* isolate, const Local<Object>& object, CastType castType, const Local<Value>& value) {
-    auto key = ArgConverter::ConvertToV8String(isolate, s_castMarker);
+    assert(object->InternalFieldCount() == static_cast<int>(CastKeys::END));
+
     auto type = Integer::New(isolate, static_cast<int>(castType));
-    V8SetPrivateValue(isolate, object, key, type);
-    auto context = object->CreationContext();
+    object->SetInternalField(static_cast<int>(CastKeys::Type), type);
+    auto context = isolate->GetCurrentContext();
     object->Set(context, V8StringConstants::GetValue(isolate), value);
 
     DEBUG_WRITE("MarkJsObject: Marking js object: %d with cast type: %d", object->GetIdentityHash(), castType);
 }
 
-std::string NumericCasts::s_castMarker = "t::cast";
+std::map<Isolate*, Persistent<FunctionTemplate>*> NumericCasts::s_castTemplateCache;
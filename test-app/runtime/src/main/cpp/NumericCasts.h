@@ -3,6 +3,7 @@
 
 #include "v8.h"
 #include <string>
+#include <map>
 
 namespace tns {
 enum class CastType {
@@ -25,7 +26,23 @@ class NumericCasts {
 
         static void MarkAsLong(v8::Isolate* isolate, const v8::Local<v8::Object>& object, const v8::Local<v8::Value>& value);
 
+        /*
+         * Cast objects (and NativeScriptLongNumber instances) are created from templates with a single internal field
+         * holding the CastType. This lets the cast be recognized without a private property lookup. Makes the
+         * instances of the function template casts as well.
+         */
+        static void InheritCastTemplate(v8::Isolate* isolate, const v8::Local<v8::FunctionTemplate>& functionTemplate);
+
+        static void onDisposeIsolate(v8::Isolate* isolate);
+
     private:
+        enum class CastKeys {
+            Type,
+            END
+        };
+
+        static v8::Local<v8::Object> NewCastObject(v8::Isolate* isolate, CastType castType, const v8::Local<v8::Value>& value);
+
         void MarkAsLongCallback(const v8::FunctionCallbackInfo<v8::Value>& args);
 
         void MarkAsByteCallback(const v8::FunctionCallbackInfo<v8::Value>& args);
@@ -54,7 +71,12 @@ class NumericCasts {
 
         static NumericCasts* GetThis(const v8::FunctionCallbackInfo<v8::Value>& args);
 
-        static std::string s_castMarker;
+        /*
+         * "s_castTemplateCache" holds the per-isolate template used to instantiate the cast objects.
+         * The template declares the "value" property up front so all cast objects share the same shape.
+         * Other API objects may have a single internal field as well, so the casts are told apart by it.
+         */
+        static std::map<v8::Isolate*, v8::Persistent<v8::FunctionTemplate>*> s_castTemplateCache;
 };
 }
 
@@ -12,6 +12,7 @@
 #include <algorithm>
 #include <sstream>
 #include "ManualInstrumentation.h"
+#include "RuntimeStats.h"
 
 using namespace v8;
 using namespace std;
@@ -20,7 +21,6 @@ using namespace tns;
 ObjectManager::ObjectManager(jobject javaRuntimeObject) :
         m_javaRuntimeObject(javaRuntimeObject),
         m_numberOfGC(0),
-        m_currentObjectId(0),
         m_cache(NewWeakGlobalRefCallback, DeleteWeakGlobalRefCallback, 1000, this) {
 
     JEnv env;
@@ -36,23 +36,19 @@ ObjectManager::ObjectManager(jobject javaRuntimeObject) :
                                                                "(Ljava/lang/Object;)I");
     assert(GET_OR_CREATE_JAVA_OBJECT_ID_METHOD_ID != nullptr);
 
-    MAKE_INSTANCE_WEAK_BATCH_METHOD_ID = env.GetMethodID(runtimeClass, "makeInstanceWeak",
-                                                           "(Ljava/nio/ByteBuffer;IZ)V");
-    assert(MAKE_INSTANCE_WEAK_BATCH_METHOD_ID != nullptr);
-
-    MAKE_INSTANCE_WEAK_AND_CHECK_IF_ALIVE_METHOD_ID = env.GetMethodID(runtimeClass,
-                                                                        "makeInstanceWeakAndCheckIfAlive",
-                                                                        "(I)Z");
-    assert(MAKE_INSTANCE_WEAK_AND_CHECK_IF_ALIVE_METHOD_ID != nullptr);
+    GENERATE_NEW_OBJECT_ID_METHOD_ID = env.GetMethodID(runtimeClass, "generateNewObjectId", "()I");
+    assert(GENERATE_NEW_OBJECT_ID_METHOD_ID != nullptr);
 
     RELEASE_NATIVE_INSTANCE_METHOD_ID = env.GetMethodID(runtimeClass, "releaseNativeCounterpart",
                                                           "(I)V");
     assert(RELEASE_NATIVE_INSTANCE_METHOD_ID != nullptr);
 
-    CHECK_WEAK_OBJECTS_ARE_ALIVE_METHOD_ID = env.GetMethodID(runtimeClass,
-                                                               "checkWeakObjectAreAlive",
-                                                               "(Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;I)V");
-    assert(CHECK_WEAK_OBJECTS_ARE_ALIVE_METHOD_ID != nullptr);
+    PROCESS_GC_HANDSHAKE_METHOD_ID = env.GetMethodID(runtimeClass, "processGcHandshake",
+                                                       "(Ljava/nio/ByteBuffer;II)V");
+    assert(PROCESS_GC_HANDSHAKE_METHOD_ID != nullptr);
+
+    SCHEDULE_MARKING_SLICE_METHOD_ID = env.GetMethodID(runtimeClass, "scheduleMarkingSlice", "()V");
+    assert(SCHEDULE_MARKING_SLICE_METHOD_ID != nullptr);
 
     JAVA_LANG_CLASS = env.FindClass("java/lang/Class");
     assert(JAVA_LANG_CLASS != nullptr);
@@ -70,6 +66,11 @@ ObjectManager::ObjectManager(jobject javaRuntimeObject) :
                                                            "()I");
     jint markingMode = env.CallIntMethod(m_javaRuntimeObject, getMarkingModeOrdinalMethodID);
     m_markingMode = static_cast<JavaScriptMarkingMode>(markingMode);
+
+    auto getMarkingTimeSliceMethodID = env.GetMethodID(runtimeClass, "getMarkingTimeSlice", "()I");
+    m_markingTimeSliceMs = env.CallIntMethod(m_javaRuntimeObject, getMarkingTimeSliceMethodID);
+
+    m_implObjectTracer = nullptr;
 }
 
 void ObjectManager::SetInstanceIsolate(Isolate *isolate) {
@@ -84,9 +85,21 @@ void ObjectManager::Init(Isolate *isolate) {
     auto jsWrapperFunc = jsWrapperFuncTemplate->GetFunction(context).ToLocalChecked();
     m_poJsWrapperFunc = new Persistent<Function>(isolate, jsWrapperFunc);
 
-    if (m_markingMode != JavaScriptMarkingMode::None) {
+    if (m_markingMode == JavaScriptMarkingMode::None) {
+        isolate->AddGCEpilogueCallback(ObjectManager::OnFinalizingGcFinishedStatic, kGCTypeAll);
+    } else {
         isolate->AddGCPrologueCallback(ObjectManager::OnGcStartedStatic, kGCTypeMarkSweepCompact);
         isolate->AddGCEpilogueCallback(ObjectManager::OnGcFinishedStatic, kGCTypeMarkSweepCompact);
+
+        if (m_markingTimeSliceMs > 0) {
+            // scavenges move objects, which invalidates the addresses tracked by a pending marking
+            isolate->AddGCPrologueCallback(ObjectManager::OnMinorGcStartedStatic, kGCTypeScavenge);
+        }
+    }
+
+    if (m_markingMode == JavaScriptMarkingMode::Tracing) {
+        m_implObjectTracer = new ImplObjectTracer(this);
+        isolate->SetEmbedderHeapTracer(m_implObjectTracer);
     }
 }
 
@@ -151,6 +164,8 @@ bool ObjectManager::IsJsRuntimeObject(const v8::Local<v8::Object> &object) {
 }
 
 jweak ObjectManager::GetJavaObjectByID(uint32_t javaObjectID) {
+    RUNTIME_STATS_INCREMENT(m_isolate, JavaObjectCacheLookups);
+
     jweak obj = m_cache(javaObjectID);
 
     return obj;
@@ -164,6 +179,7 @@ jobject ObjectManager::GetJavaObjectByIDImpl(uint32_t javaObjectID) {
 }
 
 void ObjectManager::UpdateCache(int objectID, jobject obj) {
+    RUNTIME_STATS_INCREMENT(m_isolate, JavaObjectCacheUpdates);
     m_cache.update(objectID, obj);
 }
 
@@ -193,14 +209,18 @@ Local<Object> ObjectManager::GetJsObjectByJavaObject(int javaObjectID) {
     auto isolate = m_isolate;
     EscapableHandleScope handleScope(isolate);
 
-    auto it = m_idToObject.find(javaObjectID);
-    if (it == m_idToObject.end()) {
+    Persistent<Object> *jsObject = m_idToObject.Get(javaObjectID);
+    if (jsObject == nullptr) {
         return handleScope.Escape(Local<Object>());
     }
 
-    Persistent<Object> *jsObject = it->second;
-
     auto localObject = Local<Object>::New(isolate, *jsObject);
+
+    if (m_incrementalMarking.isPending) {
+        // write barrier: the object may become reachable from JS again before the marking is finished
+        MarkTouchedObject(javaObjectID, localObject);
+    }
+
     return handleScope.Escape(localObject);
 }
 
@@ -250,10 +270,10 @@ void ObjectManager::Link(const Local<Object> &object, uint32_t javaObjectID, jcl
     DEBUG_WRITE("Linking js object: %d and java instance id: %d", object->GetIdentityHash(),
                 javaObjectID);
 
-    auto jsInstanceInfo = new JSInstanceInfo(false/*isJavaObjWeak*/, javaObjectID, clazz);
+    auto jsInstanceInfo = m_jsInstanceInfoPool.New(false/*isJavaObjWeak*/, javaObjectID, clazz);
 
-    auto objectHandle = new Persistent<Object>(isolate, object);
-    auto state = new ObjectWeakCallbackState(this, jsInstanceInfo, objectHandle);
+    auto state = m_callbackStatePool.New(this, jsInstanceInfo, isolate, object);
+    auto objectHandle = &state->target;
 
     // subscribe for JS GC event
     if (m_markingMode == JavaScriptMarkingMode::None) {
@@ -269,7 +289,9 @@ void ObjectManager::Link(const Local<Object> &object, uint32_t javaObjectID, jcl
     //link
     object->SetInternalField(jsInfoIdx, jsInfo);
 
-    m_idToObject.insert(make_pair(javaObjectID, objectHandle));
+    m_idToObject.Insert(javaObjectID, objectHandle);
+
+    RUNTIME_STATS_INCREMENT(isolate, ObjectsLinked);
 }
 
 bool ObjectManager::CloneLink(const Local<Object> &src, const Local<Object> &dest) {
@@ -327,34 +349,85 @@ void ObjectManager::JSObjectFinalizerStatic(const WeakCallbackInfo<ObjectWeakCal
 
 void ObjectManager::JSObjectFinalizer(Isolate *isolate, ObjectWeakCallbackState *callbackState) {
     HandleScope handleScope(m_isolate);
-    Persistent<Object> *po = callbackState->target;
+    Persistent<Object> *po = &callbackState->target;
     auto jsInstanceInfo = GetJSInstanceInfoFromRuntimeObject(po->Get(m_isolate));
 
     if (jsInstanceInfo == nullptr) {
         po->Reset();
-        delete po;
-        delete callbackState;
+        m_callbackStatePool.Delete(callbackState);
         return;
     }
 
-    auto javaObjectID = jsInstanceInfo->JavaObjectID;
-    JEnv env;
-    jboolean isJavaInstanceAlive = env.CallBooleanMethod(m_javaRuntimeObject,
-                                                           MAKE_INSTANCE_WEAK_AND_CHECK_IF_ALIVE_METHOD_ID,
-                                                           javaObjectID);
-    if (isJavaInstanceAlive) {
-        // If the Java instance is alive, keep the JavaScript instance alive.
-        po->SetWeak(callbackState, JSObjectFinalizerStatic, WeakCallbackType::kFinalizer);
-    } else {
-        // If the Java instance is dead, this JavaScript instance can be let die.
-        delete jsInstanceInfo;
-        auto jsInfoIdx = static_cast<int>(MetadataNodeKeys::JsInfo);
-        po->Get(m_isolate)->SetInternalField(jsInfoIdx, Undefined(m_isolate));
-        po->Reset();
-        m_idToObject.erase(javaObjectID);
-        delete po;
-        delete callbackState;
+    // Keep the JavaScript instance alive until Java is asked about it, together with the rest of the
+    // instances finalized in this GC, in FlushPendingFinalizations.
+    po->ClearWeak();
+    m_pendingFinalizations.emplace_back(callbackState, jsInstanceInfo);
+}
+
+void ObjectManager::OnFinalizingGcFinishedStatic(Isolate *isolate, GCType type, GCCallbackFlags flags) {
+    try {
+        auto runtime = Runtime::GetRuntime(isolate);
+        auto objectManager = runtime->GetObjectManager();
+        objectManager->FlushPendingFinalizations();
+    } catch (NativeScriptException &e) {
+        e.ReThrowToV8();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToV8();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToV8();
+    }
+}
+
+/*
+ * Makes the Java counterparts of the instances finalized in the last GC weak with a single call to Java.
+ * The JavaScript instances whose Java instances are alive are made weak again, the rest are released.
+ * */
+void ObjectManager::FlushPendingFinalizations() {
+    if (m_pendingFinalizations.empty()) {
+        return;
+    }
+
+    TNSPERF();
+    RUNTIME_STATS_TIMER(m_isolate, PendingFinalizationsFlush);
+    RUNTIME_STATS_ADD(m_isolate, PendingFinalizations, m_pendingFinalizations.size());
+    HandleScope handleScope(m_isolate);
+
+    for (const auto &pending : m_pendingFinalizations) {
+        m_handshake.Set(GcHandshakeBuffer::Bitmap::MakeWeakAndCheckAlive, pending.jsInfo->JavaObjectID);
+    }
+
+    ProcessGcHandshake(m_handshake);
+
+    auto jsInfoIdx = static_cast<int>(MetadataNodeKeys::JsInfo);
+
+    for (const auto &pending : m_pendingFinalizations) {
+        auto callbackState = pending.callbackState;
+        auto jsInstanceInfo = pending.jsInfo;
+        Persistent<Object> *po = &callbackState->target;
+
+        bool isJavaInstanceAlive = !m_handshake.IsSet(GcHandshakeBuffer::Bitmap::MakeWeakAndCheckAlive, jsInstanceInfo->JavaObjectID);
+        if (isJavaInstanceAlive) {
+            // If the Java instance is alive, keep the JavaScript instance alive.
+            po->SetWeak(callbackState, JSObjectFinalizerStatic, WeakCallbackType::kFinalizer);
+        } else {
+            // If the Java instance is dead, this JavaScript instance can be let die.
+            auto javaObjectID = jsInstanceInfo->JavaObjectID;
+            m_jsInstanceInfoPool.Delete(jsInstanceInfo);
+            po->Get(m_isolate)->SetInternalField(jsInfoIdx, Undefined(m_isolate));
+            po->Reset();
+            m_idToObject.Remove(javaObjectID);
+            m_cache.erase(javaObjectID);
+            m_callbackStatePool.Delete(callbackState);
+            RUNTIME_STATS_INCREMENT(m_isolate, ObjectsUnlinked);
+        }
     }
+
+    m_pendingFinalizations.clear();
+    m_handshake.Reset();
 }
 
 /*
@@ -368,12 +441,11 @@ void ObjectManager::JSObjectFinalizer(Isolate *isolate, ObjectWeakCallbackState
 void ObjectManager::JSObjectWeakCallback(Isolate *isolate, ObjectWeakCallbackState *callbackState) {
     HandleScope handleScope(isolate);
 
-    Persistent<Object> *po = callbackState->target;
+    Persistent<Object> *po = &callbackState->target;
 
-    auto itFound = m_visitedPOs.find(po);
-
-    if (itFound == m_visitedPOs.end()) {
-        m_visitedPOs.insert(po);
+    if (!callbackState->isVisited) {
+        callbackState->isVisited = true;
+        m_visitedStates.push_back(callbackState);
 
         auto obj = Local<Object>::New(isolate, *po);
         JSInstanceInfo *jsInstanceInfo = GetJSInstanceInfo(obj);
@@ -412,32 +484,35 @@ void ObjectManager::JSObjectWeakCallback(Isolate *isolate, ObjectWeakCallbackSta
     po->SetWeak(callbackState, JSObjectWeakCallbackStatic, WeakCallbackType::kFinalizer);
 }
 
+/*
+ * The ids are allocated on the Java side, which reuses the ids of the released instances.
+ * */
 int ObjectManager::GenerateNewObjectID() {
-    const int one = 1;
-    int oldValue = __sync_fetch_and_add(&m_currentObjectId, one);
-
-    return oldValue;
+    JEnv env;
+    return env.CallIntMethod(m_javaRuntimeObject, GENERATE_NEW_OBJECT_ID_METHOD_ID);
 }
 
 void ObjectManager::ReleaseJSInstance(Persistent<Object> *po, JSInstanceInfo *jsInstanceInfo) {
     int javaObjectID = jsInstanceInfo->JavaObjectID;
 
-    auto it = m_idToObject.find(javaObjectID);
+    auto linkedObject = m_idToObject.Get(javaObjectID);
 
-    if (it == m_idToObject.end()) {
+    if (linkedObject == nullptr) {
         stringstream ss;
         ss << "(InternalError): Js object with id: " << javaObjectID << " not found";
         throw NativeScriptException(ss.str());
     }
 
-    assert(po == it->second);
+    assert(po == linkedObject);
 
-    m_idToObject.erase(it);
-    m_released.insert(po, javaObjectID);
+    m_idToObject.Remove(javaObjectID);
+    m_cache.erase(javaObjectID);
+    ObjectWeakCallbackState::FromTarget(po)->isReleased = true;
+    m_released.push_back(PersistentObjectIdPair(po, javaObjectID));
     po->Reset();
 
-    delete po;
-    delete jsInstanceInfo;
+    m_jsInstanceInfoPool.Delete(jsInstanceInfo);
+    RUNTIME_STATS_INCREMENT(m_isolate, ObjectsUnlinked);
 
     DEBUG_WRITE("ReleaseJSObject instance disposed. id:%d", javaObjectID);
 }
@@ -450,15 +525,12 @@ void ObjectManager::ReleaseRegularObjects() {
 
     HandleScope handleScope(m_isolate);
 
-    auto propName = String::NewFromUtf8(m_isolate, "t::gcNum",
-                                        NewStringType::kNormal).ToLocalChecked();
-
     auto &topGCInfo = m_markedForGC.top();
     auto &marked = topGCInfo.markedForGC;
     int numberOfGC = topGCInfo.numberOfGC;
 
     for (auto po : marked) {
-        if (m_released.contains(po)) {
+        if (ObjectWeakCallbackState::FromTarget(po)->isReleased) {
             continue;
         }
 
@@ -466,19 +538,14 @@ void ObjectManager::ReleaseRegularObjects() {
 
         assert(!obj.IsEmpty());
 
-        Local<Value> gcNum;
-        V8GetPrivateValue(m_isolate, obj, propName, gcNum);
-
-        bool isReachableFromImplementationObject = false;
-
-        if (!gcNum.IsEmpty() && gcNum->IsNumber()) {
-            double objGcNum = gcNum.As<Number>()->Value();
-
-            // done so we can release only java objects from this GC stack and pass all objects that will be released in parent GC stacks
-            isReachableFromImplementationObject = objGcNum >= numberOfGC;
+        JSInstanceInfo *jsInstanceInfo = GetJSInstanceInfo(obj);
+        if (jsInstanceInfo == nullptr) {
+            // the native counterpart was released while the marking was pending
+            continue;
         }
 
-        JSInstanceInfo *jsInstanceInfo = GetJSInstanceInfo(obj);
+        // done so we can release only java objects from this GC stack and pass all objects that will be released in parent GC stacks
+        bool isReachableFromImplementationObject = jsInstanceInfo->LastMarkedGC >= numberOfGC;
 
         if (!isReachableFromImplementationObject) {
             if (!jsInstanceInfo->IsJavaObjectWeak) {
@@ -492,6 +559,40 @@ void ObjectManager::ReleaseRegularObjects() {
     marked.clear();
 }
 
+/*
+ * Marks the object as visited in the current GC and returns false if it already was.
+ * A wrapper is marked by the id of its Java instance. Only the wrapper registered for the id may be,
+ * as the objects which inherit a wrapper through their prototype report the same id.
+ * */
+bool ObjectManager::MarkVisited(const Local<Object> &object, JSInstanceInfo *jsInfo) {
+    if (jsInfo != nullptr) {
+        int javaObjectID = jsInfo->JavaObjectID;
+        auto po = m_idToObject.Get(javaObjectID);
+        if ((po != nullptr) && (*po == object)) {
+            size_t wordIndex = static_cast<uint32_t>(javaObjectID) >> 6;
+            if (wordIndex >= m_visitedIds.size()) {
+                // an id allocated after the marking started
+                m_visitedIds.resize(max(wordIndex + 1, m_idToObject.Capacity() / 64), 0);
+            }
+
+            uint64_t bit = uint64_t(1) << (javaObjectID & 63);
+            if ((m_visitedIds[wordIndex] & bit) != 0) {
+                return false;
+            }
+            m_visitedIds[wordIndex] |= bit;
+            return true;
+        }
+    }
+
+    unsigned long addr = NativeScriptExtension::GetAddress(object);
+    return m_visited.insert(addr).second;
+}
+
+void ObjectManager::ClearVisited() {
+    m_visitedIds.assign(m_idToObject.Capacity() / 64, 0);
+    m_visited.clear();
+}
+
 bool ObjectManager::HasImplObject(Isolate *isolate, const Local<Object> &obj) {
     auto implObject = MetadataNode::GetImplementationObject(isolate, obj);
 
@@ -511,18 +612,41 @@ void ObjectManager::MarkReachableObjects(Isolate *isolate, const Local<Object> &
 
     s.push(obj);
 
-    auto propName = String::NewFromUtf8(isolate, "t::gcNum").ToLocalChecked();
+    auto fromJsInfo = GetJSInstanceInfo(obj);
+    auto fromId = fromJsInfo->JavaObjectID;
+
+    MarkReachableObjects(isolate, s, fromId, true, nullptr);
+
+    if (frame.check()) {
+        auto cls = fromJsInfo->ObjectClazz;
+        JEnv env;
+        JniLocalRef className(env.CallObjectMethod(cls, GET_NAME_METHOD_ID));
+        frame.log("MarkReachableObjects: " + ArgConverter::jstringToString(className));
+    }
+}
+
+/*
+ * Walks the objects on the stack "s" and everything reachable from them. When a deadline is passed the walk
+ * stops once it is reached and returns false, leaving the objects that are still to be visited on the stack.
+ * */
+bool ObjectManager::MarkReachableObjects(Isolate *isolate, stack<Local<Value>> &s, int fromId, bool isRootOnTop, const chrono::steady_clock::time_point *deadline) {
+    RUNTIME_STATS_TIMER(isolate, MarkReachableObjects);
+    RUNTIME_STATS_INCREMENT(isolate, MarkReachableObjectsRuns);
 
     assert(!m_markedForGC.empty());
     auto &topGCInfo = m_markedForGC.top();
     int numberOfGC = topGCInfo.numberOfGC;
-    auto fromJsInfo = GetJSInstanceInfo(obj);
-    auto fromId = fromJsInfo->JavaObjectID;
 
-    auto curGCNumValue = Integer::New(isolate, numberOfGC);
-    bool firstRun = true;
+    bool firstRun = isRootOnTop;
+    int processed = 0;
 
     while (!s.empty()) {
+        if ((deadline != nullptr) && (++processed % MARKING_DEADLINE_CHECK_INTERVAL == 0)) {
+            if (m_incrementalMarking.isRestartRequested || (chrono::steady_clock::now() >= *deadline)) {
+                return false;
+            }
+        }
+
         auto isInFirstRun = firstRun;
         firstRun = false;
 
@@ -534,17 +658,13 @@ void ObjectManager::MarkReachableObjects(Isolate *isolate, const Local<Object> &
         }
 
         auto o = top.As<Object>();
-        if (!isInFirstRun) {
-            unsigned long addr = NativeScriptExtension::GetAddress(o);
-            auto itFound = m_visited.find(addr);
-            if (itFound != m_visited.end()) {
-                continue;
-            }
-            m_visited.insert(
-                    addr); // set as processed only if the current object is not the object we are starting from
+        auto jsInfo = GetJSInstanceInfo(o);
+
+        // set as processed only if the current object is not the object we are starting from
+        if (!isInFirstRun && !MarkVisited(o, jsInfo)) {
+            continue;
         }
 
-        auto jsInfo = GetJSInstanceInfo(o);
         if ((jsInfo != nullptr) && (jsInfo->JavaObjectID != fromId)) {
             auto hasImplObject = HasImplObject(isolate, o);
             if (hasImplObject) {
@@ -554,7 +674,7 @@ void ObjectManager::MarkReachableObjects(Isolate *isolate, const Local<Object> &
                 m_implObjStrong[jsInfo->JavaObjectID] = nullptr;
             }
 
-            V8SetPrivateValue(isolate, o, propName, curGCNumValue);
+            jsInfo->LastMarkedGC = numberOfGC;
         }
 
         if (o->IsFunction()) {
@@ -635,12 +755,7 @@ void ObjectManager::MarkReachableObjects(Isolate *isolate, const Local<Object> &
 
     } // while
 
-    if (frame.check()) {
-        auto cls = fromJsInfo->ObjectClazz;
-        JEnv env;
-        JniLocalRef className(env.CallObjectMethod(cls, GET_NAME_METHOD_ID));
-        frame.log("MarkReachableObjects: " + ArgConverter::jstringToString(className));
-    }
+    return true;
 }
 
 void ObjectManager::MarkReachableArrayElements(Local<Object> &o, stack<Local<Value>> &s) {
@@ -706,9 +821,25 @@ void ObjectManager::OnGcFinishedStatic(Isolate *isolate, GCType type, GCCallback
     }
 }
 
+void ObjectManager::OnMinorGcStartedStatic(Isolate *isolate, GCType type, GCCallbackFlags flags) {
+    auto runtime = Runtime::GetRuntime(isolate);
+    auto objectManager = runtime->GetObjectManager();
+    auto &marking = objectManager->m_incrementalMarking;
+
+    if (marking.isPending) {
+        marking.isRestartRequested = true;
+    }
+}
+
 void ObjectManager::OnGcStarted(GCType type, GCCallbackFlags flags) {
     TNSPERF();
 
+    if (m_incrementalMarking.isPending) {
+        m_incrementalMarking.isRestartRequested = true;
+        // the objects touched from now on have to be marked for this GC too
+        ClearTouchedVisited();
+    }
+
     GarbageCollectionInfo gcInfo(++m_numberOfGC);
     m_markedForGC.push(gcInfo);
 }
@@ -719,68 +850,291 @@ void ObjectManager::OnGcStarted(GCType type, GCCallbackFlags flags) {
 void ObjectManager::OnGcFinished(GCType type, GCCallbackFlags flags) {
     assert(!m_markedForGC.empty());
 
+    RUNTIME_STATS_TIMER(m_isolate, GcFinished);
+    RUNTIME_STATS_INCREMENT(m_isolate, GcCycles);
+
+    if (m_implObjectTracer != nullptr) {
+        FinishTracedGcCycles();
+        return;
+    }
+
     //deal with all "callback" objects
-    auto isolate = m_isolate;
-    for (auto weakObj : m_implObjWeak) {
-        auto obj = Local<Object>::New(isolate, *weakObj.po);
-        MarkReachableObjects(isolate, obj);
+    auto &marking = m_incrementalMarking;
+    marking.roots.clear();
+    for (const auto &weakObj : m_implObjWeak) {
+        marking.roots.emplace_back(weakObj.po, weakObj.javaObjectId, false);
     }
     for (const auto &kv : m_implObjStrong) {
-        Persistent<Object> *po = kv.second;
-        if (po != nullptr) {
-            auto obj = Local<Object>::New(isolate, *po);
-            MarkReachableObjects(isolate, obj);
+        if (kv.second != nullptr) {
+            marking.roots.emplace_back(kv.second, kv.first, true);
+        }
+    }
+
+    if (marking.isPending) {
+        // a pending marking started over from all roots; it will release the objects of this GC too
+        marking.isRestartRequested = true;
+        return;
+    }
+
+    marking.nextRootIndex = 0;
+
+    if (m_markingTimeSliceMs > 0) {
+        auto deadline = chrono::steady_clock::now() + chrono::milliseconds(m_markingTimeSliceMs);
+        bool isDone = ProcessMarkingRoots(&deadline);
+        if (!isDone) {
+            marking.isPending = true;
+            ScheduleMarkingSlice();
+            return;
         }
+    } else {
+        ProcessMarkingRoots(nullptr);
     }
 
+    marking.roots.clear();
+
+    FinishGcCycle();
+}
+
+/*
+ * Runs MarkReachableObjects for the "callback" objects collected in the GC, starting from the
+ * state saved by the previous slice. Returns false if the deadline was reached before all roots were processed.
+ * */
+bool ObjectManager::ProcessMarkingRoots(const chrono::steady_clock::time_point *deadline) {
+    auto isolate = m_isolate;
+    auto &marking = m_incrementalMarking;
+
+    HandleScope handleScope(isolate);
+
+    stack<Local<Value>> s;
+    for (auto po : marking.markStack) {
+        s.push(Local<Value>::New(isolate, *po));
+        po->Reset();
+        delete po;
+    }
+    marking.markStack.clear();
+
+    bool isRootOnTop = false;
+
+    while (true) {
+        if (marking.isRestartRequested) {
+            marking.isRestartRequested = false;
+            marking.nextRootIndex = 0;
+            s = stack<Local<Value>>();
+            ClearVisited();
+
+            if (++marking.restartCount > MAX_INCREMENTAL_MARKING_RESTARTS) {
+                // the mutator keeps triggering GCs, finish the marking in this slice
+                deadline = nullptr;
+            }
+        }
+
+        if (s.empty()) {
+            if (marking.nextRootIndex >= marking.roots.size()) {
+                return true;
+            }
+
+            const auto &root = marking.roots[marking.nextRootIndex++];
+            if (root.isJavaObjectStrong) {
+                // skip the "callback" objects found reachable from other "callback" objects
+                auto itFound = m_implObjStrong.find(root.javaObjectId);
+                if ((itFound == m_implObjStrong.end()) || (itFound->second == nullptr)) {
+                    continue;
+                }
+            }
+
+            if (root.po->IsEmpty()) {
+                continue;
+            }
+
+            marking.fromId = root.javaObjectId;
+            s.push(Local<Object>::New(isolate, *root.po));
+            isRootOnTop = true;
+        }
+
+        bool isDone = MarkReachableObjects(isolate, s, marking.fromId, isRootOnTop, deadline);
+        isRootOnTop = false;
+
+        if (!isDone && !marking.isRestartRequested) {
+            // save the rest of the walk for the next slice, keeping the stack order
+            vector<Persistent<Value> *> markStack;
+            while (!s.empty()) {
+                markStack.push_back(new Persistent<Value>(isolate, s.top()));
+                s.pop();
+            }
+            marking.markStack.assign(markStack.rbegin(), markStack.rend());
+
+            return false;
+        }
+    }
+}
+
+void ObjectManager::RunMarkingSlice() {
+    auto &marking = m_incrementalMarking;
+    if (!marking.isPending) {
+        return;
+    }
+
+    tns::instrumentation::Frame frame;
+
+    auto deadline = chrono::steady_clock::now() + chrono::milliseconds(m_markingTimeSliceMs);
+    bool isDone = ProcessMarkingRoots(&deadline);
+
+    if (isDone) {
+        FinishIncrementalMarking();
+    } else {
+        ScheduleMarkingSlice();
+    }
+
+    if (frame.check()) {
+        frame.log(isDone ? "MarkReachableObjects slice (last)" : "MarkReachableObjects slice");
+    }
+}
+
+void ObjectManager::FinishPendingMarking() {
+    if (!m_incrementalMarking.isPending) {
+        return;
+    }
+
+    ProcessMarkingRoots(nullptr);
+    FinishIncrementalMarking();
+}
+
+/*
+ * Once JS gets hold of an object while the marking is pending, it may move anything reachable from it to
+ * the JS roots and drop the link, before the marking gets there. So everything reachable from the object is
+ * marked right away, as the graph is at the time the object is handed to JS.
+ * */
+void ObjectManager::MarkTouchedObject(int javaObjectID, const Local<Object> &obj) {
+    auto isolate = m_isolate;
+
+    auto jsInfo = GetJSInstanceInfo(obj);
+    if (jsInfo == nullptr) {
+        return;
+    }
+
+    // the object is marked with the visited sets of the write barrier
+    swap(m_visitedIds, m_touchedVisitedIds);
+    swap(m_visited, m_touchedVisited);
+
+    if (MarkVisited(obj, jsInfo)) {
+        if (!HasImplObject(isolate, obj)) {
+            jsInfo->LastMarkedGC = m_markedForGC.top().numberOfGC;
+        }
+
+        stack<Local<Value>> s;
+        s.push(obj);
+        MarkReachableObjects(isolate, s, javaObjectID, true, nullptr);
+    }
+
+    swap(m_visitedIds, m_touchedVisitedIds);
+    swap(m_visited, m_touchedVisited);
+}
+
+void ObjectManager::ClearTouchedVisited() {
+    m_touchedVisitedIds.clear();
+    m_touchedVisited.clear();
+}
+
+void ObjectManager::FinishIncrementalMarking() {
+    auto &marking = m_incrementalMarking;
+
+    marking.isPending = false;
+    marking.isRestartRequested = false;
+    marking.restartCount = 0;
+    marking.nextRootIndex = 0;
+    marking.roots.clear();
+    ClearTouchedVisited();
+
+    // all GCs that happened while the marking was pending are finished at once
+    while (!m_markedForGC.empty()) {
+        FinishGcCycle();
+    }
+}
+
+void ObjectManager::FinishGcCycle() {
     //deal with regular objects
     ReleaseRegularObjects();
 
     m_markedForGC.pop();
 
     if (m_markedForGC.empty()) {
-        MakeRegularObjectsWeak(m_released.m_IDs, m_buff);
+        MakeRegularObjectsWeak(m_released, m_handshake);
+
+        MakeImplObjectsWeak(m_implObjStrong, m_handshake);
+
+        if (m_implObjectTracer != nullptr) {
+            m_implObjectTracer->RequestLivenessCheck(m_handshake);
+        }
 
-        MakeImplObjectsWeak(m_implObjStrong, m_buff);
+        CheckWeakObjectsAreAlive(m_implObjWeak, m_handshake);
+
+        if (m_implObjectTracer != nullptr) {
+            m_implObjectTracer->UntrackReleased(m_handshake);
+
+            for (const auto &kv : m_implObjStrong) {
+                if (kv.second != nullptr) {
+                    m_implObjectTracer->Track(kv.first, kv.second);
+                }
+            }
+        }
 
-        CheckWeakObjectsAreAlive(m_implObjWeak, m_buff, m_outBuff);
+        m_handshake.Reset();
 
-        m_buff.Reset();
+        for (auto state : m_visitedStates) {
+            state->isVisited = false;
+        }
+        m_visitedStates.clear();
+
+        for (const auto &pair : m_released) {
+            m_callbackStatePool.Delete(ObjectWeakCallbackState::FromTarget(pair.po));
+        }
         m_released.clear();
-        m_visited.clear();
-        m_visitedPOs.clear();
+
+        ClearVisited();
         m_implObjWeak.clear();
         m_implObjStrong.clear();
     }
 }
 
 /*
- * We have all the JS "regular" objects that JS has made weak and ready to by GC'd,
- * so we tell java to take the JAVA objects out of strong reference so they can be collected by JAVA GC
+ * Finishes the GC in the Tracing marking mode, without MarkReachableObjects. V8 has already marked everything
+ * reachable from the tracked "callback" objects, so the "regular" objects found unreachable can be released.
+ * Unless a "callback" object became unreachable from JavaScript in the same GC: what is reachable from it is
+ * known only once it is traced, in the next GC, so the "regular" objects are left for the next GC to decide.
  * */
-void ObjectManager::MakeRegularObjectsWeak(const set<int> &instances, DirectBuffer &inputBuff) {
-    jboolean keepAsWeak = JNI_FALSE;
-    JEnv env;
-
-    for (auto javaObjectId : instances) {
-        bool success = inputBuff.Write(javaObjectId);
-
-        if (!success) {
-            int length = inputBuff.Length();
-            env.CallVoidMethod(m_javaRuntimeObject, MAKE_INSTANCE_WEAK_BATCH_METHOD_ID,
-                                 (jobject) inputBuff, length, keepAsWeak);
-            inputBuff.Reset();
-            success = inputBuff.Write(javaObjectId);
-            assert(success);
+void ObjectManager::FinishTracedGcCycles() {
+    bool hasNewRoots = false;
+    for (const auto &kv : m_implObjStrong) {
+        if (kv.second != nullptr) {
+            hasNewRoots = true;
+            break;
         }
     }
-    int size = inputBuff.Size();
-    if (size > 0) {
-        env.CallVoidMethod(m_javaRuntimeObject, MAKE_INSTANCE_WEAK_BATCH_METHOD_ID,
-                             (jobject) inputBuff, size, keepAsWeak);
+
+    while (!m_markedForGC.empty()) {
+        if (hasNewRoots) {
+            // they stay weak, so their weak callbacks fire again if they are still unreachable
+            m_markedForGC.top().markedForGC.clear();
+        }
+        FinishGcCycle();
     }
+}
 
-    inputBuff.Reset();
+void ObjectManager::ScheduleMarkingSlice() {
+    JEnv env;
+    env.CallVoidMethod(m_javaRuntimeObject, SCHEDULE_MARKING_SLICE_METHOD_ID);
+}
+
+/*
+ * We have all the JS "regular" objects that JS has made weak and ready to by GC'd,
+ * so we tell java to take the JAVA objects out of strong reference so they can be collected by JAVA GC
+ * */
+void ObjectManager::MakeRegularObjectsWeak(const vector<PersistentObjectIdPair> &instances, GcHandshakeBuffer &handshake) {
+    RUNTIME_STATS_ADD(m_isolate, RegularObjectsMadeWeak, instances.size());
+
+    for (const auto &pair : instances) {
+        handshake.Set(GcHandshakeBuffer::Bitmap::MakeWeak, pair.javaObjectId);
+    }
 }
 
 /*
@@ -789,90 +1143,145 @@ void ObjectManager::MakeRegularObjectsWeak(const set<int> &instances, DirectBuff
  * so that if java needs to release them, it can, on a later stage.
  * */
 void ObjectManager::MakeImplObjectsWeak(const unordered_map<int, Persistent<Object> *> &instances,
-                                        DirectBuffer &inputBuff) {
-    jboolean keepAsWeak = JNI_TRUE;
-    JEnv env;
-
+                                        GcHandshakeBuffer &handshake) {
     for (const auto &kv : instances) {
         if (kv.second != nullptr) {
-            int javaObjectId = kv.first;
-
-            bool success = inputBuff.Write(javaObjectId);
-
-            if (!success) {
-                int length = inputBuff.Length();
-                jboolean keepAsWeak = JNI_TRUE;
-                env.CallVoidMethod(m_javaRuntimeObject, MAKE_INSTANCE_WEAK_BATCH_METHOD_ID,
-                                     (jobject) inputBuff, length, keepAsWeak);
-                inputBuff.Reset();
-                success = inputBuff.Write(javaObjectId);
-                assert(success);
-            }
+            RUNTIME_STATS_INCREMENT(m_isolate, ImplObjectsMadeWeak);
+
+            handshake.Set(GcHandshakeBuffer::Bitmap::MakeWeakKeepAsWeak, kv.first);
         }
     }
-    int size = inputBuff.Size();
-    if (size > 0) {
-        jboolean keepAsWeak = JNI_TRUE;
-        env.CallVoidMethod(m_javaRuntimeObject, MAKE_INSTANCE_WEAK_BATCH_METHOD_ID,
-                             (jobject) inputBuff, size, keepAsWeak);
-    }
-
-    inputBuff.Reset();
 }
 
 /*
  * Consult with JAVA world to check if a java object is still in kept as a strong or weak reference
- * If the JAVA objects are released, we can release the their counterpart JS objects
+ * If the JAVA objects are released, we can release the their counterpart JS objects.
+ * The changes requested by MakeRegularObjectsWeak and MakeImplObjectsWeak are sent to JAVA with the same call.
  * */
 void ObjectManager::CheckWeakObjectsAreAlive(const vector<PersistentObjectIdPair> &instances,
-                                             DirectBuffer &inputBuff, DirectBuffer &outputBuff) {
+                                             GcHandshakeBuffer &handshake) {
     TNSPERF();
-    JEnv env;
+
+    RUNTIME_STATS_ADD(m_isolate, WeakObjectsChecked, instances.size());
 
     for (const auto &poIdPair : instances) {
-        int javaObjectId = poIdPair.javaObjectId;
-
-        bool success = inputBuff.Write(javaObjectId);
-
-        if (!success) {
-            int length = inputBuff.Length();
-            env.CallVoidMethod(m_javaRuntimeObject, CHECK_WEAK_OBJECTS_ARE_ALIVE_METHOD_ID,
-                                 (jobject) inputBuff, (jobject) outputBuff, length);
-            //
-            int *released = outputBuff.GetData();
-            for (int i = 0; i < length; i++) {
-                bool isReleased = *released++ != 0;
-
-                if (isReleased) {
-                    Persistent<Object> *po = instances[i].po;
-                    po->Reset();
-                }
-            }
-            //
-            inputBuff.Reset();
-            success = inputBuff.Write(javaObjectId);
-            assert(success);
-        }
-    }
-    int size = inputBuff.Size();
-    if (size > 0) {
-        env.CallVoidMethod(m_javaRuntimeObject, CHECK_WEAK_OBJECTS_ARE_ALIVE_METHOD_ID,
-                             (jobject) inputBuff, (jobject) outputBuff, size);
-        int *released = outputBuff.GetData();
-        for (int i = 0; i < size; i++) {
-            bool isReleased = *released++ != 0;
-
-            if (isReleased) {
-                Persistent<Object> *po = instances[i].po;
-                po->Reset();
-            }
+        handshake.Set(GcHandshakeBuffer::Bitmap::CheckAlive, poIdPair.javaObjectId);
+    }
+
+    ProcessGcHandshake(handshake);
+
+    for (const auto &poIdPair : instances) {
+        bool isReleased = handshake.IsSet(GcHandshakeBuffer::Bitmap::CheckAlive, poIdPair.javaObjectId);
+
+        if (isReleased) {
+            Persistent<Object> *po = poIdPair.po;
+            po->Reset();
+            RUNTIME_STATS_INCREMENT(m_isolate, WeakObjectsReleased);
         }
     }
 }
 
+void ObjectManager::ProcessGcHandshake(GcHandshakeBuffer &handshake) {
+    int wordCount = handshake.WordCount();
+    if (wordCount == 0) {
+        return;
+    }
+
+    JEnv env;
+    env.CallVoidMethod(m_javaRuntimeObject, PROCESS_GC_HANDSHAKE_METHOD_ID,
+                         (jobject) handshake, handshake.BitmapStride(), wordCount);
+}
+
+ObjectManager::ImplObjectTracer::ImplObjectTracer(ObjectManager *objectManager)
+        :
+        m_objectManager(objectManager) {
+}
+
+void ObjectManager::ImplObjectTracer::Track(int javaObjectId, Persistent<Object> *po) {
+    if (po->IsEmpty() || (m_tracked.find(javaObjectId) != m_tracked.end())) {
+        return;
+    }
+
+    auto isolate = m_objectManager->m_isolate;
+    HandleScope handleScope(isolate);
+
+    m_tracked.insert(make_pair(javaObjectId, new TracedGlobal<Object>(isolate, po->Get(isolate))));
+}
+
+void ObjectManager::ImplObjectTracer::Untrack(int javaObjectId) {
+    auto itFound = m_tracked.find(javaObjectId);
+    if (itFound != m_tracked.end()) {
+        delete itFound->second;
+        m_tracked.erase(itFound);
+    }
+}
+
+/*
+ * Asks Java which of the tracked objects are still alive, with the handshake of the GC epilogue.
+ * */
+void ObjectManager::ImplObjectTracer::RequestLivenessCheck(GcHandshakeBuffer &handshake) {
+    RUNTIME_STATS_ADD(m_objectManager->m_isolate, WeakObjectsChecked, m_tracked.size());
+
+    for (const auto &kv : m_tracked) {
+        handshake.Set(GcHandshakeBuffer::Bitmap::CheckAlive, kv.first);
+    }
+}
+
+/*
+ * Drops the objects whose Java counterparts were found released. As they are no longer reported as roots,
+ * they go through the regular JSObjectWeakCallback and CheckWeakObjectsAreAlive path and get released.
+ * */
+void ObjectManager::ImplObjectTracer::UntrackReleased(const GcHandshakeBuffer &handshake) {
+    auto it = m_tracked.begin();
+    while (it != m_tracked.end()) {
+        if (handshake.IsSet(GcHandshakeBuffer::Bitmap::CheckAlive, it->first)) {
+            delete it->second;
+            it = m_tracked.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void ObjectManager::ImplObjectTracer::RegisterV8References(const vector<pair<void *, void *>> &embedderFields) {
+    // the wrappers keep their JSInstanceInfo in an External, so V8 never reports them here
+}
+
+/*
+ * Reports all the tracked objects as roots, without calling Java in the GC. The ones whose Java counterparts
+ * were released after the last GC epilogue are kept alive for one more GC.
+ * */
+void ObjectManager::ImplObjectTracer::TracePrologue(TraceFlags flags) {
+    TNSPERF();
+    RUNTIME_STATS_TIMER(m_objectManager->m_isolate, TracePrologue);
+
+    m_roots.clear();
+    for (const auto &kv : m_tracked) {
+        m_roots.push_back(kv.second);
+    }
+}
+
+bool ObjectManager::ImplObjectTracer::AdvanceTracing(double deadlineInMs) {
+    for (auto root : m_roots) {
+        RegisterEmbedderReference(root->As<Data>());
+    }
+    m_roots.clear();
+
+    return true;
+}
+
+bool ObjectManager::ImplObjectTracer::IsTracingDone() {
+    return m_roots.empty();
+}
+
+void ObjectManager::ImplObjectTracer::EnterFinalPause(EmbedderStackState stackState) {
+}
+
 jweak ObjectManager::NewWeakGlobalRefCallback(const int &javaObjectID, void *state) {
     auto objManager = reinterpret_cast<ObjectManager *>(state);
 
+    RUNTIME_STATS_INCREMENT(objManager->m_isolate, JavaObjectCacheLoads);
+
     JniLocalRef obj(objManager->GetJavaObjectByIDImpl(javaObjectID));
 
     JEnv env;
@@ -921,11 +1330,32 @@ void ObjectManager::ReleaseNativeCounterpart(v8::Local<v8::Object> &object) {
     env.CallVoidMethod(m_javaRuntimeObject, RELEASE_NATIVE_INSTANCE_METHOD_ID,
                          jsInstanceInfo->JavaObjectID);
 
-    delete jsInstanceInfo;
+    // the JavaScript object keeps its persistent handle, only the link by id is dropped
+    m_idToObject.Remove(jsInstanceInfo->JavaObjectID);
+    m_cache.erase(jsInstanceInfo->JavaObjectID);
+    if (m_implObjectTracer != nullptr) {
+        // the id is reused once released
+        m_implObjectTracer->Untrack(jsInstanceInfo->JavaObjectID);
+    }
+    RUNTIME_STATS_INCREMENT(m_isolate, ObjectsUnlinked);
+
+    m_jsInstanceInfoPool.Delete(jsInstanceInfo);
     auto jsInfoIdx = static_cast<int>(MetadataNodeKeys::JsInfo);
     object->SetInternalField(jsInfoIdx, Undefined(m_isolate));
 }
 
+void ObjectManager::TrimCaches() {
+    m_cache.clear();
+}
+
+size_t ObjectManager::GetLinkedObjectsCount() const {
+    return m_idToObject.Size();
+}
+
+size_t ObjectManager::GetWrapperSlabCount() const {
+    return m_jsInstanceInfoPool.SlabCount() + m_callbackStatePool.SlabCount();
+}
+
 ObjectManager::JavaScriptMarkingMode ObjectManager::GetMarkingMode() {
     return this->m_markingMode;
 }
\ No newline at end of file
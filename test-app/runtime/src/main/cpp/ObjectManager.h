@@ -5,13 +5,18 @@
 #include "JEnv.h"
 #include "JniLocalRef.h"
 #include "ArgsWrapper.h"
-#include "DirectBuffer.h"
+#include "GcHandshakeBuffer.h"
 #include "LRUCache.h"
+#include "ObjectPool.h"
+#include "ObjectTable.h"
+#include <chrono>
 #include <map>
 #include <set>
 #include <stack>
 #include <vector>
 #include <string>
+#include <type_traits>
+#include <unordered_set>
 
 namespace tns {
 class ObjectManager {
@@ -74,33 +79,80 @@ class ObjectManager {
             /**
              * Fully suppress the MarkReachableObjects.
              */
-            None
+            None,
+            /**
+             * Instead of MarkReachableObjects, the implementation objects which Java holds weakly and are still
+             * alive are reported to the V8 marker through an EmbedderHeapTracer, and V8 marks everything reachable
+             * from them during its own marking.
+             */
+            Tracing
         };
 
         JavaScriptMarkingMode GetMarkingMode();
 
+        /*
+         * The number of JavaScript objects currently linked to a Java object.
+         */
+        size_t GetLinkedObjectsCount() const;
+
+        /*
+         * The number of slabs allocated for the per wrapper records since the runtime started.
+         */
+        size_t GetWrapperSlabCount() const;
+
+        /*
+         * Continues the time-sliced marking started in the last GC epilogue. Called from
+         * the JS thread when the task scheduled with the "scheduleMarkingSlice" Java method runs.
+         */
+        void RunMarkingSlice();
+
+        /*
+         * Finishes the time-sliced marking, if one is pending, without waiting for the scheduled slices.
+         */
+        void FinishPendingMarking();
+
+        /*
+         * Drops the cached references to Java objects. Called when the application is asked to trim its memory.
+         */
+        void TrimCaches();
+
     private:
 
         struct JSInstanceInfo {
             public:
                 JSInstanceInfo(bool isJavaObjectWeak, uint32_t javaObjectID, jclass claz)
-                    :IsJavaObjectWeak(isJavaObjectWeak), JavaObjectID(javaObjectID), ObjectClazz(claz) {
+                    :IsJavaObjectWeak(isJavaObjectWeak), JavaObjectID(javaObjectID), ObjectClazz(claz), LastMarkedGC(0) {
                 }
 
                 bool IsJavaObjectWeak;
                 uint32_t JavaObjectID;
                 jclass ObjectClazz;
+                // the number of the last GC in which the object was reached from an implementation object
+                int LastMarkedGC;
         };
 
+        /*
+         * Owns the persistent handle of a linked JavaScript object, so that both are allocated as a single record.
+         */
         struct ObjectWeakCallbackState {
-            ObjectWeakCallbackState(ObjectManager* _thisPtr, JSInstanceInfo* _jsInfo, v8::Persistent<v8::Object>* _target)
+            ObjectWeakCallbackState(ObjectManager* _thisPtr, JSInstanceInfo* _jsInfo, v8::Isolate* isolate, const v8::Local<v8::Object>& object)
                 :
-                thisPtr(_thisPtr), jsInfo(_jsInfo), target(_target) {
+                target(isolate, object), thisPtr(_thisPtr), jsInfo(_jsInfo), isVisited(false), isReleased(false) {
+            }
+
+            static ObjectWeakCallbackState* FromTarget(v8::Persistent<v8::Object>* po) {
+                static_assert(std::is_standard_layout<ObjectWeakCallbackState>::value, "the target must be at the start of the record");
+                return reinterpret_cast<ObjectWeakCallbackState*>(po);
             }
 
+            // must be the first member, see FromTarget
+            v8::Persistent<v8::Object> target;
             ObjectManager* thisPtr;
             JSInstanceInfo* jsInfo;
-            v8::Persistent<v8::Object>* target;
+            // handled by JSObjectWeakCallback in the current GC cycle
+            bool isVisited;
+            // released by ReleaseJSInstance in the current GC cycle, the record is freed when the cycle is finished
+            bool isReleased;
         };
 
         struct GarbageCollectionInfo {
@@ -112,30 +164,6 @@ class ObjectManager {
             int numberOfGC;
         };
 
-        class PersistentObjectIdSet {
-            public:
-                PersistentObjectIdSet() {
-                    /* TODO: use functors */
-                }
-
-                void clear() {
-                    m_POs.clear();
-                    m_IDs.clear();
-                }
-
-                void insert(v8::Persistent<v8::Object>* po, int javaObjectId) {
-                    m_POs.insert(po);
-                    m_IDs.insert(javaObjectId);
-                }
-
-                bool contains(v8::Persistent<v8::Object>* po) {
-                    return m_POs.find(po) != m_POs.end();
-                }
-
-                std::set<v8::Persistent<v8::Object>*> m_POs;
-                std::set<int> m_IDs;
-        };
-
         struct PersistentObjectIdPair {
             PersistentObjectIdPair(v8::Persistent<v8::Object>* _po, int _javaObjectId)
                 :
@@ -145,6 +173,44 @@ class ObjectManager {
             int javaObjectId;
         };
 
+        struct PendingFinalization {
+            PendingFinalization(ObjectWeakCallbackState* _callbackState, JSInstanceInfo* _jsInfo)
+                :
+                callbackState(_callbackState), jsInfo(_jsInfo) {
+            }
+            ObjectWeakCallbackState* callbackState;
+            JSInstanceInfo* jsInfo;
+        };
+
+        struct MarkingRoot {
+            MarkingRoot(v8::Persistent<v8::Object>* _po, int _javaObjectId, bool _isJavaObjectStrong)
+                :
+                po(_po), javaObjectId(_javaObjectId), isJavaObjectStrong(_isJavaObjectStrong) {
+            }
+            v8::Persistent<v8::Object>* po;
+            int javaObjectId;
+            bool isJavaObjectStrong;
+        };
+
+        /*
+         * State of a MarkReachableObjects walk that did not fit in its time slice
+         * and is resumed on a later JS thread task.
+         */
+        struct IncrementalMarkingState {
+            IncrementalMarkingState()
+                :
+                isPending(false), isRestartRequested(false), restartCount(0), nextRootIndex(0), fromId(-1) {
+            }
+            bool isPending;
+            // set when a GC happens while the marking is pending, the walk is then started over
+            bool isRestartRequested;
+            int restartCount;
+            std::vector<MarkingRoot> roots;
+            size_t nextRootIndex;
+            int fromId;
+            std::vector<v8::Persistent<v8::Value>*> markStack;
+        };
+
 
 
         JSInstanceInfo* GetJSInstanceInfo(const v8::Local<v8::Object>& object);
@@ -155,11 +221,51 @@ class ObjectManager {
 
         void ReleaseRegularObjects();
 
-        void MakeRegularObjectsWeak(const std::set<int>& instances, DirectBuffer& inputBuff);
+        void MakeRegularObjectsWeak(const std::vector<PersistentObjectIdPair>& instances, GcHandshakeBuffer& handshake);
+
+        void MakeImplObjectsWeak(const std::unordered_map<int, v8::Persistent<v8::Object>*>& instances, GcHandshakeBuffer& handshake);
 
-        void MakeImplObjectsWeak(const std::unordered_map<int, v8::Persistent<v8::Object>*>& instances, DirectBuffer& inputBuff);
+        void CheckWeakObjectsAreAlive(const std::vector<PersistentObjectIdPair>& instances, GcHandshakeBuffer& handshake);
 
-        void CheckWeakObjectsAreAlive(const std::vector<PersistentObjectIdPair>& instances, DirectBuffer& inputBuff, DirectBuffer& outputBuff);
+        void ProcessGcHandshake(GcHandshakeBuffer& handshake);
+
+        void FinishTracedGcCycles();
+
+        /*
+         * Keeps the "callback" objects that were made weak in Java as V8 tracing roots for as long as
+         * their Java counterparts are alive. Java is asked about them in the GC epilogue, together with the
+         * rest of the handshake, so the prologue of the next GC reports the roots without calling Java.
+         */
+        class ImplObjectTracer : public v8::EmbedderHeapTracer {
+            public:
+                ImplObjectTracer(ObjectManager* objectManager);
+
+                void Track(int javaObjectId, v8::Persistent<v8::Object>* po);
+
+                void Untrack(int javaObjectId);
+
+                void RequestLivenessCheck(GcHandshakeBuffer& handshake);
+
+                void UntrackReleased(const GcHandshakeBuffer& handshake);
+
+                void RegisterV8References(const std::vector<std::pair<void*, void*>>& embedderFields) override;
+
+                void TracePrologue(TraceFlags flags) override;
+
+                bool AdvanceTracing(double deadlineInMs) override;
+
+                bool IsTracingDone() override;
+
+                void EnterFinalPause(EmbedderStackState stackState) override;
+
+            private:
+                ObjectManager* m_objectManager;
+
+                std::unordered_map<int, v8::TracedGlobal<v8::Object>*> m_tracked;
+
+                // the roots which are still to be reported in the current GC
+                std::vector<v8::TracedGlobal<v8::Object>*> m_roots;
+        };
 
         v8::Local<v8::Object> CreateJSWrapperHelper(jint javaObjectID, const std::string& typeName, jclass clazz);
 
@@ -173,10 +279,34 @@ class ObjectManager {
 
         void JSObjectFinalizer(v8::Isolate* isolate, ObjectWeakCallbackState* callbackState);
 
+        void FlushPendingFinalizations();
+
+        static void OnFinalizingGcFinishedStatic(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags);
+
         bool HasImplObject(v8::Isolate* isolate, const v8::Local<v8::Object>& obj);
 
         void MarkReachableObjects(v8::Isolate* isolate, const v8::Local<v8::Object>& obj);
 
+        bool MarkReachableObjects(v8::Isolate* isolate, std::stack<v8::Local<v8::Value>>& s, int fromId, bool isRootOnTop, const std::chrono::steady_clock::time_point* deadline);
+
+        bool MarkVisited(const v8::Local<v8::Object>& object, JSInstanceInfo* jsInfo);
+
+        void ClearVisited();
+
+        bool ProcessMarkingRoots(const std::chrono::steady_clock::time_point* deadline);
+
+        void FinishIncrementalMarking();
+
+        void MarkTouchedObject(int javaObjectID, const v8::Local<v8::Object>& obj);
+
+        void ClearTouchedVisited();
+
+        void FinishGcCycle();
+
+        void ScheduleMarkingSlice();
+
+        static void OnMinorGcStartedStatic(v8::Isolate* isolate, v8::GCType type, v8::GCCallbackFlags flags);
+
         void OnGcStarted(v8::GCType type, v8::GCCallbackFlags flags);
 
         void OnGcFinished(v8::GCType type, v8::GCCallbackFlags flags);
@@ -203,28 +333,60 @@ class ObjectManager {
 
         std::stack<GarbageCollectionInfo> m_markedForGC;
 
-        std::unordered_map<int, v8::Persistent<v8::Object>*> m_idToObject;
+        ObjectTable m_idToObject;
+
+        ObjectPool<JSInstanceInfo> m_jsInstanceInfoPool;
 
-        PersistentObjectIdSet m_released;
+        ObjectPool<ObjectWeakCallbackState> m_callbackStatePool;
 
-        std::set<unsigned long> m_visited;
+        std::vector<PersistentObjectIdPair> m_released;
+
+        /*
+         * The objects visited by MarkReachableObjects in the current GC. The wrappers are marked by id,
+         * in a bitset sized from m_idToObject, the rest of the objects by address.
+         */
+        std::vector<uint64_t> m_visitedIds;
+        std::unordered_set<unsigned long> m_visited;
+
+        /*
+         * The objects marked by the write barrier while a time-sliced marking is pending. They are kept apart
+         * from the ones of the marking itself, whose subgraphs may still be on the mark stack.
+         */
+        std::vector<uint64_t> m_touchedVisitedIds;
+        std::unordered_set<unsigned long> m_touchedVisited;
 
         LRUCache<int, jweak> m_cache;
 
-        std::set<v8::Persistent<v8::Object>*> m_visitedPOs;
+        std::vector<ObjectWeakCallbackState*> m_visitedStates;
         std::vector<PersistentObjectIdPair> m_implObjWeak;
         std::unordered_map<int, v8::Persistent<v8::Object>*> m_implObjStrong;
 
-        volatile int m_currentObjectId;
-
-        DirectBuffer m_buff;
-
-        DirectBuffer m_outBuff;
+        GcHandshakeBuffer m_handshake;
 
         bool m_useGlobalRefs;
 
         JavaScriptMarkingMode m_markingMode;
 
+        /*
+         * The time budget of a single MarkReachableObjects slice in milliseconds.
+         * When 0 the whole graph is marked synchronously in the GC epilogue.
+         */
+        int m_markingTimeSliceMs;
+
+        IncrementalMarkingState m_incrementalMarking;
+
+        ImplObjectTracer* m_implObjectTracer;
+
+        /*
+         * The wrappers finalized in the current GC in the None marking mode. They are kept alive until
+         * the GC epilogue, where Java is asked about all of them at once.
+         */
+        std::vector<PendingFinalization> m_pendingFinalizations;
+
+        static const int MARKING_DEADLINE_CHECK_INTERVAL = 64;
+
+        static const int MAX_INCREMENTAL_MARKING_RESTARTS = 3;
+
         jclass JAVA_LANG_CLASS;
 
         jmethodID GET_NAME_METHOD_ID;
@@ -233,13 +395,13 @@ class ObjectManager {
 
         jmethodID GET_OR_CREATE_JAVA_OBJECT_ID_METHOD_ID;
 
-        jmethodID MAKE_INSTANCE_WEAK_BATCH_METHOD_ID;
-
-        jmethodID MAKE_INSTANCE_WEAK_AND_CHECK_IF_ALIVE_METHOD_ID;
+        jmethodID GENERATE_NEW_OBJECT_ID_METHOD_ID;
 
         jmethodID RELEASE_NATIVE_INSTANCE_METHOD_ID;
 
-        jmethodID CHECK_WEAK_OBJECTS_ARE_ALIVE_METHOD_ID;
+        jmethodID PROCESS_GC_HANDSHAKE_METHOD_ID;
+
+        jmethodID SCHEDULE_MARKING_SLICE_METHOD_ID;
 
         v8::Persistent<v8::Function>* m_poJsWrapperFunc;
 };
@@ -0,0 +1,93 @@
+#ifndef OBJECTPOOL_H_
+#define OBJECTPOOL_H_
+
+#include <cassert>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tns {
+/*
+ * Allocates objects of a single type from slabs of SLAB_SIZE slots and reuses the released slots
+ * through a free list. The slabs are kept until the pool is destroyed, which does not run the
+ * destructors of the objects still allocated from it. Not thread safe.
+ */
+template<typename T, size_t SLAB_SIZE = 256>
+class ObjectPool {
+    public:
+        ObjectPool()
+            : m_freeList(nullptr), m_size(0) {
+        }
+
+        ~ObjectPool() {
+            for (auto slab : m_slabs) {
+                delete[] slab;
+            }
+        }
+
+        template<typename... Args>
+        T* New(Args&&... args) {
+            if (m_freeList == nullptr) {
+                AllocateSlab();
+            }
+
+            Slot* slot = m_freeList;
+            m_freeList = slot->next;
+            m_size++;
+
+            return new (&slot->storage) T(std::forward<Args>(args)...);
+        }
+
+        void Delete(T* object) {
+            assert(object != nullptr);
+
+            object->~T();
+
+            Slot* slot = reinterpret_cast<Slot*>(object);
+            slot->next = m_freeList;
+            m_freeList = slot;
+            m_size--;
+        }
+
+        /*
+         * The number of objects currently allocated from the pool.
+         */
+        size_t Size() const {
+            return m_size;
+        }
+
+        size_t SlabCount() const {
+            return m_slabs.size();
+        }
+
+    private:
+        union Slot {
+            Slot* next;
+            typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        };
+
+        void AllocateSlab() {
+            Slot* slab = new Slot[SLAB_SIZE];
+            m_slabs.push_back(slab);
+
+            // the slots are handed out in address order
+            for (size_t i = SLAB_SIZE; i > 0; i--) {
+                slab[i - 1].next = m_freeList;
+                m_freeList = &slab[i - 1];
+            }
+        }
+
+        ObjectPool(const ObjectPool&) = delete;
+        ObjectPool& operator=(const ObjectPool&) = delete;
+
+        std::vector<Slot*> m_slabs;
+
+        Slot* m_freeList;
+
+        size_t m_size;
+};
+}
+
+#endif /* OBJECTPOOL_H_ */
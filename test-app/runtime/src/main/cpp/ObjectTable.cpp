@@ -0,0 +1,65 @@
+#include "ObjectTable.h"
+#include <cstring>
+
+using namespace v8;
+using namespace tns;
+
+ObjectTable::ObjectTable()
+    :
+    m_size(0) {
+}
+
+ObjectTable::~ObjectTable() {
+    for (auto page : m_pages) {
+        delete page;
+    }
+}
+
+void ObjectTable::Insert(int javaObjectId, Persistent<Object>* po) {
+    uint32_t pageIndex = static_cast<uint32_t>(javaObjectId) >> PAGE_SHIFT;
+    if (pageIndex >= m_pages.size()) {
+        m_pages.resize(pageIndex + 1, nullptr);
+    }
+
+    auto page = m_pages[pageIndex];
+    if (page == nullptr) {
+        page = new Page();
+        memset(page->objects, 0, sizeof(page->objects));
+        page->count = 0;
+        m_pages[pageIndex] = page;
+    }
+
+    auto& entry = page->objects[javaObjectId & PAGE_MASK];
+    if (entry != nullptr) {
+        return;
+    }
+
+    entry = po;
+    page->count++;
+    m_size++;
+}
+
+void ObjectTable::Remove(int javaObjectId) {
+    uint32_t pageIndex = static_cast<uint32_t>(javaObjectId) >> PAGE_SHIFT;
+    if (pageIndex >= m_pages.size() || m_pages[pageIndex] == nullptr) {
+        return;
+    }
+
+    auto page = m_pages[pageIndex];
+    auto& entry = page->objects[javaObjectId & PAGE_MASK];
+    if (entry == nullptr) {
+        return;
+    }
+
+    entry = nullptr;
+    m_size--;
+
+    if (--page->count == 0) {
+        delete page;
+        m_pages[pageIndex] = nullptr;
+    }
+}
+
+size_t ObjectTable::Size() const {
+    return m_size;
+}
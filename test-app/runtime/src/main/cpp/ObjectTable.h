@@ -0,0 +1,65 @@
+#ifndef OBJECTTABLE_H_
+#define OBJECTTABLE_H_
+
+#include "v8.h"
+#include <cstdint>
+#include <vector>
+
+namespace tns {
+/*
+ * Maps the Java object ids to the persistent handles of their JavaScript objects.
+ *
+ * The ids are allocated by java/com/tns/InstanceTable, which reuses the released ones, so they stay dense
+ * and the table is an array indexed by id, split in pages which are freed once all of their entries are removed.
+ * Mirrors java/com/tns/InstanceTable.
+ */
+class ObjectTable {
+    public:
+        ObjectTable();
+        ~ObjectTable();
+
+        inline v8::Persistent<v8::Object>* Get(int javaObjectId) const {
+            uint32_t pageIndex = static_cast<uint32_t>(javaObjectId) >> PAGE_SHIFT;
+            if (pageIndex >= m_pages.size() || m_pages[pageIndex] == nullptr) {
+                return nullptr;
+            }
+
+            return m_pages[pageIndex]->objects[javaObjectId & PAGE_MASK];
+        }
+
+        /*
+         * Adds the object unless there is already one with the same id.
+         */
+        void Insert(int javaObjectId, v8::Persistent<v8::Object>* po);
+
+        void Remove(int javaObjectId);
+
+        size_t Size() const;
+
+        /*
+         * One past the largest id the table has room for without growing.
+         */
+        inline size_t Capacity() const {
+            return m_pages.size() * PAGE_SIZE;
+        }
+
+    private:
+        static const int PAGE_SHIFT = 10;
+        static const int PAGE_SIZE = 1 << PAGE_SHIFT;
+        static const int PAGE_MASK = PAGE_SIZE - 1;
+
+        struct Page {
+            v8::Persistent<v8::Object>* objects[PAGE_SIZE];
+            int count;
+        };
+
+        ObjectTable(const ObjectTable&) = delete;
+        ObjectTable& operator=(const ObjectTable&) = delete;
+
+        std::vector<Page*> m_pages;
+
+        size_t m_size;
+};
+}
+
+#endif /* OBJECTTABLE_H_ */
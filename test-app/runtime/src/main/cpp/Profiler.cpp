@@ -294,6 +294,10 @@ void Profiler::HeapSnapshotMethodCallback(const v8::FunctionCallbackInfo<v8::Val
 }
 
 void Profiler::HeapSnapshotMethodCallbackImpl(const v8::FunctionCallbackInfo<v8::Value>& args) {
+    WriteHeapSnapshot(args.GetIsolate(), m_appName, m_outputDir);
+}
+
+bool Profiler::WriteHeapSnapshot(Isolate* isolate, const string& appName, const string& outputDir) {
     struct timespec nowt;
     clock_gettime(CLOCK_MONOTONIC, &nowt);
     uint64_t now = (int64_t) nowt.tv_sec * 1000000000LL + nowt.tv_nsec;
@@ -302,20 +306,20 @@ void Profiler::HeapSnapshotMethodCallbackImpl(const v8::FunctionCallbackInfo<v8:
     unsigned long usec = static_cast<unsigned long>(now % 1000000);
 
     char filename[256];
-    snprintf(filename, sizeof(filename), "%s/%s-heapdump-%lu.%lu.heapsnapshot", m_outputDir.c_str(), m_appName.c_str(), sec, usec);
+    snprintf(filename, sizeof(filename), "%s/%s-heapdump-%lu.%lu.heapsnapshot", outputDir.c_str(), appName.c_str(), sec, usec);
 
     FILE* fp = fopen(filename, "w");
     if (fp == nullptr) {
-        return;
+        return false;
     }
 
-    auto isolate = args.GetIsolate();
-
     const HeapSnapshot* snap = isolate->GetHeapProfiler()->TakeHeapSnapshot();
 
     FileOutputStream stream(fp);
     snap->Serialize(&stream, HeapSnapshot::kJSON);
     fclose(fp);
     const_cast<HeapSnapshot*>(snap)->Delete();
+
+    return true;
 }
 
@@ -12,6 +12,11 @@ class Profiler {
 
         void Init(v8::Isolate* isolate, const v8::Local<v8::Object>& globalObj, const std::string& appName, const std::string& outputDir);
 
+        /*
+         * Writes a heap snapshot of the isolate to a new file in outputDir. Returns false if the file can't be created.
+         */
+        static bool WriteHeapSnapshot(v8::Isolate* isolate, const std::string& appName, const std::string& outputDir);
+
     private:
         static void StartCPUProfilerCallback(const v8::FunctionCallbackInfo<v8::Value>& args);
 
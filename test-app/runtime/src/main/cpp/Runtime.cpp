@@ -1,4 +1,5 @@
 #include "CallbackHandlers.h"
+#include "CodeCacheBundle.h"
 #include "MetadataNode.h"
 #include "JsArgConverter.h"
 #include "JsArgToArrayConverter.h"
@@ -28,6 +29,7 @@
 #include "NetworkDomainCallbackHandlers.h"
 #include "sys/system_properties.h"
 #include "ManualInstrumentation.h"
+#include "TraceRecorder.h"
 #include <snapshot_blob.h>
 #include "IsolateDisposer.h"
 
@@ -177,6 +179,7 @@ void Runtime::Init(JNIEnv* _env, jobject obj, int runtimeId, jstring filesPath,
 }
 
 void Runtime::Init(JNIEnv* env, jstring filesPath, jstring nativeLibDir, bool verboseLoggingEnabled, bool isDebuggable, jstring packageName, jobjectArray args, jstring callingDir, int maxLogcatObjectSize, bool forceLog) {
+    tns::instrumentation::Frame frame("Runtime.Init");
     LogEnabled = verboseLoggingEnabled;
 
     auto filesRoot = ArgConverter::jstringToString(filesPath);
@@ -205,6 +208,10 @@ void Runtime::Init(JNIEnv* env, jstring filesPath, jstring nativeLibDir, bool ve
 }
 
 Runtime::~Runtime() {
+    for (auto methodSlot : m_methodSlots) {
+        delete methodSlot;
+    }
+
     delete this->m_objectManager;
     delete this->m_loopTimer;
     delete this->m_heapSnapshotBlob;
@@ -237,6 +244,10 @@ void Runtime::RunModule(JNIEnv* _env, jobject obj, jstring scriptFile) {
     string filePath = ArgConverter::jstringToString(scriptFile);
     auto context = this->GetContext();
     m_module.Load(context, filePath);
+
+    if (Constants::V8_CACHE_COMPILED_CODE) {
+        CodeCacheBundle::GetInstance()->Flush();
+    }
 }
 
 void Runtime::RunWorker(jstring scriptFile) {
@@ -244,6 +255,10 @@ void Runtime::RunWorker(jstring scriptFile) {
     string filePath = ArgConverter::jstringToString(scriptFile);
     auto context = this->GetContext();
     m_module.LoadWorker(context, filePath);
+
+    if (Constants::V8_CACHE_COMPILED_CODE) {
+        CodeCacheBundle::GetInstance()->Flush();
+    }
 }
 
 jobject Runtime::RunScript(JNIEnv* _env, jobject obj, jstring scriptFile) {
@@ -287,7 +302,34 @@ jobject Runtime::RunScript(JNIEnv* _env, jobject obj, jstring scriptFile) {
     return res;
 }
 
-jobject Runtime::CallJSMethodNative(JNIEnv* _env, jobject obj, jint javaObjectID, jstring methodName, jint retType, jboolean isConstructor, jobjectArray packagedArgs) {
+Local<v8::String> Runtime::GetMethodSlotName(jint methodSlot) {
+    if (methodSlot < 0) {
+        stringstream ss;
+        ss << "Invalid method slot " << methodSlot;
+        throw NativeScriptException(ss.str());
+    }
+
+    if ((size_t) methodSlot >= m_methodSlots.size()) {
+        m_methodSlots.resize(methodSlot + 1, nullptr);
+    }
+
+    // the first call of the method in this runtime
+    if (m_methodSlots[methodSlot] == nullptr) {
+        string methodName;
+        if (!CallbackHandlers::GetMethodSlotName(methodSlot, methodName)) {
+            stringstream ss;
+            ss << "Invalid method slot " << methodSlot;
+            throw NativeScriptException(ss.str());
+        }
+
+        auto v8MethodName = v8::String::NewFromUtf8(m_isolate, methodName.c_str(), NewStringType::kInternalized, methodName.length()).ToLocalChecked();
+        m_methodSlots[methodSlot] = new Persistent<v8::String>(m_isolate, v8MethodName);
+    }
+
+    return Local<v8::String>::New(m_isolate, *m_methodSlots[methodSlot]);
+}
+
+jobject Runtime::CallJSMethodNative(JNIEnv* _env, jobject obj, jint javaObjectID, jint methodSlot, jint retType, jboolean isConstructor, jobjectArray packagedArgs) {
     SET_PROFILER_FRAME();
 
     auto isolate = m_isolate;
@@ -296,14 +338,8 @@ jobject Runtime::CallJSMethodNative(JNIEnv* _env, jobject obj, jint javaObjectID
 
     DEBUG_WRITE("CallJSMethodNative called javaObjectID=%d", javaObjectID);
 
-    auto jsObject = m_objectManager->GetJsObjectByJavaObject(javaObjectID);
-    if (jsObject.IsEmpty()) {
-        stringstream ss;
-        ss << "JavaScript object for Java ID " << javaObjectID << " not found." << endl;
-        ss << "Attempting to call method " << ArgConverter::jstringToString(methodName) << endl;
-
-        throw NativeScriptException(ss.str());
-    }
+    auto methodName = GetMethodSlotName(methodSlot);
+    auto jsObject = GetJsObjectForCallback(javaObjectID, methodName);
 
     if (isConstructor) {
         DEBUG_WRITE("CallJSMethodNative: Updating linked instance with its real class");
@@ -313,14 +349,71 @@ jobject Runtime::CallJSMethodNative(JNIEnv* _env, jobject obj, jint javaObjectID
 
     DEBUG_WRITE("CallJSMethodNative called jsObject=%d", jsObject->GetIdentityHash());
 
-    string method_name = ArgConverter::jstringToString(methodName);
-    auto jsResult = CallbackHandlers::CallJSMethod(m_isolate, env, jsObject, method_name, packagedArgs);
+    auto jsResult = CallbackHandlers::CallJSMethod(m_isolate, env, jsObject, methodName, packagedArgs);
 
     int classReturnType = retType;
     jobject javaObject = ConvertJsValueToJavaObject(env, jsResult, classReturnType);
     return javaObject;
 }
 
+jvalue Runtime::CallJSMethodNativeUnboxed(JNIEnv* _env, jint javaObjectID, jint methodSlot, const char* argTypes, const jvalue* args, char retType) {
+    SET_PROFILER_FRAME();
+
+    auto isolate = m_isolate;
+
+    DEBUG_WRITE("CallJSMethodNativeUnboxed called javaObjectID=%d", javaObjectID);
+
+    auto methodName = GetMethodSlotName(methodSlot);
+    auto jsObject = GetJsObjectForCallback(javaObjectID, methodName);
+
+    DEBUG_WRITE("CallJSMethodNativeUnboxed called jsObject=%d", jsObject->GetIdentityHash());
+
+    auto jsMethod = CallbackHandlers::GetJSMethod(isolate, jsObject, methodName);
+
+    int argc = strlen(argTypes);
+    assert(argc <= MAX_UNBOXED_ARGS);
+
+    Local<Value> arguments[MAX_UNBOXED_ARGS];
+    for (int i = 0; i < argc; i++) {
+        switch (argTypes[i]) {
+            case 'Z':
+                arguments[i] = Boolean::New(isolate, args[i].z == JNI_TRUE);
+                break;
+            case 'I':
+                arguments[i] = Integer::New(isolate, args[i].i);
+                break;
+            case 'J':
+                arguments[i] = Number::New(isolate, args[i].j);
+                break;
+            case 'F':
+                arguments[i] = Number::New(isolate, args[i].f);
+                break;
+            case 'D':
+                arguments[i] = Number::New(isolate, args[i].d);
+                break;
+            default:
+                throw NativeScriptException(string("Unsupported unboxed argument type: ") + argTypes[i]);
+        }
+    }
+
+    auto jsResult = CallbackHandlers::CallJSMethod(isolate, jsObject, jsMethod, methodName, argc, argc == 0 ? nullptr : arguments);
+
+    return ConvertJsValueToJavaPrimitive(jsResult, retType, methodName);
+}
+
+Local<Object> Runtime::GetJsObjectForCallback(jint javaObjectID, const Local<v8::String>& methodName) {
+    auto jsObject = m_objectManager->GetJsObjectByJavaObject(javaObjectID);
+    if (jsObject.IsEmpty()) {
+        stringstream ss;
+        ss << "JavaScript object for Java ID " << javaObjectID << " not found." << endl;
+        ss << "Attempting to call method " << ArgConverter::ConvertToString(methodName) << endl;
+
+        throw NativeScriptException(ss.str());
+    }
+
+    return jsObject;
+}
+
 void Runtime::CreateJSInstanceNative(JNIEnv* _env, jobject obj, jobject javaObject, jint javaObjectID, jstring className) {
     SET_PROFILER_FRAME();
 
@@ -354,12 +447,6 @@ void Runtime::CreateJSInstanceNative(JNIEnv* _env, jobject obj, jobject javaObje
     m_objectManager->Link(jsInstance, javaObjectID, clazz);
 }
 
-jint Runtime::GenerateNewObjectId(JNIEnv* env, jobject obj) {
-    int objectId = m_objectManager->GenerateNewObjectID();
-
-    return objectId;
-}
-
 void Runtime::AdjustAmountOfExternalAllocatedMemory() {
     JEnv env;
     int64_t usedMemory = env.CallLongMethod(m_runtime, GET_USED_MEMORY_METHOD_ID);
@@ -389,6 +476,7 @@ bool Runtime::TryCallGC() {
             auto globalObject = ctx->Global();
             auto gcFunc = Local<Function>::New(m_isolate, *m_gcFunc);
             auto maybeResult = gcFunc.As<Function>()->Call(ctx, globalObject, 0, nullptr);
+            RUNTIME_STATS_INCREMENT(m_isolate, ForcedGcs);
             DEBUG_WRITE("Induced GC runtimeId=%d", m_id);
         }
     }
@@ -450,6 +538,57 @@ void Runtime::ClearStartupData(JNIEnv* env, jobject obj) {
     delete m_startupData;
 }
 
+/*
+ * Called on the runtime thread when the application moves between the foreground and the background.
+ * In background V8 uses a smaller heap growing factor and favors memory over speed.
+ * */
+void Runtime::NotifyInBackground(bool isInBackground) {
+    switch (m_lifecycleState.SetInBackground(isInBackground)) {
+        case LifecycleState::Change::ToBackground:
+            m_isolate->IsolateInBackgroundNotification();
+            break;
+        case LifecycleState::Change::ToForeground:
+            m_isolate->IsolateInForegroundNotification();
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Called on the runtime thread when Android asks the application to trim its memory.
+ * The runtime caches are trimmed and V8 is asked to collect everything it can,
+ * which for the critical level also drops its compilation cache.
+ * */
+void Runtime::NotifyMemoryPressure(MemoryPressureLevel level) {
+    auto isolate = m_isolate;
+
+    if (level == MemoryPressureLevel::None) {
+        return;
+    }
+
+    RUNTIME_STATS_INCREMENT(isolate, MemoryPressureNotifications);
+
+    m_objectManager->TrimCaches();
+
+    auto v8Level = (level == MemoryPressureLevel::Critical)
+                   ? v8::MemoryPressureLevel::kCritical
+                   : v8::MemoryPressureLevel::kModerate;
+    isolate->MemoryPressureNotification(v8Level);
+}
+
+void Runtime::StartModulePreloading(const string& manifestPath) {
+    m_module.StartPreloading(manifestPath);
+}
+
+void Runtime::FinishModulePreloading() {
+    m_module.FinishPreloading();
+}
+
+void Runtime::InvalidateResolvedModulePaths() {
+    m_module.InvalidateResolvedPaths();
+}
+
 static void InitializeV8() {
     Runtime::platform =
 #ifdef APPLICATION_IN_DEBUG
@@ -470,6 +609,11 @@ static void InitializeV8() {
 Isolate* Runtime::PrepareV8Runtime(const string& filesPath, const string& nativeLibDir, const string& packageName, bool isDebuggable, const string& callingDir, const string& profilerOutputDir, const int maxLogcatObjectSize, const bool forceLog) {
     tns::instrumentation::Frame frame("Runtime.PrepareV8Runtime");
 
+    // Do not build metadata (which should be static for the process) for non-main threads
+    if (!s_mainThreadInitialized) {
+        MetadataNode::StartBuildingMetadata(filesPath);
+    }
+
     Isolate::CreateParams create_params;
     bool didInitializeV8 = false;
 
@@ -602,7 +746,16 @@ Isolate* Runtime::PrepareV8Runtime(const string& filesPath, const string& native
     auto consts = new V8StringConstants::PerIsolateV8Constants(isolate);
     isolate->SetData((uint32_t)Runtime::IsolateData::CONSTANTS, consts);
 
+#ifdef RUNTIME_STATS_ENABLED
+    RuntimeStats::Init(isolate, &m_runtimeStats);
+#endif
+
     V8::SetFlagsFromString(Constants::V8_STARTUP_FLAGS.c_str(), Constants::V8_STARTUP_FLAGS.size());
+
+    // the tag of the caches depends on the flags
+    if (Constants::V8_CACHE_COMPILED_CODE) {
+        CodeCacheBundle::GetInstance()->Open(filesPath + "/code-cache.bundle", ScriptCompiler::CachedDataVersionTag(), Runtime::platform);
+    }
     isolate->SetCaptureStackTraceForUncaughtExceptions(true, 100, StackTrace::kOverview);
 
     isolate->AddMessageListener(NativeScriptException::OnUncaughtError);
@@ -625,6 +778,9 @@ Isolate* Runtime::PrepareV8Runtime(const string& filesPath, const string& native
     globalTemplate->Set(ArgConverter::ConvertToV8String(isolate, "__time"), FunctionTemplate::New(isolate, CallbackHandlers::TimeCallback));
     globalTemplate->Set(ArgConverter::ConvertToV8String(isolate, "__releaseNativeCounterpart"), FunctionTemplate::New(isolate, CallbackHandlers::ReleaseNativeCounterpartCallback));
     globalTemplate->Set(ArgConverter::ConvertToV8String(isolate, "__markingMode"), Number::New(isolate, m_objectManager->GetMarkingMode()), readOnlyFlags);
+#ifdef RUNTIME_STATS_ENABLED
+    globalTemplate->Set(ArgConverter::ConvertToV8String(isolate, "__runtimeStats"), FunctionTemplate::New(isolate, CallbackHandlers::RuntimeStatsCallback));
+#endif
 
 
     /*
@@ -712,14 +868,16 @@ Isolate* Runtime::PrepareV8Runtime(const string& filesPath, const string& native
 
     m_profiler.Init(isolate, global, packageName, profilerOutputDir);
 
-    // Do not build metadata (which should be static for the process) for non-main threads
-    if (!s_mainThreadInitialized) {
-        MetadataNode::BuildMetadata(filesPath);
-    }
+    m_nearHeapLimitHandler.Init(isolate, m_runtime, m_objectManager, packageName, profilerOutputDir.empty() ? filesPath : profilerOutputDir);
 
     auto enableProfiler = !profilerOutputDir.empty();
     MetadataNode::EnableProfiler(enableProfiler);
 
+    // the first use of the metadata, built while the isolate was created
+    if (!s_mainThreadInitialized) {
+        MetadataNode::WaitForMetadata();
+    }
+
     MetadataNode::CreateTopLevelNamespaces(isolate, global);
 
     ArrayHelper::Init(context);
@@ -747,13 +905,72 @@ jobject Runtime::ConvertJsValueToJavaObject(JEnv& env, const Local<Value>& value
     return javaResult;
 }
 
+jvalue Runtime::ConvertJsValueToJavaPrimitive(const Local<Value>& value, char retType, const Local<v8::String>& methodName) {
+    jvalue result;
+    result.j = 0;
+
+    if (retType == 'V') {
+        return result;
+    }
+
+    auto isolate = m_isolate;
+    auto context = this->GetContext();
+
+    bool success = false;
+    if (retType == 'Z') {
+        if (!value.IsEmpty() && (value->IsBoolean() || value->IsBooleanObject())) {
+            result.z = value->BooleanValue(isolate) ? JNI_TRUE : JNI_FALSE;
+            success = true;
+        }
+    } else if (!value.IsEmpty() && (value->IsNumber() || value->IsNumberObject())) {
+        double number = value->NumberValue(context).ToChecked();
+        switch (retType) {
+            case 'I':
+                result.i = value->Int32Value(context).ToChecked();
+                break;
+            case 'J':
+                result.j = (jlong) number;
+                break;
+            case 'F':
+                result.f = (jfloat) number;
+                break;
+            case 'D':
+                result.d = number;
+                break;
+        }
+        success = true;
+    } else if (retType == 'J' && !value.IsEmpty() && value->IsObject()) {
+        // NativeScriptLongNumber or long(x) cast
+        result.j = ArgConverter::ConvertToJavaLong(isolate, value);
+        success = true;
+    }
+
+    if (!success) {
+        stringstream ss;
+        ss << "Cannot convert the value returned by js method " << ArgConverter::ConvertToString(methodName) << " to Java type '" << retType << "'";
+        throw NativeScriptException(ss.str());
+    }
+
+    return result;
+}
+
 void Runtime::SetManualInstrumentationMode(jstring mode) {
     auto modeStr = ArgConverter::jstringToString(mode);
     if (modeStr == "timeline") {
         tns::instrumentation::Frame::enable();
+    } else if (modeStr == "trace") {
+        TraceRecorder::Start();
     }
 }
 
+void Runtime::AddTraceEvent(jstring name, jlong startNanos, jlong endNanos) {
+    TraceRecorder::AddComplete("java", ArgConverter::jstringToString(name), startNanos, endNanos);
+}
+
+bool Runtime::WriteTrace(jstring path) {
+    return TraceRecorder::Write(ArgConverter::jstringToString(path));
+}
+
 StartupData Runtime::CreateSnapshotDataBlob(const char* embedded_source) {
     // Create a new isolate and a new context from scratch, optionally run
     // a script to embed, and serialize to create a snapshot blob.
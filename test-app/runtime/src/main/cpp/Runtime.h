@@ -10,15 +10,29 @@
 #include "Profiler.h"
 #include "ModuleInternal.h"
 #include "MessageLoopTimer.h"
+#include "NearHeapLimitHandler.h"
 #include "File.h"
+#include "LifecycleState.h"
+#include "RuntimeStats.h"
 #include <mutex>
+#include <vector>
 
 namespace tns {
 class Runtime {
     public:
         enum IsolateData {
             RUNTIME = 0,
-            CONSTANTS = 1
+            CONSTANTS = 1,
+            RUNTIME_STATS = 2
+        };
+
+        /*
+         * Keep the members in sync with the java/com/tns/MemoryPressureLevel.
+         */
+        enum class MemoryPressureLevel {
+            None,
+            Moderate,
+            Critical
         };
 
         ~Runtime();
@@ -36,6 +50,13 @@ class Runtime {
 
         static void SetManualInstrumentationMode(jstring mode);
 
+        /*
+         * Records a frame of the Java code, with the times of System.nanoTime.
+         */
+        static void AddTraceEvent(jstring name, jlong startNanos, jlong endNanos);
+
+        static bool WriteTrace(jstring path);
+
         void Init(JNIEnv* env, jstring filesPath, jstring nativeLibsDir, bool verboseLoggingEnabled, bool isDebuggable, jstring packageName, jobjectArray args, jstring callingDir, int maxLogcatObjectSize, bool forceLog);
 
         v8::Isolate* GetIsolate() const;
@@ -47,15 +68,20 @@ class Runtime {
         void RunModule(JNIEnv* _env, jobject obj, jstring scriptFile);
         void RunWorker(jstring scriptFile);
         jobject RunScript(JNIEnv* _env, jobject obj, jstring scriptFile);
-        jobject CallJSMethodNative(JNIEnv* _env, jobject obj, jint javaObjectID, jstring methodName, jint retType, jboolean isConstructor, jobjectArray packagedArgs);
+        jobject CallJSMethodNative(JNIEnv* _env, jobject obj, jint javaObjectID, jint methodSlot, jint retType, jboolean isConstructor, jobjectArray packagedArgs);
+        jvalue CallJSMethodNativeUnboxed(JNIEnv* _env, jint javaObjectID, jint methodSlot, const char* argTypes, const jvalue* args, char retType);
         void CreateJSInstanceNative(JNIEnv* _env, jobject obj, jobject javaObject, jint javaObjectID, jstring className);
-        jint GenerateNewObjectId(JNIEnv* env, jobject obj);
         void AdjustAmountOfExternalAllocatedMemory();
         bool NotifyGC(JNIEnv* env, jobject obj);
         bool TryCallGC();
         void PassExceptionToJsNative(JNIEnv* env, jobject obj, jthrowable exception, jstring message, jstring fullStackTrace, jstring jsStackTrace, jboolean isDiscarded);
         void PassUncaughtExceptionFromWorkerToMainHandler(v8::Local<v8::String> message, v8::Local<v8::String> stackTrace, v8::Local<v8::String> filename, int lineno);
         void ClearStartupData(JNIEnv* env, jobject obj);
+        void NotifyMemoryPressure(MemoryPressureLevel level);
+        void NotifyInBackground(bool isInBackground);
+        void StartModulePreloading(const std::string& manifestPath);
+        void FinishModulePreloading();
+        void InvalidateResolvedModulePaths();
         void DestroyRuntime();
 
         void Lock();
@@ -67,6 +93,12 @@ class Runtime {
 
         static v8::Platform* platform;
 
+        /*
+         * The maximum number of arguments passed to CallJSMethodNativeUnboxed.
+         * Keep in sync with the typed callJSMethod entry points in java/com/tns/Runtime.
+         */
+        static const int MAX_UNBOXED_ARGS = 4;
+
         std::string ReadFileText(const std::string& filePath);
 
     private:
@@ -86,6 +118,8 @@ class Runtime {
 
         Profiler m_profiler;
 
+        NearHeapLimitHandler m_nearHeapLimitHandler;
+
         MessageLoopTimer* m_loopTimer;
 
         v8::StartupData* m_startupData = nullptr;
@@ -96,10 +130,25 @@ class Runtime {
         v8::Persistent<v8::Function>* m_gcFunc;
         volatile bool m_runGC;
 
+        LifecycleState m_lifecycleState;
+
         v8::Persistent<v8::Context>* m_context;
 
+#ifdef RUNTIME_STATS_ENABLED
+        RuntimeStats m_runtimeStats;
+#endif
+
+        /*
+         * Interned names of the JS methods called from Java, indexed by the slot handles of
+         * com.tns.Runtime.getMethodSlot. Filled on the first call of each method.
+         */
+        std::vector<v8::Persistent<v8::String>*> m_methodSlots;
+
         v8::Isolate* PrepareV8Runtime(const std::string& filesPath, const std::string& nativeLibsDir, const std::string& packageName, bool isDebuggable, const std::string& callingDir, const std::string& profilerOutputDir, const int maxLogcatObjectSize, const bool forceLog);
         jobject ConvertJsValueToJavaObject(JEnv& env, const v8::Local<v8::Value>& value, int classReturnType);
+        jvalue ConvertJsValueToJavaPrimitive(const v8::Local<v8::Value>& value, char retType, const v8::Local<v8::String>& methodName);
+        v8::Local<v8::Object> GetJsObjectForCallback(jint javaObjectID, const v8::Local<v8::String>& methodName);
+        v8::Local<v8::String> GetMethodSlotName(jint methodSlot);
         static v8::StartupData CreateSnapshotDataBlob(const char* embedded_source);
         static bool RunExtraCode(v8::Isolate* isolate, v8::Local<v8::Context> context, const char* utf8_source, const char* name);
         static int GetAndroidVersion();
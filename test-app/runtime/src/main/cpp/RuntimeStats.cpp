@@ -0,0 +1,125 @@
+#include "RuntimeStats.h"
+
+#ifdef RUNTIME_STATS_ENABLED
+
+using namespace v8;
+using namespace std;
+using namespace tns;
+
+RuntimeStats::RuntimeStats() {
+    for (auto& counter : m_counters) {
+        counter.store(0, memory_order_relaxed);
+    }
+
+    for (auto& histogram : m_histograms) {
+        histogram.count.store(0, memory_order_relaxed);
+        histogram.totalMicroseconds.store(0, memory_order_relaxed);
+        for (auto& bucket : histogram.buckets) {
+            bucket.store(0, memory_order_relaxed);
+        }
+    }
+}
+
+void RuntimeStats::Init(Isolate* isolate, RuntimeStats* stats) {
+    isolate->SetData(ISOLATE_DATA_SLOT, stats);
+}
+
+void RuntimeStats::Record(Histogram histogram, uint64_t microseconds) {
+    int bucket = (microseconds == 0) ? 0 : 64 - __builtin_clzll(microseconds);
+    if (bucket >= HISTOGRAM_BUCKETS) {
+        bucket = HISTOGRAM_BUCKETS - 1;
+    }
+
+    auto& h = m_histograms[static_cast<int>(histogram)];
+    h.count.fetch_add(1, memory_order_relaxed);
+    h.totalMicroseconds.fetch_add(microseconds, memory_order_relaxed);
+    h.buckets[bucket].fetch_add(1, memory_order_relaxed);
+}
+
+void RuntimeStats::TakeSnapshot(Snapshot& snapshot) const {
+    for (int i = 0; i < static_cast<int>(Counter::END); i++) {
+        snapshot.counters[i] = m_counters[i].load(memory_order_relaxed);
+    }
+
+    for (int i = 0; i < static_cast<int>(Histogram::END); i++) {
+        auto& h = m_histograms[i];
+        auto& s = snapshot.histograms[i];
+        s.count = h.count.load(memory_order_relaxed);
+        s.totalMicroseconds = h.totalMicroseconds.load(memory_order_relaxed);
+        for (int j = 0; j < HISTOGRAM_BUCKETS; j++) {
+            s.buckets[j] = h.buckets[j].load(memory_order_relaxed);
+        }
+    }
+}
+
+const char* RuntimeStats::GetName(Counter counter) {
+    switch (counter) {
+        case Counter::GcCycles:
+            return "gcCycles";
+        case Counter::MarkReachableObjectsRuns:
+            return "markReachableObjectsRuns";
+        case Counter::RegularObjectsMadeWeak:
+            return "regularObjectsMadeWeak";
+        case Counter::ImplObjectsMadeWeak:
+            return "implObjectsMadeWeak";
+        case Counter::WeakObjectsChecked:
+            return "weakObjectsChecked";
+        case Counter::WeakObjectsReleased:
+            return "weakObjectsReleased";
+        case Counter::JavaObjectCacheLookups:
+            return "javaObjectCacheLookups";
+        case Counter::JavaObjectCacheLoads:
+            return "javaObjectCacheLoads";
+        case Counter::JavaObjectCacheUpdates:
+            return "javaObjectCacheUpdates";
+        case Counter::ForcedGcs:
+            return "forcedGcs";
+        case Counter::JavaMethodCalls:
+            return "javaMethodCalls";
+        case Counter::JsMethodCalls:
+            return "jsMethodCalls";
+        case Counter::ConstructorTemplatesCreated:
+            return "constructorTemplatesCreated";
+        case Counter::JsWrappersCreated:
+            return "jsWrappersCreated";
+        case Counter::PendingFinalizations:
+            return "pendingFinalizations";
+        case Counter::ObjectsLinked:
+            return "objectsLinked";
+        case Counter::ObjectsUnlinked:
+            return "objectsUnlinked";
+        case Counter::MemoryPressureNotifications:
+            return "memoryPressureNotifications";
+        case Counter::NearHeapLimitEvents:
+            return "nearHeapLimitEvents";
+        case Counter::HeapReclaims:
+            return "heapReclaims";
+        case Counter::CodeCacheHits:
+            return "codeCacheHits";
+        case Counter::CodeCacheMisses:
+            return "codeCacheMisses";
+        case Counter::CodeCacheRejected:
+            return "codeCacheRejected";
+        case Counter::BackgroundCompilations:
+            return "backgroundCompilations";
+        default:
+            return "unknown";
+    }
+}
+
+const char* RuntimeStats::GetName(Histogram histogram) {
+    switch (histogram) {
+        case Histogram::GcFinished:
+            return "gcFinished";
+        case Histogram::MarkReachableObjects:
+            return "markReachableObjects";
+        case Histogram::PendingFinalizationsFlush:
+            return "pendingFinalizationsFlush";
+        case Histogram::TracePrologue:
+            return "tracePrologue";
+        default:
+            return "unknown";
+    }
+}
+
+#endif /* RUNTIME_STATS_ENABLED */
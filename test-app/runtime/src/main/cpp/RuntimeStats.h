@@ -0,0 +1,150 @@
+#ifndef RUNTIMESTATS_H_
+#define RUNTIMESTATS_H_
+
+#include "v8.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#ifdef RUNTIME_STATS_ENABLED
+
+namespace tns {
+/*
+ * Per isolate counters and latency histograms of the work the runtime does on behalf of the GC
+ * and the JS <-> Java interop. All the updates are relaxed atomic operations, so they can be
+ * done from any thread without taking a lock.
+ */
+class RuntimeStats {
+    public:
+        enum class Counter {
+            GcCycles,
+            MarkReachableObjectsRuns,
+            RegularObjectsMadeWeak,
+            ImplObjectsMadeWeak,
+            WeakObjectsChecked,
+            WeakObjectsReleased,
+            JavaObjectCacheLookups,
+            JavaObjectCacheLoads,
+            JavaObjectCacheUpdates,
+            ForcedGcs,
+            JavaMethodCalls,
+            JsMethodCalls,
+            ConstructorTemplatesCreated,
+            JsWrappersCreated,
+            PendingFinalizations,
+            ObjectsLinked,
+            ObjectsUnlinked,
+            MemoryPressureNotifications,
+            NearHeapLimitEvents,
+            HeapReclaims,
+            CodeCacheHits,
+            CodeCacheMisses,
+            CodeCacheRejected,
+            BackgroundCompilations,
+            END
+        };
+
+        enum class Histogram {
+            GcFinished,
+            MarkReachableObjects,
+            PendingFinalizationsFlush,
+            TracePrologue,
+            END
+        };
+
+        /*
+         * The bucket i counts the durations in [2^(i-1), 2^i) microseconds, the first bucket the ones below 1us
+         * and the last one everything longer than the previous bucket.
+         */
+        static const int HISTOGRAM_BUCKETS = 24;
+
+        struct HistogramSnapshot {
+            uint64_t count;
+            uint64_t totalMicroseconds;
+            uint64_t buckets[HISTOGRAM_BUCKETS];
+        };
+
+        struct Snapshot {
+            uint64_t counters[static_cast<int>(Counter::END)];
+            HistogramSnapshot histograms[static_cast<int>(Histogram::END)];
+        };
+
+        RuntimeStats();
+
+        inline void Increment(Counter counter, uint64_t value = 1) {
+            m_counters[static_cast<int>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+
+        void Record(Histogram histogram, uint64_t microseconds);
+
+        void TakeSnapshot(Snapshot& snapshot) const;
+
+        static inline RuntimeStats* Get(v8::Isolate* isolate) {
+            return static_cast<RuntimeStats*>(isolate->GetData(ISOLATE_DATA_SLOT));
+        }
+
+        static void Init(v8::Isolate* isolate, RuntimeStats* stats);
+
+        static const char* GetName(Counter counter);
+
+        static const char* GetName(Histogram histogram);
+
+        /*
+         * Records the lifetime of the scope in a histogram.
+         */
+        class Timer {
+            public:
+                inline Timer(v8::Isolate* isolate, Histogram histogram)
+                    : m_stats(Get(isolate)), m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {
+                }
+
+                inline ~Timer() {
+                    if (m_stats != nullptr) {
+                        auto duration = std::chrono::steady_clock::now() - m_start;
+                        m_stats->Record(m_histogram, std::chrono::duration_cast<std::chrono::microseconds>(duration).count());
+                    }
+                }
+
+            private:
+                RuntimeStats* m_stats;
+                Histogram m_histogram;
+                std::chrono::steady_clock::time_point m_start;
+
+                Timer(const Timer&) = delete;
+                Timer& operator=(const Timer&) = delete;
+        };
+
+    private:
+        struct AtomicHistogram {
+            std::atomic<uint64_t> count;
+            std::atomic<uint64_t> totalMicroseconds;
+            std::atomic<uint64_t> buckets[HISTOGRAM_BUCKETS];
+        };
+
+        // keep in sync with Runtime::IsolateData
+        static const uint32_t ISOLATE_DATA_SLOT = 2;
+
+        std::atomic<uint64_t> m_counters[static_cast<int>(Counter::END)];
+
+        AtomicHistogram m_histograms[static_cast<int>(Histogram::END)];
+};
+}
+
+#define RUNTIME_STATS_INCREMENT(isolate, counter) \
+    do { auto __tns_runtime_stats = tns::RuntimeStats::Get(isolate); if (__tns_runtime_stats != nullptr) { __tns_runtime_stats->Increment(tns::RuntimeStats::Counter::counter); } } while (0)
+
+#define RUNTIME_STATS_ADD(isolate, counter, value) \
+    do { auto __tns_runtime_stats = tns::RuntimeStats::Get(isolate); if (__tns_runtime_stats != nullptr) { __tns_runtime_stats->Increment(tns::RuntimeStats::Counter::counter, value); } } while (0)
+
+#define RUNTIME_STATS_TIMER(isolate, histogram) \
+    tns::RuntimeStats::Timer __tns_runtime_stats_timer(isolate, tns::RuntimeStats::Histogram::histogram)
+
+#else
+
+#define RUNTIME_STATS_INCREMENT(isolate, counter) do { } while (0)
+#define RUNTIME_STATS_ADD(isolate, counter, value) do { } while (0)
+#define RUNTIME_STATS_TIMER(isolate, histogram) do { } while (0)
+
+#endif /* RUNTIME_STATS_ENABLED */
+
+#endif /* RUNTIMESTATS_H_ */
@@ -0,0 +1,217 @@
+#include "TraceRecorder.h"
+#include <cstdio>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace tns;
+
+TraceRecorder::Scope::Scope(const char* category, const string& name, int64_t thresholdMicros)
+    : m_category(category), m_name(&name), m_detail(nullptr), m_thresholdNanos(thresholdMicros * 1000),
+      m_start(IsEnabled() ? Now() : -1) {
+}
+
+TraceRecorder::Scope::Scope(const char* category, const string& name, const string& detail, int64_t thresholdMicros)
+    : m_category(category), m_name(&name), m_detail(&detail), m_thresholdNanos(thresholdMicros * 1000),
+      m_start(IsEnabled() ? Now() : -1) {
+}
+
+TraceRecorder::Scope::~Scope() {
+    if (m_start == -1) {
+        return;
+    }
+
+    auto end = Now();
+    if (end - m_start < m_thresholdNanos) {
+        return;
+    }
+
+    if (m_detail == nullptr) {
+        AddComplete(m_category, *m_name, m_start, end);
+    } else {
+        AddComplete(m_category, *m_name + " " + *m_detail, m_start, end);
+    }
+}
+
+void TraceRecorder::Start(size_t eventsPerThread) {
+    s_eventsPerThread = eventsPerThread > 0 ? eventsPerThread : 1;
+    s_isEnabled = true;
+}
+
+void TraceRecorder::Stop() {
+    s_isEnabled = false;
+}
+
+int64_t TraceRecorder::Now() {
+    return chrono::duration_cast<chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+void TraceRecorder::AddComplete(const char* category, const string& name, int64_t startNanos, int64_t endNanos) {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    Add(category, name, startNanos, endNanos > startNanos ? endNanos - startNanos : 0);
+}
+
+void TraceRecorder::AddInstant(const char* category, const string& name) {
+    if (!IsEnabled()) {
+        return;
+    }
+
+    Add(category, name, Now(), -1);
+}
+
+void TraceRecorder::Add(const char* category, const string& name, int64_t start, int64_t duration) {
+    auto buffer = GetThreadBuffer();
+    auto capacity = s_eventsPerThread.load(memory_order_relaxed);
+
+    lock_guard<mutex> lock(buffer->mutex);
+
+    Event* event;
+    if (buffer->events.size() < capacity) {
+        buffer->events.emplace_back();
+        event = &buffer->events.back();
+    } else {
+        // overwrites the oldest event, reusing the memory of its name
+        event = &buffer->events[buffer->next];
+        buffer->next = (buffer->next + 1) % buffer->events.size();
+        buffer->droppedCount++;
+    }
+
+    event->name = name;
+    event->category = category;
+    event->start = start;
+    event->duration = duration;
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::GetThreadBuffer() {
+    static thread_local ThreadBuffer* buffer = nullptr;
+    if (buffer != nullptr) {
+        return buffer;
+    }
+
+    buffer = new ThreadBuffer();
+    buffer->tid = static_cast<int>(syscall(SYS_gettid));
+    buffer->next = 0;
+    buffer->droppedCount = 0;
+
+    // the name set by Java or by V8 for its workers
+    char name[17] = {};
+    if (prctl(PR_GET_NAME, name) == 0) {
+        buffer->threadName = name;
+    }
+
+    lock_guard<mutex> lock(s_buffersMutex);
+    s_buffers.push_back(buffer);
+
+    return buffer;
+}
+
+bool TraceRecorder::Write(const string& path) {
+    auto pid = static_cast<int>(getpid());
+    string json("{\"traceEvents\":[");
+    bool isFirst = true;
+    uint64_t droppedCount = 0;
+
+    {
+        lock_guard<mutex> lock(s_buffersMutex);
+        for (auto buffer : s_buffers) {
+            lock_guard<mutex> bufferLock(buffer->mutex);
+
+            if (!isFirst) {
+                json += ',';
+            }
+            isFirst = false;
+
+            json += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + to_string(pid) + ",\"tid\":" + to_string(buffer->tid) + ",\"args\":{\"name\":\"";
+            AppendEscaped(json, buffer->threadName);
+            json += "\"}}";
+
+            // from the oldest event
+            auto count = buffer->events.size();
+            for (size_t i = 0; i < count; i++) {
+                json += ',';
+                AppendEvent(json, buffer->events[(buffer->next + i) % count], pid, buffer->tid);
+            }
+
+            droppedCount += buffer->droppedCount;
+        }
+    }
+
+    json += "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":\"" + to_string(droppedCount) + "\"}}\n";
+
+    auto tmpPath = path + ".tmp";
+    auto file = fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+
+    bool isWritten = fwrite(json.data(), 1, json.size(), file) == json.size();
+    isWritten = fclose(file) == 0 && isWritten;
+
+    if (!isWritten || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        unlink(tmpPath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void TraceRecorder::AppendEvent(string& json, const Event& event, int pid, int tid) {
+    char numbers[96];
+
+    json += "{\"name\":\"";
+    AppendEscaped(json, event.name);
+    json += "\",\"cat\":\"";
+    json += event.category;
+
+    // in microseconds, keeping the nanoseconds
+    if (event.duration < 0) {
+        snprintf(numbers, sizeof(numbers), "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lld.%03d",
+                 static_cast<long long>(event.start / 1000), static_cast<int>(event.start % 1000));
+    } else {
+        snprintf(numbers, sizeof(numbers), "\",\"ph\":\"X\",\"ts\":%lld.%03d,\"dur\":%lld.%03d",
+                 static_cast<long long>(event.start / 1000), static_cast<int>(event.start % 1000),
+                 static_cast<long long>(event.duration / 1000), static_cast<int>(event.duration % 1000));
+    }
+    json += numbers;
+
+    json += ",\"pid\":" + to_string(pid) + ",\"tid\":" + to_string(tid) + "}";
+}
+
+void TraceRecorder::AppendEscaped(string& json, const string& value) {
+    for (char c : value) {
+        switch (c) {
+        case '"':
+            json += "\\\"";
+            break;
+        case '\\':
+            json += "\\\\";
+            break;
+        case '\n':
+            json += "\\n";
+            break;
+        case '\r':
+            json += "\\r";
+            break;
+        case '\t':
+            json += "\\t";
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char escaped[8];
+                snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                json += escaped;
+            } else {
+                json += c;
+            }
+        }
+    }
+}
+
+atomic<bool> TraceRecorder::s_isEnabled(false);
+atomic<size_t> TraceRecorder::s_eventsPerThread(TraceRecorder::DEFAULT_EVENTS_PER_THREAD);
+mutex TraceRecorder::s_buffersMutex;
+vector<TraceRecorder::ThreadBuffer*> TraceRecorder::s_buffers;
@@ -0,0 +1,112 @@
+#ifndef TRACERECORDER_H_
+#define TRACERECORDER_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tns {
+/*
+ * Records a timeline of the runtime and writes it as a Chrome trace-event JSON file, which can be
+ * opened in chrome://tracing or https://ui.perfetto.dev.
+ *
+ * Each thread records into a ring buffer of its own, so only the latest events of a busy thread are
+ * kept. The times are taken from the monotonic clock, the one System.nanoTime reads, so the events
+ * of the Java frames line up with the native ones. Until Start is called, recording costs a relaxed
+ * load of a flag.
+ */
+class TraceRecorder {
+    public:
+        typedef std::chrono::steady_clock Clock;
+
+        static void Start(size_t eventsPerThread = DEFAULT_EVENTS_PER_THREAD);
+
+        static void Stop();
+
+        static inline bool IsEnabled() {
+            return s_isEnabled.load(std::memory_order_relaxed);
+        }
+
+        /*
+         * Records an event which started and ended at the given times, in the nanoseconds of the monotonic clock.
+         */
+        static void AddComplete(const char* category, const std::string& name, int64_t startNanos, int64_t endNanos);
+
+        static void AddInstant(const char* category, const std::string& name);
+
+        static int64_t Now();
+
+        /*
+         * Writes the events recorded so far, replacing the file. Returns false if it cannot be written.
+         */
+        static bool Write(const std::string& path);
+
+        /*
+         * Records the time from its construction to its destruction. The name and the detail,
+         * joined by a space, are copied only when the event is recorded, so they have to outlive
+         * the scope. Events shorter than the threshold are dropped.
+         */
+        class Scope {
+            public:
+                Scope(const char* category, const std::string& name, int64_t thresholdMicros = 0);
+
+                Scope(const char* category, const std::string& name, const std::string& detail, int64_t thresholdMicros = 0);
+
+                ~Scope();
+
+            private:
+                const char* m_category;
+                const std::string* m_name;
+                const std::string* m_detail;
+                int64_t m_thresholdNanos;
+                int64_t m_start;
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+        };
+
+        static const size_t DEFAULT_EVENTS_PER_THREAD = 16384;
+
+    private:
+        struct Event {
+            std::string name;
+            const char* category;
+            int64_t start;
+            // -1 for an instant event
+            int64_t duration;
+        };
+
+        struct ThreadBuffer {
+            int tid;
+            std::string threadName;
+            // locked by its thread when recording, and by Write
+            std::mutex mutex;
+            std::vector<Event> events;
+            // the slot of the next event once the buffer is full
+            size_t next;
+            uint64_t droppedCount;
+        };
+
+        static ThreadBuffer* GetThreadBuffer();
+
+        static void Add(const char* category, const std::string& name, int64_t start, int64_t duration);
+
+        static void AppendEvent(std::string& json, const Event& event, int pid, int tid);
+
+        static void AppendEscaped(std::string& json, const std::string& value);
+
+        static std::atomic<bool> s_isEnabled;
+
+        static std::atomic<size_t> s_eventsPerThread;
+
+        static std::mutex s_buffersMutex;
+
+        // the buffers outlive their threads, so that the events of the finished threads are written too
+        static std::vector<ThreadBuffer*> s_buffers;
+};
+}
+
+#endif /* TRACERECORDER_H_ */
@@ -0,0 +1,37 @@
+#ifndef XXHASH_H_
+#define XXHASH_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tns {
+/*
+ * The 64-bit xxHash of a buffer (XXH64). It reads the input eight bytes at a time, so the modules,
+ * the code caches and the manifests can be checked on every load without it showing in the startup.
+ *
+ * Not a cryptographic hash: it detects changed content, not tampering.
+ */
+class XxHash {
+    public:
+        static uint64_t Hash64(const void* data, size_t length, uint64_t seed = 0);
+
+    private:
+        static uint64_t Round(uint64_t acc, uint64_t input);
+
+        static uint64_t MergeRound(uint64_t acc, uint64_t value);
+
+        static uint64_t RotateLeft(uint64_t value, int bits);
+
+        static uint64_t Read64(const uint8_t* p);
+
+        static uint32_t Read32(const uint8_t* p);
+
+        static const uint64_t PRIME64_1 = 0x9E3779B185EBCA87ULL;
+        static const uint64_t PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+        static const uint64_t PRIME64_3 = 0x165667B19E3779F9ULL;
+        static const uint64_t PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+        static const uint64_t PRIME64_5 = 0x27D4EB2F165667C5ULL;
+};
+}
+
+#endif /* XXHASH_H_ */
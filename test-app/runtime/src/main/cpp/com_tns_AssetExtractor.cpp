@@ -7,9 +7,9 @@
 using namespace tns;
 using namespace std;
 
-extern "C" JNIEXPORT void Java_com_tns_AssetExtractor_extractAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir, jboolean _forceOverwrite) {
+extern "C" JNIEXPORT void Java_com_tns_AssetExtractor_extractAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir, jstring manifestPath, jboolean _forceOverwrite) {
     try {
-        AssetExtractor::ExtractAssets(env, obj, apk, inputDir, outputDir, _forceOverwrite);
+        AssetExtractor::ExtractAssets(env, obj, apk, inputDir, outputDir, manifestPath, _forceOverwrite);
     } catch (NativeScriptException& e) {
         e.ReThrowToJava();
     } catch (std::exception e) {
@@ -22,3 +22,20 @@ extern "C" JNIEXPORT void Java_com_tns_AssetExtractor_extractAssets(JNIEnv* env,
         nsEx.ReThrowToJava();
     }
 }
+
+extern "C" JNIEXPORT jboolean Java_com_tns_AssetExtractor_mountAssets(JNIEnv* env, jobject obj, jstring apk, jstring inputDir, jstring outputDir) {
+    try {
+        return AssetExtractor::MountAssets(env, obj, apk, inputDir, outputDir) ? JNI_TRUE : JNI_FALSE;
+    } catch (NativeScriptException& e) {
+        e.ReThrowToJava();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToJava();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+    }
+    return JNI_FALSE;
+}
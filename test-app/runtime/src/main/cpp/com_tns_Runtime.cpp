@@ -1,7 +1,9 @@
+#include "ArgConverter.h"
 #include "V8StringConstants.h"
 #include "Runtime.h"
 #include "NativeScriptException.h"
 #include "CallbackHandlers.h"
+#include <cstring>
 #include <sstream>
 
 using namespace std;
@@ -34,6 +36,26 @@ extern "C" JNIEXPORT void Java_com_tns_Runtime_SetManualInstrumentationMode(JNIE
     }
 }
 
+extern "C" JNIEXPORT void Java_com_tns_Runtime_AddTraceEvent(JNIEnv* _env, jobject obj, jstring name, jlong startNanos, jlong endNanos) {
+    try {
+        Runtime::AddTraceEvent(name, startNanos, endNanos);
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+    }
+}
+
+extern "C" JNIEXPORT jboolean Java_com_tns_Runtime_WriteTrace(JNIEnv* _env, jobject obj, jstring path) {
+    try {
+        return Runtime::WriteTrace(path) ? JNI_TRUE : JNI_FALSE;
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+    }
+
+    return JNI_FALSE;
+}
+
 extern "C" JNIEXPORT void Java_com_tns_Runtime_initNativeScript(JNIEnv* _env, jobject obj, jint runtimeId, jstring filesPath, jstring nativeLibDir, jboolean verboseLoggingEnabled, jboolean isDebuggable, jstring packageName, jobjectArray args, jstring callingDir, jint maxLogcatObjectSize, jboolean forceLog) {
     try {
         Runtime::Init(_env, obj, runtimeId, filesPath, nativeLibDir, verboseLoggingEnabled, isDebuggable, packageName, args, callingDir, maxLogcatObjectSize, forceLog);
@@ -155,7 +177,7 @@ extern "C" JNIEXPORT jobject Java_com_tns_Runtime_runScript(JNIEnv* _env, jobjec
     return result;
 }
 
-extern "C" JNIEXPORT jobject Java_com_tns_Runtime_callJSMethodNative(JNIEnv* _env, jobject obj, jint runtimeId, jint javaObjectID, jstring methodName, jint retType, jboolean isConstructor, jobjectArray packagedArgs) {
+extern "C" JNIEXPORT jobject Java_com_tns_Runtime_callJSMethodNative(JNIEnv* _env, jobject obj, jint runtimeId, jint javaObjectID, jint methodSlot, jint retType, jboolean isConstructor, jobjectArray packagedArgs) {
     jobject result = nullptr;
 
     auto runtime = TryGetRuntime(runtimeId);
@@ -171,7 +193,7 @@ extern "C" JNIEXPORT jobject Java_com_tns_Runtime_callJSMethodNative(JNIEnv* _en
     v8::Context::Scope context_scope(context);
 
     try {
-        result = runtime->CallJSMethodNative(_env, obj, javaObjectID, methodName, retType, isConstructor, packagedArgs);
+        result = runtime->CallJSMethodNative(_env, obj, javaObjectID, methodSlot, retType, isConstructor, packagedArgs);
     } catch (NativeScriptException& e) {
         e.ReThrowToJava();
     } catch (std::exception e) {
@@ -186,7 +208,75 @@ extern "C" JNIEXPORT jobject Java_com_tns_Runtime_callJSMethodNative(JNIEnv* _en
     return result;
 }
 
-extern "C" JNIEXPORT void Java_com_tns_Runtime_createJSInstanceNative(JNIEnv* _env, jobject obj, jint runtimeId, jobject javaObject, jint javaObjectID, jstring className) {
+/*
+ * The primitive arguments and the result are passed as jlongs, the floats by their bits. argTypes
+ * holds the JNI type of each argument in a byte, from the lowest, up to a zero byte.
+ */
+extern "C" JNIEXPORT jlong Java_com_tns_Runtime_callJSMethodNativeUnboxed(JNIEnv* _env, jobject obj, jint runtimeId, jint javaObjectID, jint methodSlot, jint argTypes, jchar retType, jlong arg0, jlong arg1, jlong arg2, jlong arg3) {
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime == nullptr) {
+        return 0;
+    }
+
+    const jlong encodedArgs[Runtime::MAX_UNBOXED_ARGS] = { arg0, arg1, arg2, arg3 };
+    char types[Runtime::MAX_UNBOXED_ARGS + 1] = {};
+    jvalue args[Runtime::MAX_UNBOXED_ARGS];
+
+    for (int i = 0; i < Runtime::MAX_UNBOXED_ARGS; i++) {
+        types[i] = static_cast<char>((argTypes >> (8 * i)) & 0xFF);
+        if (types[i] == 'Z') {
+            args[i].z = encodedArgs[i] != 0 ? JNI_TRUE : JNI_FALSE;
+        } else if (types[i] == 'I') {
+            args[i].i = static_cast<jint>(encodedArgs[i]);
+        } else if (types[i] == 'F') {
+            auto bits = static_cast<int32_t>(encodedArgs[i]);
+            memcpy(&args[i].f, &bits, sizeof(bits));
+        } else {
+            args[i].j = encodedArgs[i];
+        }
+    }
+
+    auto isolate = runtime->GetIsolate();
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolate_scope(isolate);
+    v8::HandleScope handleScope(isolate);
+    auto context = runtime->GetContext();
+    v8::Context::Scope context_scope(context);
+
+    jvalue result;
+    result.j = 0;
+
+    try {
+        result = runtime->CallJSMethodNativeUnboxed(_env, javaObjectID, methodSlot, types, args, static_cast<char>(retType));
+    } catch (NativeScriptException& e) {
+        e.ReThrowToJava();
+        return 0;
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToJava();
+        return 0;
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+        return 0;
+    }
+
+    if (retType == 'Z') {
+        return result.z == JNI_TRUE ? 1 : 0;
+    } else if (retType == 'I') {
+        return result.i;
+    } else if (retType == 'F') {
+        int32_t bits;
+        memcpy(&bits, &result.f, sizeof(bits));
+        return bits;
+    }
+
+    return result.j;
+}
+
+extern "C" JNIEXPORT void Java_com_tns_Runtime_runMarkingSlice(JNIEnv* _env, jobject obj, jint runtimeId) {
     auto runtime = TryGetRuntime(runtimeId);
     if (runtime == nullptr) {
         return;
@@ -200,7 +290,7 @@ extern "C" JNIEXPORT void Java_com_tns_Runtime_createJSInstanceNative(JNIEnv* _e
     v8::Context::Scope context_scope(context);
 
     try {
-        runtime->CreateJSInstanceNative(_env, obj, javaObject, javaObjectID, className);
+        runtime->GetObjectManager()->RunMarkingSlice();
     } catch (NativeScriptException& e) {
         e.ReThrowToJava();
     } catch (std::exception e) {
@@ -214,13 +304,136 @@ extern "C" JNIEXPORT void Java_com_tns_Runtime_createJSInstanceNative(JNIEnv* _e
     }
 }
 
-extern "C" JNIEXPORT jint Java_com_tns_Runtime_generateNewObjectId(JNIEnv* env, jobject obj, jint runtimeId) {
+extern "C" JNIEXPORT void Java_com_tns_Runtime_startModulePreloading(JNIEnv* _env, jobject obj, jint runtimeId, jstring manifestPath) {
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime == nullptr) {
+        return;
+    }
+
+    auto isolate = runtime->GetIsolate();
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolate_scope(isolate);
+    v8::HandleScope handleScope(isolate);
+    auto context = runtime->GetContext();
+    v8::Context::Scope context_scope(context);
+
     try {
-        auto runtime = TryGetRuntime(runtimeId);
-        if (runtime == nullptr) {
-            return 0;
-        }
-        return runtime->GenerateNewObjectId(env, obj);
+        runtime->StartModulePreloading(ArgConverter::jstringToString(manifestPath));
+    } catch (NativeScriptException& e) {
+        e.ReThrowToJava();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToJava();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+    }
+}
+
+extern "C" JNIEXPORT void Java_com_tns_Runtime_finishModulePreloading(JNIEnv* _env, jobject obj, jint runtimeId) {
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime == nullptr) {
+        return;
+    }
+
+    auto isolate = runtime->GetIsolate();
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolate_scope(isolate);
+    v8::HandleScope handleScope(isolate);
+    auto context = runtime->GetContext();
+    v8::Context::Scope context_scope(context);
+
+    try {
+        runtime->FinishModulePreloading();
+    } catch (NativeScriptException& e) {
+        e.ReThrowToJava();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToJava();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+    }
+}
+
+extern "C" JNIEXPORT void Java_com_tns_Runtime_invalidateResolvedModulePathsNative(JNIEnv* _env, jobject obj, jint runtimeId) {
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime != nullptr) {
+        runtime->InvalidateResolvedModulePaths();
+    }
+}
+
+extern "C" JNIEXPORT void Java_com_tns_Runtime_notifyMemoryPressureNative(JNIEnv* _env, jobject obj, jint runtimeId, jint level) {
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime == nullptr) {
+        return;
+    }
+
+    auto isolate = runtime->GetIsolate();
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolate_scope(isolate);
+    v8::HandleScope handleScope(isolate);
+
+    try {
+        runtime->NotifyMemoryPressure(static_cast<Runtime::MemoryPressureLevel>(level));
+    } catch (NativeScriptException& e) {
+        e.ReThrowToJava();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToJava();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+    }
+}
+
+extern "C" JNIEXPORT void Java_com_tns_Runtime_notifyInBackgroundNative(JNIEnv* _env, jobject obj, jint runtimeId, jboolean isInBackground) {
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime == nullptr) {
+        return;
+    }
+
+    auto isolate = runtime->GetIsolate();
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolate_scope(isolate);
+    v8::HandleScope handleScope(isolate);
+
+    try {
+        runtime->NotifyInBackground(isInBackground == JNI_TRUE);
+    } catch (NativeScriptException& e) {
+        e.ReThrowToJava();
+    } catch (std::exception e) {
+        stringstream ss;
+        ss << "Error: c++ exception: " << e.what() << endl;
+        NativeScriptException nsEx(ss.str());
+        nsEx.ReThrowToJava();
+    } catch (...) {
+        NativeScriptException nsEx(std::string("Error: c++ exception!"));
+        nsEx.ReThrowToJava();
+    }
+}
+
+extern "C" JNIEXPORT void Java_com_tns_Runtime_createJSInstanceNative(JNIEnv* _env, jobject obj, jint runtimeId, jobject javaObject, jint javaObjectID, jstring className) {
+    auto runtime = TryGetRuntime(runtimeId);
+    if (runtime == nullptr) {
+        return;
+    }
+
+    auto isolate = runtime->GetIsolate();
+    v8::Locker locker(isolate);
+    v8::Isolate::Scope isolate_scope(isolate);
+    v8::HandleScope handleScope(isolate);
+    auto context = runtime->GetContext();
+    v8::Context::Scope context_scope(context);
+
+    try {
+        runtime->CreateJSInstanceNative(_env, obj, javaObject, javaObjectID, className);
     } catch (NativeScriptException& e) {
         e.ReThrowToJava();
     } catch (std::exception e) {
@@ -232,8 +445,6 @@ extern "C" JNIEXPORT jint Java_com_tns_Runtime_generateNewObjectId(JNIEnv* env,
         NativeScriptException nsEx(std::string("Error: c++ exception!"));
         nsEx.ReThrowToJava();
     }
-    // this is only to avoid warnings, we should never come here
-    return 0;
 }
 
 extern "C" JNIEXPORT jboolean Java_com_tns_Runtime_notifyGc(JNIEnv* env, jobject obj, jint runtimeId) {
@@ -17,12 +17,15 @@ class AppConfig {
         FreeMemoryRatio("freeMemoryRatio", 0.0),
         Profiling("profiling", ""),
         MarkingMode("markingMode", com.tns.MarkingMode.none),
+        MarkingTimeSlice("markingTimeSlice", 0),
+        HeapSnapshotNearHeapLimit("heapSnapshotNearHeapLimit", false),
         HandleTimeZoneChanges("handleTimeZoneChanges", false),
         MaxLogcatObjectSize("maxLogcatObjectSize", 1024),
         ForceLog("forceLog", false),
         DiscardUncaughtJsExceptions("discardUncaughtJsExceptions", false),
         EnableLineBreakpoins("enableLineBreakpoints", false),
-        EnableMultithreadedJavascript("enableMultithreadedJavascript", false);
+        EnableMultithreadedJavascript("enableMultithreadedJavascript", false),
+        PreloadModules("preloadModules", false);
 
         private final String name;
         private final Object defaultValue;
@@ -111,6 +114,12 @@ class AppConfig {
                             }
                         }
                     }
+                    if (androidObject.has(KnownKeys.MarkingTimeSlice.getName())) {
+                        values[KnownKeys.MarkingTimeSlice.ordinal()] = androidObject.getInt(KnownKeys.MarkingTimeSlice.getName());
+                    }
+                    if (androidObject.has(KnownKeys.HeapSnapshotNearHeapLimit.getName())) {
+                        values[KnownKeys.HeapSnapshotNearHeapLimit.ordinal()] = androidObject.getBoolean(KnownKeys.HeapSnapshotNearHeapLimit.getName());
+                    }
                     if (androidObject.has(KnownKeys.HandleTimeZoneChanges.getName())) {
                         values[KnownKeys.HandleTimeZoneChanges.ordinal()] = androidObject.getBoolean(KnownKeys.HandleTimeZoneChanges.getName());
                     }
@@ -126,6 +135,9 @@ class AppConfig {
                     if (androidObject.has(KnownKeys.EnableMultithreadedJavascript.getName())) {
                         values[KnownKeys.EnableMultithreadedJavascript.ordinal()] = androidObject.getBoolean(KnownKeys.EnableMultithreadedJavascript.getName());
                     }
+                    if (androidObject.has(KnownKeys.PreloadModules.getName())) {
+                        values[KnownKeys.PreloadModules.ordinal()] = androidObject.getBoolean(KnownKeys.PreloadModules.getName());
+                    }
                 }
             }
         } catch (Exception e) {
@@ -167,6 +179,14 @@ class AppConfig {
         return (MarkingMode)values[KnownKeys.MarkingMode.ordinal()];
     }
 
+    public int getMarkingTimeSlice() {
+        return (int)values[KnownKeys.MarkingTimeSlice.ordinal()];
+    }
+
+    public boolean getHeapSnapshotNearHeapLimit() {
+        return (boolean)values[KnownKeys.HeapSnapshotNearHeapLimit.ordinal()];
+    }
+
     public boolean handleTimeZoneChanges() {
         return (boolean)values[KnownKeys.HandleTimeZoneChanges.ordinal()];
     }
@@ -190,4 +210,8 @@ class AppConfig {
     public boolean getEnableMultithreadedJavascript() {
         return (boolean)values[KnownKeys.EnableMultithreadedJavascript.ordinal()];
     }
+
+    public boolean getPreloadModules() {
+        return (boolean)values[KnownKeys.PreloadModules.ordinal()];
+    }
 }
@@ -7,7 +7,8 @@ import android.content.Context;
 import android.util.Log;
 
 public class AssetExtractor {
-    private native void extractAssets(String apkPath, String input, String outputDir, boolean checkForNewerFiles);
+    private native void extractAssets(String apkPath, String input, String outputDir, String manifestPath, boolean checkForNewerFiles);
+    private native boolean mountAssets(String apkPath, String input, String outputDir);
     private final Logger logger;
 
     public AssetExtractor(File libPath, Logger logger) {
@@ -22,7 +23,10 @@ public class AssetExtractor {
                 logger.write("extract returned " + success);
             }
         } else if (extractPolicy.shouldExtract(context)) {
-            if (shouldCleanUpPreviousAssets) {
+            File manifest = getExtractionManifest(outputPath, inputPath);
+
+            // with a manifest of the previous extraction, only the removed assets are deleted
+            if (shouldCleanUpPreviousAssets && !manifest.exists()) {
                 try {
                     delete(new File(outputPath + inputPath));
                 } catch (IOException e) {
@@ -35,7 +39,7 @@ public class AssetExtractor {
 
             boolean forceOverwrite = extractPolicy.forceOverwrite();
 
-            extractAssets(apkPath, inputPath, outputPath, forceOverwrite);
+            extractAssets(apkPath, inputPath, outputPath, manifest.getPath(), forceOverwrite);
         } else {
             if (logger.isEnabled()) {
                 logger.write("Skipped extraction of assets in " + inputPath);
@@ -43,6 +47,42 @@ public class AssetExtractor {
         }
     }
 
+    /**
+     * The manifest of the files extracted from inputPath, with the CRC of each, which lets the next extraction skip the unchanged files.
+     */
+    private static File getExtractionManifest(String outputPath, String inputPath) {
+        return new File(outputPath, "assets-" + inputPath.replace('/', '-') + ".manifest");
+    }
+
+    /**
+     * Serve the assets in inputPath to the runtime from the APK, at outputPath + inputPath, instead of extracting them.
+     * The assets are only read natively, so they must not be read through java.io.File.
+     * @return false if the assets cannot be read from the APK and have to be extracted.
+     */
+    public boolean mountAssets(Context context, String inputPath, String outputPath) {
+        String apkPath = context.getPackageCodePath();
+        if (!mountAssets(apkPath, inputPath, outputPath)) {
+            return false;
+        }
+
+        // the mounted assets shadow the ones extracted by a previous version of the application
+        File extractedAssets = new File(outputPath + inputPath);
+        if (extractedAssets.exists()) {
+            try {
+                delete(extractedAssets);
+            } catch (IOException e) {
+                String logTag = "AssetExtraction";
+                Log.d(logTag, "Problem occurred while deleting the extracted assets: " + outputPath + inputPath);
+            }
+        }
+
+        if (logger.isEnabled()) {
+            logger.write("Mounted assets in " + inputPath);
+        }
+
+        return true;
+    }
+
     /**
      * Delete a file or a directory and its children.
      * @param file The directory to delete.
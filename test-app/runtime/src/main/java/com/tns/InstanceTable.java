@@ -0,0 +1,173 @@
+package com.tns;
+
+import java.lang.ref.WeakReference;
+
+/**
+ * Maps the ids of the Java objects bound to JavaScript to the objects themselves.
+ *
+ * The table allocates the ids as well, for the JavaScript side too, and reuses the released ones,
+ * so the ids stay dense and the table is an array split in pages which are dropped once all of their
+ * slots are released. A slot holds either the instance itself, while it is strongly referenced,
+ * or a {@link WeakReference} to it. A bit per slot tells which one.
+ */
+class InstanceTable {
+    private static final int PAGE_SHIFT = 10;
+    private static final int PAGE_SIZE = 1 << PAGE_SHIFT;
+    private static final int PAGE_MASK = PAGE_SIZE - 1;
+
+    private Object[][] pages = new Object[16][];
+    private long[][] weakBits = new long[16][];
+    private int[] pageCounts = new int[16];
+    private int size;
+
+    private int nextId;
+    private int[] freeIds = new int[64];
+    private int freeIdCount;
+
+    public int size() {
+        return size;
+    }
+
+    /**
+     * Returns the most recently freed id, or a new one if there are no free ids.
+     */
+    public int allocateId() {
+        if (freeIdCount > 0) {
+            return freeIds[--freeIdCount];
+        }
+        return nextId++;
+    }
+
+    /**
+     * Removes the instance, if any, and makes its id available to {@link #allocateId()} again.
+     * Call it only once the native side has dropped the id as well.
+     */
+    public void freeId(int id) {
+        remove(id);
+
+        if (freeIdCount == freeIds.length) {
+            int[] newFreeIds = new int[freeIds.length * 2];
+            System.arraycopy(freeIds, 0, newFreeIds, 0, freeIdCount);
+            freeIds = newFreeIds;
+        }
+        freeIds[freeIdCount++] = id;
+    }
+
+    public void putStrong(int id, Object instance) {
+        int pageIndex = id >>> PAGE_SHIFT;
+        ensurePage(pageIndex);
+
+        Object[] page = pages[pageIndex];
+        int slot = id & PAGE_MASK;
+        if (page[slot] == null) {
+            pageCounts[pageIndex]++;
+            size++;
+        }
+        page[slot] = instance;
+        setWeakBit(pageIndex, slot, false);
+    }
+
+    /**
+     * Returns the instance if it is strongly referenced by the table and null otherwise.
+     */
+    public Object getStrong(int id) {
+        int pageIndex = id >>> PAGE_SHIFT;
+        if (!hasPage(pageIndex)) {
+            return null;
+        }
+
+        int slot = id & PAGE_MASK;
+        return isWeakBitSet(pageIndex, slot) ? null : pages[pageIndex][slot];
+    }
+
+    /**
+     * Returns the weak reference to the instance if it is weakly referenced by the table and null otherwise.
+     */
+    @SuppressWarnings("unchecked")
+    public WeakReference<Object> getWeak(int id) {
+        int pageIndex = id >>> PAGE_SHIFT;
+        if (!hasPage(pageIndex)) {
+            return null;
+        }
+
+        int slot = id & PAGE_MASK;
+        return isWeakBitSet(pageIndex, slot) ? (WeakReference<Object>) pages[pageIndex][slot] : null;
+    }
+
+    /**
+     * Replaces the strong reference to the instance with a weak one. Does nothing if the instance is not strongly referenced.
+     */
+    public void makeWeak(int id) {
+        Object instance = getStrong(id);
+        if (instance == null) {
+            return;
+        }
+
+        int pageIndex = id >>> PAGE_SHIFT;
+        int slot = id & PAGE_MASK;
+        pages[pageIndex][slot] = new WeakReference<Object>(instance);
+        setWeakBit(pageIndex, slot, true);
+    }
+
+    public void remove(int id) {
+        int pageIndex = id >>> PAGE_SHIFT;
+        if (!hasPage(pageIndex)) {
+            return;
+        }
+
+        Object[] page = pages[pageIndex];
+        int slot = id & PAGE_MASK;
+        if (page[slot] == null) {
+            return;
+        }
+
+        page[slot] = null;
+        setWeakBit(pageIndex, slot, false);
+        size--;
+
+        if (--pageCounts[pageIndex] == 0) {
+            pages[pageIndex] = null;
+            weakBits[pageIndex] = null;
+        }
+    }
+
+    private boolean hasPage(int pageIndex) {
+        return (pageIndex < pages.length) && (pages[pageIndex] != null);
+    }
+
+    private void ensurePage(int pageIndex) {
+        if (pageIndex >= pages.length) {
+            int newLength = Math.max(pages.length * 2, pageIndex + 1);
+
+            Object[][] newPages = new Object[newLength][];
+            System.arraycopy(pages, 0, newPages, 0, pages.length);
+            pages = newPages;
+
+            long[][] newWeakBits = new long[newLength][];
+            System.arraycopy(weakBits, 0, newWeakBits, 0, weakBits.length);
+            weakBits = newWeakBits;
+
+            int[] newPageCounts = new int[newLength];
+            System.arraycopy(pageCounts, 0, newPageCounts, 0, pageCounts.length);
+            pageCounts = newPageCounts;
+        }
+
+        if (pages[pageIndex] == null) {
+            pages[pageIndex] = new Object[PAGE_SIZE];
+            weakBits[pageIndex] = new long[PAGE_SIZE / 64];
+        }
+    }
+
+    private boolean isWeakBitSet(int pageIndex, int slot) {
+        return (weakBits[pageIndex][slot >>> 6] & (1L << slot)) != 0;
+    }
+
+    private void setWeakBit(int pageIndex, int slot, boolean isWeak) {
+        long[] bits = weakBits[pageIndex];
+        if (isWeak) {
+            bits[slot >>> 6] |= (1L << slot);
+        } else {
+            bits[slot >>> 6] &= ~(1L << slot);
+        }
+    }
+}
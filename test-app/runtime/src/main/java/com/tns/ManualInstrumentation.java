@@ -1,7 +1,11 @@
 package com.tns;
 
+import android.os.Handler;
+import android.os.Looper;
 import android.util.Log;
+import android.view.Choreographer;
 
+import java.io.File;
 import java.util.Stack;
 
 /**
@@ -10,15 +14,31 @@ import java.util.Stack;
 public class ManualInstrumentation {
     private static Mode mode = Mode.Pending;
 
+    private static File traceFile;
+
     public static void setMode(String mode) {
+        setMode(mode, null);
+    }
+
+    /**
+     * In the "trace" mode the frames are recorded by the runtime along with its own, and written in
+     * the Chrome trace-event format to the trace file, once the first frame is drawn and on writeTrace.
+     */
+    public static void setMode(String mode, File traceFile) {
+        // the runtime records the frames of the trace, so it is set first
+        Runtime.SetManualInstrumentationMode(mode);
         switch (mode) {
         case "timeline":
             ManualInstrumentation.setMode(ManualInstrumentation.Mode.Timeline);
             break;
+        case "trace":
+            ManualInstrumentation.traceFile = traceFile;
+            ManualInstrumentation.setMode(ManualInstrumentation.Mode.Trace);
+            writeTraceOnFirstFrame();
+            break;
         default:
             ManualInstrumentation.setMode(ManualInstrumentation.Mode.Disabled);
         }
-        Runtime.SetManualInstrumentationMode(mode);
     }
 
     public static void setMode(Mode mode) {
@@ -27,6 +47,9 @@ public class ManualInstrumentation {
             case Timeline:
                 Mode.PendingFrame.printPending();
                 break;
+            case Trace:
+                Mode.PendingFrame.tracePending();
+                break;
             case Disabled:
                 Mode.PendingFrame.discardPending();
                 break;
@@ -35,6 +58,39 @@ public class ManualInstrumentation {
         ManualInstrumentation.mode = mode;
     }
 
+    /**
+     * Writes the trace recorded so far. Returns false if the mode is not "trace" or the file cannot be written.
+     */
+    public static boolean writeTrace() {
+        if (mode != Mode.Trace || traceFile == null) {
+            return false;
+        }
+
+        return Runtime.WriteTrace(traceFile.getAbsolutePath());
+    }
+
+    private static void writeTraceOnFirstFrame() {
+        final Choreographer.FrameCallback callback = new Choreographer.FrameCallback() {
+            @Override
+            public void doFrame(long frameTimeNanos) {
+                Runtime.AddTraceEvent("First frame", frameTimeNanos, System.nanoTime());
+                writeTrace();
+            }
+        };
+
+        // the choreographer of the main thread
+        if (Looper.myLooper() == Looper.getMainLooper()) {
+            Choreographer.getInstance().postFrameCallback(callback);
+        } else {
+            new Handler(Looper.getMainLooper()).post(new Runnable() {
+                @Override
+                public void run() {
+                    Choreographer.getInstance().postFrameCallback(callback);
+                }
+            });
+        }
+    }
+
     public interface Frame {
         void close();
     }
@@ -70,6 +126,14 @@ public class ManualInstrumentation {
                 frame.name = name;
                 return frame;
             }
+        },
+        /**
+         * This mode hands every frame to the trace recorder of the runtime, with the times of the monotonic clock.
+         */
+        Trace {
+            protected Frame start(String name) {
+                return new TraceFrame(name);
+            }
         };
 
         protected abstract Frame start(String name);
@@ -106,26 +170,45 @@ public class ManualInstrumentation {
             }
         }
 
+        private static class TraceFrame implements Frame {
+            private final String name;
+            private final long startNanos;
+
+            private TraceFrame(String name) {
+                this.name = name;
+                startNanos = System.nanoTime();
+            }
+
+            public void close() {
+                Runtime.AddTraceEvent(name, startNanos, System.nanoTime());
+            }
+        }
+
         private static class PendingFrame implements Frame {
             private static Stack<Mode.PendingFrame> pendingFrames = new Stack<Mode.PendingFrame>();
 
             private long start;
             private long end;
+            private long startNanos;
+            private long endNanos;
             private String name;
 
             private PendingFrame(String name) {
                 this.name = name;
                 start = System.currentTimeMillis();
+                startNanos = System.nanoTime();
             }
 
             public void close() {
                 end = System.currentTimeMillis();
-                if (end - start > 16) {
-                    if (mode == Timeline) {
-                        print();
-                    } else if (mode == Pending) {
-                        pendingFrames.add(this);
-                    }
+                endNanos = System.nanoTime();
+                if (mode == Trace) {
+                    Runtime.AddTraceEvent(name, startNanos, endNanos);
+                } else if (mode == Pending) {
+                    // all of them, the trace keeps the short ones as well
+                    pendingFrames.add(this);
+                } else if (mode == Timeline && end - start > 16) {
+                    print();
                 }
             }
 
@@ -143,7 +226,16 @@ public class ManualInstrumentation {
 
             public static void printPending() {
                 for (PendingFrame f : pendingFrames) {
-                    f.print();
+                    if (f.end - f.start > 16) {
+                        f.print();
+                    }
+                }
+                pendingFrames.clear();
+            }
+
+            public static void tracePending() {
+                for (PendingFrame f : pendingFrames) {
+                    Runtime.AddTraceEvent(f.name, f.startNanos, f.endNanos);
                 }
                 pendingFrames.clear();
             }
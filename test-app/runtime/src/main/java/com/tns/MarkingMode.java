@@ -5,5 +5,6 @@ package com.tns;
  */
 enum MarkingMode {
     full,
-    none
+    none,
+    tracing
 }
@@ -0,0 +1,26 @@
+package com.tns;
+
+import android.content.ComponentCallbacks2;
+
+/**
+ * The memory pressure levels the runtime reacts to. Keep the members in sync with Runtime::MemoryPressureLevel.
+ */
+enum MemoryPressureLevel {
+    none,
+    moderate,
+    critical;
+
+    static MemoryPressureLevel fromTrimLevel(int trimLevel) {
+        if (trimLevel >= ComponentCallbacks2.TRIM_MEMORY_COMPLETE || trimLevel == ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL) {
+            return critical;
+        }
+
+        if (trimLevel >= ComponentCallbacks2.TRIM_MEMORY_BACKGROUND
+                || trimLevel == ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW
+                || trimLevel == ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE) {
+            return moderate;
+        }
+
+        return none;
+    }
+}
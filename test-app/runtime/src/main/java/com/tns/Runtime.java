@@ -4,6 +4,7 @@ import android.os.Handler;
 import android.os.HandlerThread;
 import android.os.Looper;
 import android.os.Message;
+import android.os.MessageQueue;
 import android.os.Process;
 
 import com.tns.bindings.ProxyGenerator;
@@ -21,6 +22,8 @@ import java.lang.reflect.Field;
 import java.lang.reflect.Method;
 import java.lang.reflect.Modifier;
 import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.IntBuffer;
 import java.util.ArrayList;
 import java.util.Arrays;
 import java.util.Comparator;
@@ -46,11 +49,23 @@ public class Runtime {
 
     private native Object runScript(int runtimeId, String filePath) throws NativeScriptException;
 
-    private native Object callJSMethodNative(int runtimeId, int javaObjectID, String methodName, int retType, boolean isConstructor, Object... packagedArgs) throws NativeScriptException;
+    private native Object callJSMethodNative(int runtimeId, int javaObjectID, int methodSlot, int retType, boolean isConstructor, Object... packagedArgs) throws NativeScriptException;
 
-    private native void createJSInstanceNative(int runtimeId, Object javaObject, int javaObjectID, String canonicalName);
+    private native long callJSMethodNativeUnboxed(int runtimeId, int javaObjectID, int methodSlot, int argTypes, char retType, long arg0, long arg1, long arg2, long arg3) throws NativeScriptException;
+
+    private native void runMarkingSlice(int runtimeId);
+
+    private native void startModulePreloading(int runtimeId, String manifestPath);
+
+    private native void finishModulePreloading(int runtimeId);
 
-    private native int generateNewObjectId(int runtimeId);
+    private native void invalidateResolvedModulePathsNative(int runtimeId);
+
+    private native void notifyMemoryPressureNative(int runtimeId, int level);
+
+    private native void notifyInBackgroundNative(int runtimeId, boolean isInBackground);
+
+    private native void createJSInstanceNative(int runtimeId, Object javaObject, int javaObjectID, String canonicalName);
 
     private native boolean notifyGc(int runtimeId);
 
@@ -68,6 +83,10 @@ public class Runtime {
 
     public static native void SetManualInstrumentationMode(String mode);
 
+    static native void AddTraceEvent(String name, long startNanos, long endNanos);
+
+    static native boolean WriteTrace(String path);
+
     private static native void WorkerGlobalOnMessageCallback(int runtimeId, String message);
 
     private static native void WorkerObjectOnMessageCallback(int runtimeId, int workerId, String message);
@@ -105,9 +124,13 @@ public class Runtime {
             "Primitive types need to be manually wrapped in their respective Object wrappers.\n" +
             "If you are creating an instance of an inner class, make sure to always provide reference to the outer `this` as the first argument.";
 
-    private HashMap<Integer, Object> strongInstances = new HashMap<>();
+    // the bitmaps of the GC handshake buffer, keep in sync with GcHandshakeBuffer::Bitmap
+    private final static int GC_HANDSHAKE_MAKE_WEAK = 0;
+    private final static int GC_HANDSHAKE_MAKE_WEAK_KEEP_AS_WEAK = 1;
+    private final static int GC_HANDSHAKE_CHECK_ALIVE = 2;
+    private final static int GC_HANDSHAKE_MAKE_WEAK_AND_CHECK_ALIVE = 3;
 
-    private HashMap<Integer, WeakReference<Object>> weakInstances = new HashMap<>();
+    private InstanceTable instances = new InstanceTable();
 
     private NativeScriptHashMap<Object, Integer> strongJavaObjectToID = new NativeScriptHashMap<Object, Integer>();
 
@@ -163,6 +186,13 @@ public class Runtime {
 
     private boolean isTerminating;
 
+    /*
+        Set on the main thread while the loaded modules are recorded for preloading them on the next launches
+     */
+    private boolean isPreloadingModules;
+
+    private static final String PRELOAD_MANIFEST_FILE_NAME = "require-graph.manifest";
+
     /*
         Used to map to Handler, for messaging between Main and the other Workers
      */
@@ -176,6 +206,15 @@ public class Runtime {
     private static AtomicInteger nextRuntimeId = new AtomicInteger(0);
     private final static ThreadLocal<Runtime> currentRuntime = new ThreadLocal<Runtime>();
     private final static Map<Integer, Runtime> runtimeCache = new ConcurrentHashMap<>();
+    private static volatile boolean isAppInBackground;
+
+    /*
+        The slot handles of the JS method names called from Java, shared by the runtimes.
+        The names are indexed by their slots; the native side interns each name on its first call.
+     */
+    private static final Map<String, Integer> methodSlots = new ConcurrentHashMap<>();
+    private static final ArrayList<String> methodSlotNames = new ArrayList<>();
+    private static final int INIT_METHOD_SLOT = getMethodSlot("init");
     public static Map<Integer, ConcurrentLinkedQueue<Message>> pendingWorkerMessages = new ConcurrentHashMap<>();
     public static boolean nativeLibraryLoaded;
 
@@ -187,15 +226,14 @@ public class Runtime {
 
     private static final ClassStorageService classStorageService = new ClassStorageServiceImpl(ClassCacheImpl.INSTANCE, ClassLoadersCollectionImpl.INSTANCE);
 
-    public Runtime(ClassResolver classResolver, GcListener gcListener, StaticConfiguration config, DynamicConfiguration dynamicConfig, int runtimeId, int workerId, HashMap<Integer, Object> strongInstances, HashMap<Integer, WeakReference<Object>> weakInstances, NativeScriptHashMap<Object, Integer> strongJavaObjectToId, NativeScriptWeakHashMap<Object, Integer> weakJavaObjectToId) {
+    public Runtime(ClassResolver classResolver, GcListener gcListener, StaticConfiguration config, DynamicConfiguration dynamicConfig, int runtimeId, int workerId, InstanceTable instances, NativeScriptHashMap<Object, Integer> strongJavaObjectToId, NativeScriptWeakHashMap<Object, Integer> weakJavaObjectToId) {
         this.classResolver = classResolver;
         this.gcListener = gcListener;
         this.config = config;
         this.dynamicConfig = dynamicConfig;
         this.runtimeId = runtimeId;
         this.workerId = workerId;
-        this.strongInstances = strongInstances;
-        this.weakInstances = weakInstances;
+        this.instances = instances;
         this.strongJavaObjectToID = strongJavaObjectToId;
         this.weakJavaObjectToID = weakJavaObjectToId;
     }
@@ -342,6 +380,34 @@ public class Runtime {
         }
     }
 
+    @RuntimeCallable
+    public int getMarkingTimeSlice() {
+        if (staticConfiguration != null && staticConfiguration.appConfig != null) {
+            return staticConfiguration.appConfig.getMarkingTimeSlice();
+        } else {
+            return (int) AppConfig.KnownKeys.MarkingTimeSlice.getDefaultValue();
+        }
+    }
+
+    @RuntimeCallable
+    private void scheduleMarkingSlice() {
+        threadScheduler.post(new Runnable() {
+            @Override
+            public void run() {
+                runMarkingSlice(getRuntimeId());
+            }
+        });
+    }
+
+    @RuntimeCallable
+    public boolean getHeapSnapshotNearHeapLimit() {
+        if (staticConfiguration != null && staticConfiguration.appConfig != null) {
+            return staticConfiguration.appConfig.getHeapSnapshotNearHeapLimit();
+        } else {
+            return (boolean) AppConfig.KnownKeys.HeapSnapshotNearHeapLimit.getDefaultValue();
+        }
+    }
+
     public static boolean isInitialized() {
         Runtime runtime = Runtime.getCurrentRuntime();
         return (runtime != null) ? runtime.isInitializedImpl() : false;
@@ -362,18 +428,81 @@ public class Runtime {
         }
     }
 
+    /**
+     * Drops the module paths resolved by the runtimes of all threads, e.g. after livesync changed the application files.
+     * The runtimes drop them on their own threads, before resolving the next module.
+     */
+    public static void invalidateResolvedModulePaths() {
+        for (Runtime runtime : runtimeCache.values()) {
+            runtime.invalidateResolvedModulePathsNative(runtime.getRuntimeId());
+        }
+    }
+
+    /**
+     * Forwards a ComponentCallbacks2 trim level to the runtimes of all threads. Each runtime handles it on its own thread.
+     */
+    public static void notifyMemoryPressure(int trimLevel) {
+        MemoryPressureLevel pressureLevel = MemoryPressureLevel.fromTrimLevel(trimLevel);
+        if (pressureLevel == MemoryPressureLevel.none) {
+            return;
+        }
+
+        final int level = pressureLevel.ordinal();
+
+        for (final Runtime runtime : runtimeCache.values()) {
+            runtime.threadScheduler.post(new Runnable() {
+                @Override
+                public void run() {
+                    if (runtime.isInitializedImpl()) {
+                        runtime.notifyMemoryPressureNative(runtime.getRuntimeId(), level);
+                    }
+                }
+            });
+        }
+    }
+
+    /**
+     * Moves the runtimes of all threads to the background when the last activity of the application is stopped
+     * and back to the foreground when one is started. The runtimes created later start in the current state.
+     */
+    public static void notifyInBackground(final boolean isInBackground) {
+        if (isAppInBackground == isInBackground) {
+            return;
+        }
+        isAppInBackground = isInBackground;
+
+        for (final Runtime runtime : runtimeCache.values()) {
+            runtime.threadScheduler.post(new Runnable() {
+                @Override
+                public void run() {
+                    if (runtime.isInitializedImpl()) {
+                        runtime.notifyInBackgroundNative(runtime.getRuntimeId(), isInBackground);
+                    }
+                }
+            });
+        }
+    }
+
     public void releaseNativeCounterpart(int nativeObjectId) {
-        Object strongRef = strongInstances.get(nativeObjectId);
+        Object strongRef = instances.getStrong(nativeObjectId);
         if (strongRef != null) {
-            strongInstances.remove(nativeObjectId);
+            instances.remove(nativeObjectId);
             strongJavaObjectToID.remove(strongRef);
         }
 
-        WeakReference<Object> weakRef = weakInstances.get(nativeObjectId);
+        WeakReference<Object> weakRef = instances.getWeak(nativeObjectId);
         if (weakRef != null) {
-            weakInstances.remove(nativeObjectId);
-            weakJavaObjectToID.remove(weakRef);
+            instances.remove(nativeObjectId);
+            removeWeakJavaObjectID(weakRef);
         }
+
+        // the native side drops the id right after this call
+        instances.freeId(nativeObjectId);
+    }
+
+    @RuntimeCallable
+    private int generateNewObjectId() {
+        return instances.allocateId();
     }
 
     private static class WorkerThreadHandler extends Handler {
@@ -642,6 +771,12 @@ public class Runtime {
             initNativeScript(getRuntimeId(), Module.getApplicationFilesPath(), nativeLibDir, logger.isEnabled(), isDebuggable, appName, appConfig.getAsArray(),
                     callingJsDir, appConfig.getMaxLogcatObjectSize(), forceConsoleLog);
 
+            if (appConfig.getPreloadModules() && !isNotOnMainThread()) {
+                File manifest = new File(Module.getApplicationFilesPath(), PRELOAD_MANIFEST_FILE_NAME);
+                startModulePreloading(getRuntimeId(), manifest.getAbsolutePath());
+                isPreloadingModules = true;
+            }
+
             //clearStartupData(getRuntimeId()); // It's safe to delete the data after the V8 debugger is initialized
 
             if (logger.isEnabled()) {
@@ -654,6 +789,10 @@ public class Runtime {
 
             GcListener.subscribe(this);
 
+            if (isAppInBackground) {
+                notifyInBackgroundNative(getRuntimeId(), true);
+            }
+
             initialized = true;
         } finally {
             frame.close();
@@ -679,6 +818,18 @@ public class Runtime {
         try {
             String mainModule = Module.bootstrapApp();
             runModule(new File(mainModule));
+
+            if (isPreloadingModules) {
+                // the startup is over once the first frames are handled
+                Looper.myQueue().addIdleHandler(new MessageQueue.IdleHandler() {
+                    @Override
+                    public boolean queueIdle() {
+                        isPreloadingModules = false;
+                        finishModulePreloading(getRuntimeId());
+                        return false;
+                    }
+                });
+            }
         } finally {
             frame.close();
         }
@@ -813,7 +964,7 @@ public class Runtime {
     }
 
     private void createJSInstance(Object instance) {
-        int javaObjectID = generateNewObjectId(getRuntimeId());
+        int javaObjectID = generateNewObjectId();
 
         makeInstanceStrong(instance, javaObjectID);
 
@@ -959,7 +1110,7 @@ public class Runtime {
         }
 
         int key = objectId;
-        strongInstances.put(key, instance);
+        instances.putStrong(key, instance);
         strongJavaObjectToID.put(instance, key);
 
         Class<?> clazz = instance.getClass();
@@ -974,84 +1125,145 @@ public class Runtime {
         if (logger.isEnabled()) {
             logger.write("makeInstanceWeak instance " + javaObjectID + " keepAsWeak=" + keepAsWeak);
         }
-        Object instance = strongInstances.get(javaObjectID);
+        Object instance = instances.getStrong(javaObjectID);
+        if (instance == null) {
+            if (!keepAsWeak) {
+                WeakReference<Object> weakRef = instances.getWeak(javaObjectID);
+                if (weakRef != null) {
+                    instances.remove(javaObjectID);
+                    removeWeakJavaObjectID(weakRef);
+                }
+            }
+            return;
+        }
 
         if (keepAsWeak) {
             weakJavaObjectToID.put(instance, Integer.valueOf(javaObjectID));
-            weakInstances.put(javaObjectID, new WeakReference<Object>(instance));
+            instances.makeWeak(javaObjectID);
+        } else {
+            instances.remove(javaObjectID);
         }
 
-        strongInstances.remove(javaObjectID);
         strongJavaObjectToID.remove(instance);
     }
 
+    /**
+     * Applies the changes requested by the native ObjectManager at the end of a GC in a single call.
+     * The buffer holds GC_HANDSHAKE_BITMAP_COUNT bitmaps of "bitmapStride" ints, in native byte order,
+     * and the bit N of a bitmap stands for the object with id N. Only the first "wordCount" ints of each
+     * bitmap are used. Keep in sync with GcHandshakeBuffer.h.
+     *
+     * The bits in the "check alive" and "make weak and check alive" bitmaps are left set only for the
+     * objects that were released.
+     */
     @RuntimeCallable
-    private void makeInstanceWeak(ByteBuffer buff, int length, boolean keepAsWeak) {
-        buff.position(0);
-        for (int i = 0; i < length; i++) {
-            int javaObjectId = buff.getInt();
-            makeInstanceWeak(javaObjectId, keepAsWeak);
+    private void processGcHandshake(ByteBuffer buff, int bitmapStride, int wordCount) {
+        IntBuffer bits = buff.order(ByteOrder.nativeOrder()).asIntBuffer();
+
+        for (int i = 0; i < wordCount; i++) {
+            int makeWeakWord = bits.get(GC_HANDSHAKE_MAKE_WEAK * bitmapStride + i);
+            while (makeWeakWord != 0) {
+                int bit = Integer.numberOfTrailingZeros(makeWeakWord);
+                makeWeakWord &= makeWeakWord - 1;
+                int javaObjectID = (i << 5) | bit;
+                // the native side has already dropped these ids
+                makeInstanceWeak(javaObjectID, false);
+                instances.freeId(javaObjectID);
+            }
+
+            int keepAsWeakWord = bits.get(GC_HANDSHAKE_MAKE_WEAK_KEEP_AS_WEAK * bitmapStride + i);
+            while (keepAsWeakWord != 0) {
+                int bit = Integer.numberOfTrailingZeros(keepAsWeakWord);
+                keepAsWeakWord &= keepAsWeakWord - 1;
+                makeInstanceWeak((i << 5) | bit, true);
+            }
+
+            int checkAliveIndex = GC_HANDSHAKE_CHECK_ALIVE * bitmapStride + i;
+            int checkAliveWord = bits.get(checkAliveIndex);
+            if (checkAliveWord != 0) {
+                int releasedWord = 0;
+                while (checkAliveWord != 0) {
+                    int bit = Integer.numberOfTrailingZeros(checkAliveWord);
+                    checkAliveWord &= checkAliveWord - 1;
+                    if (isInstanceReleased((i << 5) | bit)) {
+                        releasedWord |= 1 << bit;
+                    }
+                }
+                bits.put(checkAliveIndex, releasedWord);
+            }
+
+            int makeWeakAndCheckAliveIndex = GC_HANDSHAKE_MAKE_WEAK_AND_CHECK_ALIVE * bitmapStride + i;
+            int makeWeakAndCheckAliveWord = bits.get(makeWeakAndCheckAliveIndex);
+            if (makeWeakAndCheckAliveWord != 0) {
+                int releasedWord = 0;
+                while (makeWeakAndCheckAliveWord != 0) {
+                    int bit = Integer.numberOfTrailingZeros(makeWeakAndCheckAliveWord);
+                    makeWeakAndCheckAliveWord &= makeWeakAndCheckAliveWord - 1;
+                    int javaObjectID = (i << 5) | bit;
+                    if (!makeInstanceWeakAndCheckIfAlive(javaObjectID)) {
+                        releasedWord |= 1 << bit;
+                        // the native side drops the released ids right after this call
+                        instances.freeId(javaObjectID);
+                    }
+                }
+                bits.put(makeWeakAndCheckAliveIndex, releasedWord);
+            }
         }
     }
 
-    @RuntimeCallable
     private boolean makeInstanceWeakAndCheckIfAlive(int javaObjectID) {
         if (logger.isEnabled()) {
             logger.write("makeInstanceWeakAndCheckIfAlive instance " + javaObjectID);
         }
-        Object instance = strongInstances.get(javaObjectID);
+        Object instance = instances.getStrong(javaObjectID);
         if (instance == null) {
-            WeakReference<Object> ref = weakInstances.get(javaObjectID);
+            WeakReference<Object> ref = instances.getWeak(javaObjectID);
             if (ref == null) {
                 return false;
             } else {
                 instance = ref.get();
                 if (instance == null) {
                     // The Java was moved from strong to weak, and then the Java instance was collected.
-                    weakInstances.remove(javaObjectID);
-                    weakJavaObjectToID.remove(ref);
+                    // The weak map drops the entry of the collected instance by itself.
+                    instances.remove(javaObjectID);
                     return false;
                 } else {
                     return true;
                 }
             }
         } else {
-            strongInstances.remove(javaObjectID);
             strongJavaObjectToID.remove(instance);
 
             weakJavaObjectToID.put(instance, javaObjectID);
-            weakInstances.put(javaObjectID, new WeakReference<Object>(instance));
+            instances.makeWeak(javaObjectID);
 
             return true;
         }
     }
 
-    @RuntimeCallable
-    private void checkWeakObjectAreAlive(ByteBuffer input, ByteBuffer output, int length) {
-        input.position(0);
-        output.position(0);
-        for (int i = 0; i < length; i++) {
-            int javaObjectId = input.getInt();
-
-            WeakReference<Object> weakRef = weakInstances.get(javaObjectId);
-
-            int isReleased;
+    /**
+     * The weak map is keyed by the instances, so the entry is removed by the referent of the reference.
+     * Once the referent is collected, the map drops the entry by itself.
+     */
+    private void removeWeakJavaObjectID(WeakReference<Object> weakRef) {
+        Object instance = weakRef.get();
+        if (instance != null) {
+            weakJavaObjectToID.remove(instance);
+        }
+    }
 
-            if (weakRef != null) {
-                Object instance = weakRef.get();
+    private boolean isInstanceReleased(int javaObjectId) {
+        WeakReference<Object> weakRef = instances.getWeak(javaObjectId);
 
-                if (instance == null) {
-                    isReleased = 1;
-                    weakInstances.remove(javaObjectId);
-                } else {
-                    isReleased = 0;
-                }
-            } else {
-                isReleased = (strongInstances.get(javaObjectId) == null) ? 1 : 0;
+        if (weakRef != null) {
+            if (weakRef.get() == null) {
+                instances.remove(javaObjectId);
+                return true;
             }
-
-            output.putInt(isReleased);
+            return false;
         }
+
+        return instances.getStrong(javaObjectId) == null;
     }
 
     @RuntimeCallable
@@ -1060,14 +1272,14 @@ public class Runtime {
             logger.write("Platform.getJavaObjectByID:" + javaObjectID);
         }
 
-        Object instance = strongInstances.get(javaObjectID);
+        Object instance = instances.getStrong(javaObjectID);
 
         if (instance == null) {
             instance = keyNotFoundObject;
         }
 
         if (instance == keyNotFoundObject) {
-            WeakReference<Object> wr = weakInstances.get(javaObjectID);
+            WeakReference<Object> wr = instances.getWeak(javaObjectID);
             if (wr == null) {
                 throw new NativeScriptException("No weak reference found. Attempt to use cleared object reference id=" + javaObjectID);
             }
@@ -1098,7 +1310,7 @@ public class Runtime {
         Integer result = getJavaObjectID(obj);
 
         if (result == null) {
-            int objectId = generateNewObjectId(getRuntimeId());
+            int objectId = generateNewObjectId();
             makeInstanceStrong(obj, objectId);
 
             result = objectId;
@@ -1119,12 +1331,14 @@ public class Runtime {
         return callJSMethodFromPossibleNonMainThread(javaObject, methodName, void.class, isConstructor, 0, args);
     }
 
-    public static Object callJSMethodFromPossibleNonMainThread(final Object javaObject, final String methodName, final Class<?> retType, final boolean isConstructor, final long delay, final Object... args) throws NativeScriptException {
+    public static Object callJSMethodFromPossibleNonMainThread(final Object javaObject, String methodName, final Class<?> retType, final boolean isConstructor, final long delay, final Object... args) throws NativeScriptException {
+        final int methodSlot = getMethodSlot(methodName);
+
         if (isNotOnMainThread()) {
             Callable<Object> callable = new Callable<Object>() {
                 @Override
                 public Object call() {
-                    return callJSMethod(javaObject, methodName, retType, isConstructor, delay, args);
+                    return callJSMethod(javaObject, methodSlot, retType, isConstructor, delay, args);
                 }
             };
 
@@ -1138,7 +1352,7 @@ public class Runtime {
             }
 
         } else {
-            return callJSMethod(javaObject, methodName, retType, isConstructor, delay, args);
+            return callJSMethod(javaObject, methodSlot, retType, isConstructor, delay, args);
         }
     }
 
@@ -1162,6 +1376,15 @@ public class Runtime {
     }
 
     public static Object callJSMethod(Object javaObject, String methodName, Class<?> retType, boolean isConstructor, long delay, Object... args) throws NativeScriptException {
+        return callJSMethod(javaObject, getMethodSlot(methodName), retType, isConstructor, delay, args);
+    }
+
+    // The generated bindings resolve the slots of their methods once, with getMethodSlot, and pass only the slots.
+    public static Object callJSMethod(Object javaObject, int methodSlot, Class<?> retType, Object... args) throws NativeScriptException {
+        return callJSMethod(javaObject, methodSlot, retType, false /* isConstructor */, 0, args);
+    }
+
+    public static Object callJSMethod(Object javaObject, int methodSlot, Class<?> retType, boolean isConstructor, long delay, Object... args) throws NativeScriptException {
         Runtime runtime = Runtime.getCurrentRuntime();
 
         if (runtime == null) {
@@ -1172,20 +1395,216 @@ public class Runtime {
             throw new NativeScriptException("Cannot find runtime for instance=" + ((javaObject == null) ? "null" : javaObject));
         }
 
-        return runtime.callJSMethodImpl(javaObject, methodName, retType, isConstructor, delay, args);
+        return runtime.callJSMethodImpl(javaObject, methodSlot, retType, isConstructor, delay, args);
+    }
+
+    // Typed entry points for the most common primitive callback signatures. The arguments are passed
+    // to the native side as JNI primitives instead of being boxed and packaged into an Object[].
+    // When the call cannot be dispatched synchronously on the current thread, they fall back to callJSMethod.
+    // Keep the set of shapes in sync with the static binding generator (MethodsWriterImpl).
+    public static void callJSMethod_V(Object javaObject, String methodName) throws NativeScriptException {
+        callJSMethod_V(javaObject, getMethodSlot(methodName));
+    }
+
+    public static void callJSMethod_V(Object javaObject, int methodSlot) throws NativeScriptException {
+        callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_NONE, 'V', 0, 0, 0, 0);
+    }
+
+    public static void callJSMethodI_V(Object javaObject, String methodName, int arg0) throws NativeScriptException {
+        callJSMethodI_V(javaObject, getMethodSlot(methodName), arg0);
+    }
+
+    public static void callJSMethodI_V(Object javaObject, int methodSlot, int arg0) throws NativeScriptException {
+        callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_I, 'V', arg0, 0, 0, 0);
+    }
+
+    public static void callJSMethodII_V(Object javaObject, String methodName, int arg0, int arg1) throws NativeScriptException {
+        callJSMethodII_V(javaObject, getMethodSlot(methodName), arg0, arg1);
+    }
+
+    public static void callJSMethodII_V(Object javaObject, int methodSlot, int arg0, int arg1) throws NativeScriptException {
+        callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_II, 'V', arg0, arg1, 0, 0);
+    }
+
+    public static void callJSMethodIIII_V(Object javaObject, String methodName, int arg0, int arg1, int arg2, int arg3) throws NativeScriptException {
+        callJSMethodIIII_V(javaObject, getMethodSlot(methodName), arg0, arg1, arg2, arg3);
+    }
+
+    public static void callJSMethodIIII_V(Object javaObject, int methodSlot, int arg0, int arg1, int arg2, int arg3) throws NativeScriptException {
+        callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_IIII, 'V', arg0, arg1, arg2, arg3);
+    }
+
+    public static void callJSMethodJ_V(Object javaObject, String methodName, long arg0) throws NativeScriptException {
+        callJSMethodJ_V(javaObject, getMethodSlot(methodName), arg0);
+    }
+
+    public static void callJSMethodJ_V(Object javaObject, int methodSlot, long arg0) throws NativeScriptException {
+        callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_J, 'V', arg0, 0, 0, 0);
+    }
+
+    public static void callJSMethodF_V(Object javaObject, String methodName, float arg0) throws NativeScriptException {
+        callJSMethodF_V(javaObject, getMethodSlot(methodName), arg0);
+    }
+
+    public static void callJSMethodF_V(Object javaObject, int methodSlot, float arg0) throws NativeScriptException {
+        callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_F, 'V', Float.floatToRawIntBits(arg0), 0, 0, 0);
+    }
+
+    public static void callJSMethodZ_V(Object javaObject, String methodName, boolean arg0) throws NativeScriptException {
+        callJSMethodZ_V(javaObject, getMethodSlot(methodName), arg0);
+    }
+
+    public static void callJSMethodZ_V(Object javaObject, int methodSlot, boolean arg0) throws NativeScriptException {
+        callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_Z, 'V', arg0 ? 1 : 0, 0, 0, 0);
+    }
+
+    public static float callJSMethodF_F(Object javaObject, String methodName, float arg0) throws NativeScriptException {
+        return callJSMethodF_F(javaObject, getMethodSlot(methodName), arg0);
+    }
+
+    public static float callJSMethodF_F(Object javaObject, int methodSlot, float arg0) throws NativeScriptException {
+        return Float.intBitsToFloat((int) callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_F, 'F', Float.floatToRawIntBits(arg0), 0, 0, 0));
+    }
+
+    public static boolean callJSMethod_Z(Object javaObject, String methodName) throws NativeScriptException {
+        return callJSMethod_Z(javaObject, getMethodSlot(methodName));
+    }
+
+    public static boolean callJSMethod_Z(Object javaObject, int methodSlot) throws NativeScriptException {
+        return callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_NONE, 'Z', 0, 0, 0, 0) != 0;
+    }
+
+    public static int callJSMethod_I(Object javaObject, String methodName) throws NativeScriptException {
+        return callJSMethod_I(javaObject, getMethodSlot(methodName));
+    }
+
+    public static int callJSMethod_I(Object javaObject, int methodSlot) throws NativeScriptException {
+        return (int) callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_NONE, 'I', 0, 0, 0, 0);
+    }
+
+    public static int callJSMethodI_I(Object javaObject, String methodName, int arg0) throws NativeScriptException {
+        return callJSMethodI_I(javaObject, getMethodSlot(methodName), arg0);
+    }
+
+    public static int callJSMethodI_I(Object javaObject, int methodSlot, int arg0) throws NativeScriptException {
+        return (int) callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_I, 'I', arg0, 0, 0, 0);
+    }
+
+    public static long callJSMethodI_J(Object javaObject, String methodName, int arg0) throws NativeScriptException {
+        return callJSMethodI_J(javaObject, getMethodSlot(methodName), arg0);
+    }
+
+    public static long callJSMethodI_J(Object javaObject, int methodSlot, int arg0) throws NativeScriptException {
+        return callJSMethodUnboxed(javaObject, methodSlot, UNBOXED_ARGS_I, 'J', arg0, 0, 0, 0);
+    }
+
+    // The JNI types of the arguments of an unboxed call, one per byte from the lowest.
+    private static final int UNBOXED_ARGS_NONE = 0;
+    private static final int UNBOXED_ARGS_I = 'I';
+    private static final int UNBOXED_ARGS_II = 'I' | ('I' << 8);
+    private static final int UNBOXED_ARGS_IIII = 'I' | ('I' << 8) | ('I' << 16) | ('I' << 24);
+    private static final int UNBOXED_ARGS_J = 'J';
+    private static final int UNBOXED_ARGS_F = 'F';
+    private static final int UNBOXED_ARGS_Z = 'Z';
+
+    // Dispatches an unboxed call. The arguments and the result are passed as longs: the floats by
+    // their bits (Float.floatToRawIntBits) and the booleans as 0 or 1.
+    private static long callJSMethodUnboxed(Object javaObject, int methodSlot, int argTypes, char retType, long arg0, long arg1, long arg2, long arg3) throws NativeScriptException {
+        Runtime runtime = getRuntimeForUnboxedCall(javaObject);
+        Integer javaObjectID = (runtime != null) ? runtime.getJavaObjectID(javaObject) : null;
+        if (javaObjectID == null) {
+            return callJSMethodBoxed(javaObject, methodSlot, argTypes, retType, arg0, arg1, arg2, arg3);
+        }
+
+        if (runtime.logger.isEnabled()) {
+            runtime.logger.write("Platform.CallJSMethod: calling js method " + getMethodSlotName(methodSlot) + " with javaObjectID " + javaObjectID + " type=" + javaObject.getClass().getName());
+        }
+
+        try {
+            return runtime.callJSMethodNativeUnboxed(runtime.getRuntimeId(), javaObjectID, methodSlot, argTypes, retType, arg0, arg1, arg2, arg3);
+        } catch (NativeScriptException e) {
+            runtime.handleUnboxedCallException(e);
+            return 0;
+        }
+    }
+
+    // The fallback of an unboxed call, through the generic callJSMethod.
+    private static long callJSMethodBoxed(Object javaObject, int methodSlot, int argTypes, char retType, long arg0, long arg1, long arg2, long arg3) throws NativeScriptException {
+        long[] encodedArgs = {arg0, arg1, arg2, arg3};
+        ArrayList<Object> args = new ArrayList<>(encodedArgs.length);
+        for (int i = 0; i < encodedArgs.length && ((argTypes >> (8 * i)) & 0xFF) != 0; i++) {
+            char argType = (char) ((argTypes >> (8 * i)) & 0xFF);
+            if (argType == 'Z') {
+                args.add(encodedArgs[i] != 0);
+            } else if (argType == 'I') {
+                args.add((int) encodedArgs[i]);
+            } else if (argType == 'F') {
+                args.add(Float.intBitsToFloat((int) encodedArgs[i]));
+            } else {
+                args.add(encodedArgs[i]);
+            }
+        }
+
+        if (retType == 'Z') {
+            Object ret = callJSMethod(javaObject, methodSlot, boolean.class, false, 0, args.toArray());
+            return (ret != null) && (Boolean) ret ? 1 : 0;
+        } else if (retType == 'I') {
+            Object ret = callJSMethod(javaObject, methodSlot, int.class, false, 0, args.toArray());
+            return (ret != null) ? (Integer) ret : 0;
+        } else if (retType == 'J') {
+            Object ret = callJSMethod(javaObject, methodSlot, long.class, false, 0, args.toArray());
+            return (ret != null) ? (Long) ret : 0L;
+        } else if (retType == 'F') {
+            Object ret = callJSMethod(javaObject, methodSlot, float.class, false, 0, args.toArray());
+            return Float.floatToRawIntBits((ret != null) ? (Float) ret : 0f);
+        }
+
+        callJSMethod(javaObject, methodSlot, void.class, false, 0, args.toArray());
+        return 0;
     }
 
-    private Object callJSMethodImpl(Object javaObject, String methodName, Class<?> retType, boolean isConstructor, long delay, Object... args) throws NativeScriptException {
+    // Returns the runtime that can dispatch an unboxed call synchronously on the current thread,
+    // or null when the call has to go through the generic (possibly posted) callJSMethod path.
+    private static Runtime getRuntimeForUnboxedCall(Object javaObject) {
+        Runtime runtime = Runtime.getCurrentRuntime();
+
+        if (runtime == null) {
+            runtime = getObjectRuntime(javaObject);
+        }
+
+        if (runtime == null) {
+            return null;
+        }
+
+        boolean isWorkThread = runtime.threadScheduler.getThread().equals(Thread.currentThread());
+        if (!isWorkThread && !runtime.config.appConfig.getEnableMultithreadedJavascript()) {
+            return null;
+        }
+
+        return runtime;
+    }
+
+    private void handleUnboxedCallException(NativeScriptException e) throws NativeScriptException {
+        if (this.config.appConfig.getDiscardUncaughtJsExceptions()) {
+            String errorMessage = "Error on \"" + Thread.currentThread().getName() + "\" thread for callJSMethodNative\n";
+            android.util.Log.w("Warning", "NativeScript discarding uncaught JS exception!");
+            passDiscardedExceptionToJs(e, errorMessage);
+        } else {
+            throw e;
+        }
+    }
+
+    private Object callJSMethodImpl(Object javaObject, int methodSlot, Class<?> retType, boolean isConstructor, long delay, Object... args) throws NativeScriptException {
         Integer javaObjectID = getJavaObjectID(javaObject);
         if (javaObjectID == null) {
             throw new NativeScriptException("Cannot find object id for instance=" + ((javaObject == null) ? "null" : javaObject));
         }
 
         if (logger.isEnabled()) {
-            logger.write("Platform.CallJSMethod: calling js method " + methodName + " with javaObjectID " + javaObjectID + " type=" + ((javaObject != null) ? javaObject.getClass().getName() : "null"));
+            logger.write("Platform.CallJSMethod: calling js method " + getMethodSlotName(methodSlot) + " with javaObjectID " + javaObjectID + " type=" + ((javaObject != null) ? javaObject.getClass().getName() : "null"));
         }
 
-        Object result = dispatchCallJSMethodNative(javaObjectID, methodName, isConstructor, delay, retType, args);
+        Object result = dispatchCallJSMethodNative(javaObjectID, methodSlot, isConstructor, delay, retType, args);
 
         return result;
     }
@@ -1263,10 +1682,10 @@ public class Runtime {
         return res;
     }
 
-    private Object[] extendConstructorArgs(String methodName, boolean isConstructor, Object[] args) {
+    private Object[] extendConstructorArgs(int methodSlot, boolean isConstructor, Object[] args) {
         Object[] arr = null;
 
-        if (methodName.equals("init")) {
+        if (methodSlot == INIT_METHOD_SLOT) {
             if (args == null) {
                 arr = new Object[]
                         {isConstructor};
@@ -1282,24 +1701,24 @@ public class Runtime {
         return arr;
     }
 
-    private Object dispatchCallJSMethodNative(final int javaObjectID, final String methodName, boolean isConstructor, Class<?> retType, final Object[] args) throws NativeScriptException {
-        return dispatchCallJSMethodNative(javaObjectID, methodName, isConstructor, 0, retType, args);
+    private Object dispatchCallJSMethodNative(final int javaObjectID, final int methodSlot, boolean isConstructor, Class<?> retType, final Object[] args) throws NativeScriptException {
+        return dispatchCallJSMethodNative(javaObjectID, methodSlot, isConstructor, 0, retType, args);
     }
 
-    private Object dispatchCallJSMethodNative(final int javaObjectID, final String methodName, boolean isConstructor, long delay, Class<?> retType, final Object[] args) throws NativeScriptException {
+    private Object dispatchCallJSMethodNative(final int javaObjectID, final int methodSlot, boolean isConstructor, long delay, Class<?> retType, final Object[] args) throws NativeScriptException {
         final int returnType = TypeIDs.GetObjectTypeId(retType);
         Object ret = null;
 
         boolean isWorkThread = threadScheduler.getThread().equals(Thread.currentThread());
 
-        final Object[] tmpArgs = extendConstructorArgs(methodName, isConstructor, args);
+        final Object[] tmpArgs = extendConstructorArgs(methodSlot, isConstructor, args);
         final boolean discardUncaughtJsExceptions = this.config.appConfig.getDiscardUncaughtJsExceptions();
         boolean enableMultithreadedJavascript = this.config.appConfig.getEnableMultithreadedJavascript();
 
         if (enableMultithreadedJavascript || isWorkThread) {
             Object[] packagedArgs = packageArgs(tmpArgs);
             try {
-                ret = callJSMethodNative(getRuntimeId(), javaObjectID, methodName, returnType, isConstructor, packagedArgs);
+                ret = callJSMethodNative(getRuntimeId(), javaObjectID, methodSlot, returnType, isConstructor, packagedArgs);
             } catch (NativeScriptException e) {
                 if (discardUncaughtJsExceptions) {
                     String errorMessage = "Error on \"" + Thread.currentThread().getName() + "\" thread for callJSMethodNative\n";
@@ -1320,7 +1739,7 @@ public class Runtime {
                     synchronized (this) {
                         try {
                             final Object[] packagedArgs = packageArgs(tmpArgs);
-                            arr[0] = callJSMethodNative(getRuntimeId(), javaObjectID, methodName, returnType, isCtor, packagedArgs);
+                            arr[0] = callJSMethodNative(getRuntimeId(), javaObjectID, methodSlot, returnType, isCtor, packagedArgs);
                         } catch (NativeScriptException e) {
                             if (discardUncaughtJsExceptions) {
                                 String errorMessage = "Error on \"" + Thread.currentThread().getName() + "\" thread for callJSMethodNative\n";
@@ -1364,6 +1783,33 @@ public class Runtime {
         return ret;
     }
 
+    // Returns the slot handle of the JS method name, the same for all the runtimes. It does not call
+    // into the native side, so the generated bindings resolve their slots in their static initializers.
+    public static int getMethodSlot(String methodName) {
+        Integer methodSlot = methodSlots.get(methodName);
+        if (methodSlot != null) {
+            return methodSlot;
+        }
+
+        synchronized (methodSlotNames) {
+            methodSlot = methodSlots.get(methodName);
+            if (methodSlot == null) {
+                methodSlot = methodSlotNames.size();
+                methodSlotNames.add(methodName);
+                methodSlots.put(methodName, methodSlot);
+            }
+        }
+
+        return methodSlot;
+    }
+
+    @RuntimeCallable
+    private static String getMethodSlotName(int methodSlot) {
+        synchronized (methodSlotNames) {
+            return (methodSlot >= 0 && methodSlot < methodSlotNames.size()) ? methodSlotNames.get(methodSlot) : null;
+        }
+    }
+
     @RuntimeCallable
     private static Class<?> getCachedClass(String className) {
         Class<?> clazz;
@@ -0,0 +1,299 @@
+/*
+ * Reads the assets of zip fixtures written by the test: the stored and the deflated entries, the
+ * folders of a mounted assets folder and the files read through MappedFile. The packages with a
+ * broken central directory have to be rejected, and an entry whose CRC does not match its content
+ * must not be copied.
+ *
+ *   apk-file-system-test
+ */
+
+#include "ApkFileSystem.h"
+#include "File.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+using namespace std;
+using namespace tns;
+
+namespace {
+int failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+/*
+ * Writes a zip file the way the packaging tools do, with the local headers followed by the
+ * central directory and the end of central directory record.
+ */
+class ZipWriter {
+    public:
+        void Add(const string& name, const string& content, uint16_t method, bool isCrcCorrupted = false) {
+            string data = (method == ApkFileSystem::METHOD_DEFLATED) ? Deflate(content) : content;
+            auto crc = static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef*>(content.data()), static_cast<uInt>(content.size())));
+            if (isCrcCorrupted) {
+                crc ^= 1;
+            }
+
+            auto offset = static_cast<uint32_t>(m_data.size());
+
+            AppendUInt32(m_data, 0x04034b50);
+            AppendHeaderFields(m_data, method, crc, data.size(), content.size(), name.size());
+            m_data += name;
+            m_data += data;
+
+            AppendUInt32(m_directory, 0x02014b50);
+            AppendUInt16(m_directory, 20);
+            AppendHeaderFields(m_directory, method, crc, data.size(), content.size(), name.size());
+            // comment length, disk number, internal and external attributes
+            AppendUInt16(m_directory, 0);
+            AppendUInt16(m_directory, 0);
+            AppendUInt16(m_directory, 0);
+            AppendUInt32(m_directory, 0);
+            AppendUInt32(m_directory, offset);
+            m_directory += name;
+
+            m_count++;
+        }
+
+        string Build() const {
+            string zip = m_data + m_directory;
+
+            AppendUInt32(zip, 0x06054b50);
+            AppendUInt16(zip, 0);
+            AppendUInt16(zip, 0);
+            AppendUInt16(zip, m_count);
+            AppendUInt16(zip, m_count);
+            AppendUInt32(zip, static_cast<uint32_t>(m_directory.size()));
+            AppendUInt32(zip, static_cast<uint32_t>(m_data.size()));
+            AppendUInt16(zip, 0);
+
+            return zip;
+        }
+
+        size_t DirectoryOffset() const {
+            return m_data.size();
+        }
+
+    private:
+        static void AppendUInt16(string& out, uint16_t value) {
+            out += static_cast<char>(value & 0xFF);
+            out += static_cast<char>(value >> 8);
+        }
+
+        static void AppendUInt32(string& out, uint32_t value) {
+            AppendUInt16(out, static_cast<uint16_t>(value & 0xFFFF));
+            AppendUInt16(out, static_cast<uint16_t>(value >> 16));
+        }
+
+        static void AppendHeaderFields(string& out, uint16_t method, uint32_t crc, size_t compressedSize, size_t size, size_t nameLength) {
+            // version needed, flags, method, time, date
+            AppendUInt16(out, 20);
+            AppendUInt16(out, 0);
+            AppendUInt16(out, method);
+            AppendUInt16(out, 0);
+            AppendUInt16(out, 0x5021);
+            AppendUInt32(out, crc);
+            AppendUInt32(out, static_cast<uint32_t>(compressedSize));
+            AppendUInt32(out, static_cast<uint32_t>(size));
+            AppendUInt16(out, static_cast<uint16_t>(nameLength));
+            AppendUInt16(out, 0);
+        }
+
+        static string Deflate(const string& content) {
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+
+            string deflated(deflateBound(&stream, content.size()), '\0');
+            stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data()));
+            stream.avail_in = static_cast<uInt>(content.size());
+            stream.next_out = reinterpret_cast<Bytef*>(&deflated[0]);
+            stream.avail_out = static_cast<uInt>(deflated.size());
+            deflate(&stream, Z_FINISH);
+            deflated.resize(stream.total_out);
+            deflateEnd(&stream);
+
+            return deflated;
+        }
+
+        string m_data;
+        string m_directory;
+        uint16_t m_count = 0;
+};
+
+string root;
+
+string WriteZip(const string& name, const string& zip) {
+    auto path = root + "/" + name;
+    auto file = fopen(path.c_str(), "wb");
+    fwrite(zip.data(), 1, zip.size(), file);
+    fclose(file);
+    return path;
+}
+
+string MakeContent(size_t size) {
+    string content;
+    content.reserve(size);
+    for (size_t i = 0; content.size() < size; i++) {
+        content += "line " + to_string(i) + "\n";
+    }
+    content.resize(size);
+    return content;
+}
+
+void TestBrokenCentralDirectory() {
+    ZipWriter writer;
+    writer.Add("assets/metadata/treeNodeStream.dat", "nodes", ApkFileSystem::METHOD_STORED);
+    auto zip = writer.Build();
+    auto directoryOffset = writer.DirectoryOffset();
+    auto endOffset = zip.size() - 22;
+
+    // no end of central directory record
+    EXPECT(!ApkFileSystem::Open(WriteZip("no-end.zip", zip.substr(0, endOffset))));
+
+    // the central directory lies past the end of the file
+    auto pastEnd = zip;
+    pastEnd[endOffset + 19] = '\x7F';
+    EXPECT(!ApkFileSystem::Open(WriteZip("past-end.zip", pastEnd)));
+
+    // the central header signature is wrong
+    auto badSignature = zip;
+    badSignature[directoryOffset] = 'X';
+    EXPECT(!ApkFileSystem::Open(WriteZip("bad-signature.zip", badSignature)));
+
+    // more entries than the central directory holds
+    auto truncated = zip;
+    truncated[endOffset + 10] = 2;
+    EXPECT(!ApkFileSystem::Open(WriteZip("truncated.zip", truncated)));
+
+    // the name runs past the central directory
+    auto longName = zip;
+    longName[directoryOffset + 28] = '\x7F';
+    EXPECT(!ApkFileSystem::Open(WriteZip("long-name.zip", longName)));
+
+    EXPECT(!ApkFileSystem::Open(root + "/missing.zip"));
+}
+
+void TestEntries() {
+    auto stored = MakeContent(100 * 1024);
+    auto deflated = MakeContent(10 * 1024);
+
+    ZipWriter writer;
+    writer.Add("classes.dex", "dex", ApkFileSystem::METHOD_STORED);
+    writer.Add("assets/metadata/stored.dat", stored, ApkFileSystem::METHOD_STORED);
+    writer.Add("assets/metadata/deflated.dat", deflated, ApkFileSystem::METHOD_DEFLATED);
+    writer.Add("assets/metadata/nested/small.dat", "small", ApkFileSystem::METHOD_DEFLATED);
+    writer.Add("assets/metadata/bad-crc.dat", "corrupted", ApkFileSystem::METHOD_STORED, true);
+    writer.Add("assets/app/index.js", "", ApkFileSystem::METHOD_STORED);
+
+    EXPECT(ApkFileSystem::Open(WriteZip("app.apk", writer.Build())));
+
+    auto filesDir = root + "/files";
+    mkdir(filesDir.c_str(), 0700);
+    auto mountPath = filesDir + "/metadata";
+    EXPECT(ApkFileSystem::Mount("metadata", mountPath));
+    EXPECT(!ApkFileSystem::Mount("missing", filesDir + "/missing"));
+
+    EXPECT(ApkFileSystem::IsMounted(mountPath + "/stored.dat"));
+    EXPECT(ApkFileSystem::IsMounted(mountPath + "/nested/../missing.dat"));
+    EXPECT(!ApkFileSystem::IsMounted(filesDir + "/metadata-other/stored.dat"));
+    EXPECT(!ApkFileSystem::IsMounted(filesDir + "/app/index.js"));
+
+    bool isDirectory = true;
+    EXPECT(ApkFileSystem::GetEntryKind(mountPath + "/stored.dat", isDirectory) && !isDirectory);
+    EXPECT(ApkFileSystem::GetEntryKind(mountPath + "/nested", isDirectory) && isDirectory);
+    EXPECT(ApkFileSystem::GetEntryKind(mountPath, isDirectory) && isDirectory);
+    EXPECT(!ApkFileSystem::GetEntryKind(mountPath + "/missing.dat", isDirectory));
+
+    vector<pair<string, bool>> entries;
+    EXPECT(ApkFileSystem::ListDirectory(mountPath, entries));
+    EXPECT(entries.size() == 4);
+    for (const auto& entry : entries) {
+        EXPECT(entry.second == (entry.first == "nested"));
+    }
+
+    // a stored entry is mapped in place and read with pread
+    ApkFileSystem::Entry entry;
+    EXPECT(ApkFileSystem::FindFile(mountPath + "/stored.dat", entry));
+    EXPECT(entry.method == ApkFileSystem::METHOD_STORED && entry.size == stored.size());
+
+    vector<char> data(entry.size);
+    EXPECT(ApkFileSystem::ReadEntry(entry, data.data()) && string(data.data(), data.size()) == stored);
+
+    MemoryMappedFile mapping;
+    const char* mapped = nullptr;
+    EXPECT(ApkFileSystem::MapEntry(entry, mapping, mapped, FileAccess::Sequential) && string(mapped, entry.size) == stored);
+
+    MappedFile storedFile(mountPath + "/stored.dat");
+    EXPECT(storedFile.IsOpen() && storedFile.IsMapped());
+    EXPECT(string(storedFile.Data(), storedFile.Size()) == stored);
+
+    // a deflated entry is inflated, it cannot be mapped
+    EXPECT(ApkFileSystem::FindFile(mountPath + "/deflated.dat", entry));
+    EXPECT(entry.method == ApkFileSystem::METHOD_DEFLATED && entry.size == deflated.size() && entry.compressedSize < entry.size);
+    EXPECT(!ApkFileSystem::MapEntry(entry, mapping, mapped, FileAccess::Normal));
+
+    data.assign(entry.size, 0);
+    EXPECT(ApkFileSystem::ReadEntry(entry, data.data()) && string(data.data(), data.size()) == deflated);
+
+    MappedFile deflatedFile(mountPath + "/nested/small.dat");
+    EXPECT(deflatedFile.IsOpen() && !deflatedFile.IsMapped());
+    EXPECT(string(deflatedFile.Data(), deflatedFile.Size()) == "small");
+
+    // the copies are checked against the CRC of the central directory
+    auto copyPath = root + "/copy.dat";
+    int fd = open(copyPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    EXPECT(ApkFileSystem::CopyEntry(entry, fd));
+    close(fd);
+    EXPECT(File::ReadText(copyPath) == deflated);
+
+    EXPECT(ApkFileSystem::FindFile(mountPath + "/bad-crc.dat", entry));
+    fd = open(copyPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    EXPECT(!ApkFileSystem::CopyEntry(entry, fd));
+    close(fd);
+
+    // the entries out of the assets are not indexed
+    vector<pair<string, ApkFileSystem::Entry>> files;
+    EXPECT(ApkFileSystem::ListFiles("app", files) && files.size() == 1 && files[0].first == "app/index.js");
+}
+
+void TestNormalizePath() {
+    EXPECT(ApkFileSystem::NormalizePath("/a//b/./c/") == "/a/b/c");
+    EXPECT(ApkFileSystem::NormalizePath("/a/b/../../..") == "/");
+    EXPECT(ApkFileSystem::NormalizePath("/a/../b") == "/b");
+}
+}
+
+int main() {
+    char tempPath[] = "/tmp/apk-file-system-XXXXXX";
+    char canonicalPath[PATH_MAX];
+    root = realpath(mkdtemp(tempPath), canonicalPath);
+
+    // the package is opened once per process, so the broken ones go first
+    TestBrokenCentralDirectory();
+    TestEntries();
+    TestNormalizePath();
+
+    system(("rm -rf " + root).c_str());
+
+    if (failures > 0) {
+        fprintf(stderr, "%d expectation(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("All the packages were read\n");
+    return 0;
+}
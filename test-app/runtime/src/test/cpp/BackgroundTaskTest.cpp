@@ -0,0 +1,205 @@
+/*
+ * Runs background tasks under the orderings the startup can hit: the task finishing before the
+ * wait, the wait starting before the task runs, several threads waiting at once, a failing task
+ * and a task which is never waited for. The stress test interleaves them at random.
+ *
+ *   background-task-test
+ */
+
+#include "BackgroundTask.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace tns;
+
+namespace {
+int failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+/*
+ * Holds a task until the test opens it, so that the test decides which side goes first.
+ */
+class Gate {
+    public:
+        Gate() : m_isOpen(false) {
+        }
+
+        void Open() {
+            lock_guard<mutex> lock(m_mutex);
+            m_isOpen = true;
+            m_condition.notify_all();
+        }
+
+        void Pass() {
+            unique_lock<mutex> lock(m_mutex);
+            m_condition.wait(lock, [this] {
+                return m_isOpen;
+            });
+        }
+
+    private:
+        mutex m_mutex;
+        condition_variable m_condition;
+        bool m_isOpen;
+};
+
+void TestNotStarted() {
+    BackgroundTask task;
+    task.Wait();
+    EXPECT(!task.IsDone());
+}
+
+void TestDoneBeforeWait() {
+    BackgroundTask task;
+    // written by the task and read after the wait without a lock, as the metadata is
+    int result = 0;
+
+    task.Start("test-early", [&result] {
+        result = 42;
+    });
+    while (!task.IsDone()) {
+        this_thread::yield();
+    }
+
+    task.Wait();
+    EXPECT(result == 42);
+}
+
+void TestWaitBeforeRun() {
+    static const int waitersCount = 4;
+
+    Gate gate;
+    BackgroundTask task;
+    int result = 0;
+    atomic<int> returnedCount(0);
+
+    task.Start("test-late", [&gate, &result] {
+        gate.Pass();
+        result = 42;
+    });
+
+    vector<thread> waiters;
+    for (int i = 0; i < waitersCount; i++) {
+        waiters.emplace_back([&] {
+            task.Wait();
+            EXPECT(result == 42);
+            returnedCount++;
+        });
+    }
+
+    // the task cannot finish before the gate is open, whenever the waiters got to wait
+    this_thread::sleep_for(chrono::milliseconds(20));
+    EXPECT(returnedCount == 0);
+    EXPECT(!task.IsDone());
+
+    gate.Open();
+    for (auto& waiter : waiters) {
+        waiter.join();
+    }
+    EXPECT(returnedCount == waitersCount);
+    EXPECT(task.IsDone());
+}
+
+void TestException() {
+    Gate gate;
+    BackgroundTask task;
+
+    task.Start("test-error", [&gate] {
+        gate.Pass();
+        throw runtime_error("metadata folder couldn't be opened!");
+    });
+
+    atomic<int> caughtCount(0);
+    thread waiter([&] {
+        try {
+            task.Wait();
+        } catch (const runtime_error& e) {
+            EXPECT(string(e.what()) == "metadata folder couldn't be opened!");
+            caughtCount++;
+        }
+    });
+
+    gate.Open();
+    waiter.join();
+
+    // and again for a later wait
+    try {
+        task.Wait();
+    } catch (const runtime_error&) {
+        caughtCount++;
+    }
+    EXPECT(caughtCount == 2);
+}
+
+void TestNotWaited() {
+    atomic<bool> isRun(false);
+    {
+        BackgroundTask task;
+        task.Start("test-orphan", [&isRun] {
+            this_thread::sleep_for(chrono::milliseconds(5));
+            isRun = true;
+        });
+    }
+    EXPECT(isRun);
+}
+
+void TestRandomOrderings() {
+    static const int iterations = 500;
+
+    mt19937 random(2020);
+    uniform_int_distribution<int> delay(0, 200);
+
+    for (int i = 0; i < iterations; i++) {
+        auto taskDelay = delay(random);
+        auto waitDelay = delay(random);
+        vector<int> tree;
+
+        BackgroundTask task;
+        task.Start("test-random", [&tree, taskDelay] {
+            this_thread::sleep_for(chrono::microseconds(taskDelay));
+            for (int node = 0; node < 64; node++) {
+                tree.push_back(node);
+            }
+        });
+
+        this_thread::sleep_for(chrono::microseconds(waitDelay));
+        task.Wait();
+
+        EXPECT(task.IsDone());
+        EXPECT(tree.size() == 64 && tree.back() == 63);
+    }
+}
+}
+
+int main() {
+    TestNotStarted();
+    TestDoneBeforeWait();
+    TestWaitBeforeRun();
+    TestException();
+    TestNotWaited();
+    TestRandomOrderings();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d expectation(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("All the orderings passed\n");
+    return 0;
+}
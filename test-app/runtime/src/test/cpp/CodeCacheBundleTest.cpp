@@ -0,0 +1,259 @@
+/*
+ * Writes the code caches of a few modules to a bundle and opens it again the way the next launch
+ * of the application does, in a process of its own. A cache is only handed out for the XXH64 of
+ * the source it was created from, and a bundle written with another V8 version tag, i.e. by
+ * another V8 or with other flags, is discarded as a whole.
+ *
+ *   code-cache-bundle-test
+ */
+
+#include "CodeCacheBundle.h"
+#include "XxHash.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+using namespace tns;
+using namespace v8;
+
+// the parts of V8 the bundle uses, the test does not link V8
+ScriptCompiler::CachedData::CachedData(const uint8_t* data, int length, BufferPolicy bufferPolicy)
+    : data(data), length(length), rejected(false), buffer_policy(bufferPolicy) {
+}
+
+ScriptCompiler::CachedData::~CachedData() {
+    if (buffer_policy == BufferOwned) {
+        delete[] data;
+    }
+}
+
+namespace tns {
+bool LogEnabled = false;
+}
+
+namespace {
+int failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+/*
+ * Holds the tasks posted to the worker threads until the test runs them.
+ */
+class TestPlatform : public Platform {
+    public:
+        int NumberOfWorkerThreads() override {
+            return 1;
+        }
+
+        shared_ptr<TaskRunner> GetForegroundTaskRunner(Isolate*) override {
+            return nullptr;
+        }
+
+        void CallOnWorkerThread(unique_ptr<Task> task) override {
+            m_tasks.push_back(move(task));
+        }
+
+        void CallDelayedOnWorkerThread(unique_ptr<Task> task, double) override {
+            m_tasks.push_back(move(task));
+        }
+
+        double MonotonicallyIncreasingTime() override {
+            return 0;
+        }
+
+        double CurrentClockTimeMillis() override {
+            return 0;
+        }
+
+        TracingController* GetTracingController() override {
+            return nullptr;
+        }
+
+        void RunWorkerTasks() {
+            while (!m_tasks.empty()) {
+                auto task = move(m_tasks.front());
+                m_tasks.erase(m_tasks.begin());
+                task->Run();
+            }
+        }
+
+    private:
+        vector<unique_ptr<Task>> m_tasks;
+};
+
+const uint32_t VERSION_TAG = 0x12345678;
+const uint32_t OTHER_VERSION_TAG = 0x12345679;
+
+string bundlePath;
+
+/*
+ * The bundle is a singleton, so each launch of the application runs in a child process.
+ */
+void RunLaunch(const function<void(CodeCacheBundle*, TestPlatform&)>& launch) {
+    fflush(stderr);
+    auto pid = fork();
+    if (pid == 0) {
+        TestPlatform platform;
+        launch(CodeCacheBundle::GetInstance(), platform);
+        fflush(stderr);
+        _exit(failures);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        failures++;
+    }
+}
+
+unique_ptr<ScriptCompiler::CachedData> MakeCache(const string& content) {
+    auto data = new uint8_t[content.size()];
+    memcpy(data, content.data(), content.size());
+    return unique_ptr<ScriptCompiler::CachedData>(new ScriptCompiler::CachedData(data, static_cast<int>(content.size()), ScriptCompiler::CachedData::BufferOwned));
+}
+
+bool HasCache(CodeCacheBundle* bundle, const string& modulePath, const string& source, const string& expectedContent) {
+    CodeCacheBundle::CacheKind kind;
+    unique_ptr<ScriptCompiler::CachedData> cachedData(bundle->Get(modulePath, CodeCacheBundle::Hash(source.data(), source.size()), kind));
+    return cachedData != nullptr && string(reinterpret_cast<const char*>(cachedData->data), cachedData->length) == expectedContent;
+}
+
+void TestHash() {
+    // the reference values of XXH64 with the seed 0
+    EXPECT(CodeCacheBundle::Hash("", 0) == 0xEF46DB3751D8E999ULL);
+    EXPECT(CodeCacheBundle::Hash("a", 1) == 0xD24EC4F1A98C6E5BULL);
+
+    string source(1000, 'x');
+    auto changed = source;
+    changed[500] = 'y';
+    EXPECT(CodeCacheBundle::Hash(source.data(), source.size()) != CodeCacheBundle::Hash(changed.data(), changed.size()));
+}
+
+void TestSourceHash() {
+    RunLaunch([](CodeCacheBundle* bundle, TestPlatform& platform) {
+        bundle->Open(bundlePath, VERSION_TAG, &platform);
+        bundle->Put("/app/main.js", CodeCacheBundle::Hash("main", 4), CodeCacheBundle::CacheKind::Function, MakeCache("main cache"));
+        bundle->Put("/app/streamed.js", CodeCacheBundle::Hash("streamed", 8), CodeCacheBundle::CacheKind::Script, MakeCache("streamed cache"));
+
+        // readable before they are written
+        EXPECT(HasCache(bundle, "/app/main.js", "main", "main cache"));
+        EXPECT(!HasCache(bundle, "/app/main.js", "maim", "main cache"));
+
+        bundle->Flush();
+        platform.RunWorkerTasks();
+
+        EXPECT(HasCache(bundle, "/app/main.js", "main", "main cache"));
+        EXPECT(!HasCache(bundle, "/app/main.js", "maim", "main cache"));
+    });
+
+    RunLaunch([](CodeCacheBundle* bundle, TestPlatform& platform) {
+        bundle->Open(bundlePath, VERSION_TAG, &platform);
+
+        EXPECT(HasCache(bundle, "/app/main.js", "main", "main cache"));
+        EXPECT(bundle->Contains("/app/main.js", CodeCacheBundle::Hash("main", 4)));
+
+        // the module changed, with the same size and modification time after an update of the application
+        EXPECT(!HasCache(bundle, "/app/main.js", "maim", "main cache"));
+        EXPECT(!bundle->Contains("/app/main.js", CodeCacheBundle::Hash("maim", 4)));
+        EXPECT(!HasCache(bundle, "/app/other.js", "main", "main cache"));
+
+        CodeCacheBundle::CacheKind kind = CodeCacheBundle::CacheKind::Function;
+        unique_ptr<ScriptCompiler::CachedData> cachedData(bundle->Get("/app/streamed.js", CodeCacheBundle::Hash("streamed", 8), kind));
+        EXPECT(cachedData != nullptr && kind == CodeCacheBundle::CacheKind::Script);
+
+        // the new cache of the changed module replaces the old one
+        bundle->Put("/app/main.js", CodeCacheBundle::Hash("maim", 4), CodeCacheBundle::CacheKind::Function, MakeCache("changed cache"));
+        bundle->Flush();
+        platform.RunWorkerTasks();
+    });
+
+    RunLaunch([](CodeCacheBundle* bundle, TestPlatform& platform) {
+        bundle->Open(bundlePath, VERSION_TAG, &platform);
+
+        EXPECT(HasCache(bundle, "/app/main.js", "maim", "changed cache"));
+        EXPECT(!HasCache(bundle, "/app/main.js", "main", "main cache"));
+        EXPECT(HasCache(bundle, "/app/streamed.js", "streamed", "streamed cache"));
+    });
+}
+
+void TestVersionTag() {
+    // another V8, or the same V8 with other flags
+    RunLaunch([](CodeCacheBundle* bundle, TestPlatform& platform) {
+        bundle->Open(bundlePath, OTHER_VERSION_TAG, &platform);
+
+        EXPECT(!HasCache(bundle, "/app/streamed.js", "streamed", "streamed cache"));
+        EXPECT(!bundle->Contains("/app/streamed.js", CodeCacheBundle::Hash("streamed", 8)));
+
+        bundle->Put("/app/main.js", CodeCacheBundle::Hash("main", 4), CodeCacheBundle::CacheKind::Function, MakeCache("other cache"));
+        bundle->Flush();
+        platform.RunWorkerTasks();
+    });
+
+    // the caches of the previous tag were dropped with the bundle
+    RunLaunch([](CodeCacheBundle* bundle, TestPlatform& platform) {
+        bundle->Open(bundlePath, VERSION_TAG, &platform);
+
+        EXPECT(!HasCache(bundle, "/app/main.js", "main", "other cache"));
+        EXPECT(!HasCache(bundle, "/app/streamed.js", "streamed", "streamed cache"));
+    });
+}
+
+void TestCorruptedHeader() {
+    RunLaunch([](CodeCacheBundle* bundle, TestPlatform& platform) {
+        bundle->Open(bundlePath, VERSION_TAG, &platform);
+        bundle->Put("/app/main.js", CodeCacheBundle::Hash("main", 4), CodeCacheBundle::CacheKind::Function, MakeCache("main cache"));
+        bundle->Flush();
+        platform.RunWorkerTasks();
+    });
+
+    // a flipped bit of the header fails its checksum
+    auto file = fopen(bundlePath.c_str(), "r+b");
+    fseek(file, 20, SEEK_SET);
+    auto c = fgetc(file);
+    fseek(file, 20, SEEK_SET);
+    fputc(c ^ 1, file);
+    fclose(file);
+
+    RunLaunch([](CodeCacheBundle* bundle, TestPlatform& platform) {
+        bundle->Open(bundlePath, VERSION_TAG, &platform);
+
+        EXPECT(!HasCache(bundle, "/app/main.js", "main", "main cache"));
+    });
+}
+}
+
+int main() {
+    char tempPath[] = "/tmp/code-cache-bundle-XXXXXX";
+    char canonicalPath[PATH_MAX];
+    string root = realpath(mkdtemp(tempPath), canonicalPath);
+    bundlePath = root + "/code-cache.bundle";
+
+    TestHash();
+    TestSourceHash();
+    TestVersionTag();
+    TestCorruptedHeader();
+
+    system(("rm -rf " + root).c_str());
+
+    if (failures > 0) {
+        fprintf(stderr, "%d expectation(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("All the caches were invalidated as expected\n");
+    return 0;
+}
@@ -0,0 +1,79 @@
+/*
+ * Drives the foreground/background state of a runtime through the sequences the activity lifecycle
+ * produces and checks which V8 notifications they call for.
+ *
+ *   lifecycle-state-test
+ */
+
+#include "LifecycleState.h"
+#include <cstdio>
+
+using namespace tns;
+
+namespace {
+int failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+void TestStartsInForeground() {
+    LifecycleState state;
+    EXPECT(!state.IsInBackground());
+
+    // the first activity starting does not notify V8, which starts in the foreground too
+    EXPECT(state.SetInBackground(false) == LifecycleState::Change::None);
+    EXPECT(!state.IsInBackground());
+}
+
+void TestBackgroundAndBack() {
+    LifecycleState state;
+
+    EXPECT(state.SetInBackground(true) == LifecycleState::Change::ToBackground);
+    EXPECT(state.IsInBackground());
+
+    EXPECT(state.SetInBackground(false) == LifecycleState::Change::ToForeground);
+    EXPECT(!state.IsInBackground());
+}
+
+void TestRepeatedNotifications() {
+    LifecycleState state;
+
+    EXPECT(state.SetInBackground(true) == LifecycleState::Change::ToBackground);
+    EXPECT(state.SetInBackground(true) == LifecycleState::Change::None);
+    EXPECT(state.IsInBackground());
+
+    EXPECT(state.SetInBackground(false) == LifecycleState::Change::ToForeground);
+    EXPECT(state.SetInBackground(false) == LifecycleState::Change::None);
+    EXPECT(!state.IsInBackground());
+}
+
+void TestManyCycles() {
+    LifecycleState state;
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT(state.SetInBackground(true) == LifecycleState::Change::ToBackground);
+        EXPECT(state.SetInBackground(false) == LifecycleState::Change::ToForeground);
+    }
+    EXPECT(!state.IsInBackground());
+}
+}
+
+int main() {
+    TestStartsInForeground();
+    TestBackgroundAndBack();
+    TestRepeatedNotifications();
+    TestManyCycles();
+
+    if (failures > 0) {
+        fprintf(stderr, "%d expectation(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("All the transitions passed\n");
+    return 0;
+}
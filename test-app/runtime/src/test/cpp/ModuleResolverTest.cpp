@@ -0,0 +1,206 @@
+/*
+ * Resolves the module names against a fixture application tree the way Module.resolvePath does:
+ * the relative and the absolute paths, the package.json "main" entries, the index.js fallback and
+ * the node_modules lookup, then checks that the modules written after a lookup, e.g. by livesync,
+ * are found and that the resolved paths are cached until the caches are dropped.
+ *
+ *   module-resolver-test
+ */
+
+#include "ModuleResolver.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace tns;
+
+namespace {
+int failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+typedef ModuleResolver::Resolution Resolution;
+
+struct Case {
+    const char* name;
+    // relative to the application files directory, nullptr for the modules which are required from no module
+    const char* baseDir;
+    Resolution resolution;
+    // the resolved path relative to the application files directory, or the error message
+    const char* expected;
+};
+
+void WriteFile(const string& root, const string& path, const string& content) {
+    for (size_t pos = path.find('/'); pos != string::npos; pos = path.find('/', pos + 1)) {
+        mkdir((root + "/" + path.substr(0, pos)).c_str(), 0700);
+    }
+
+    auto file = fopen((root + "/" + path).c_str(), "w");
+    fwrite(content.data(), 1, content.size(), file);
+    fclose(file);
+}
+
+string CreateFixture() {
+    char tempPath[] = "/tmp/module-resolver-XXXXXX";
+    char canonicalPath[PATH_MAX];
+    string root = realpath(mkdtemp(tempPath), canonicalPath);
+
+    WriteFile(root, "app/main.js", "");
+    WriteFile(root, "app/data.json", "{}");
+    WriteFile(root, "app/dir/a.js", "");
+    WriteFile(root, "app/dir/sub/b.js", "");
+    WriteFile(root, "app/dir/node_modules/local.js", "");
+    WriteFile(root, "app/tns_modules/tns-core-modules/core.js", "");
+    WriteFile(root, "app/tns_modules/with-main/package.json", "{ \"name\": \"with-main\", \"main\": \"lib/entry\" }");
+    WriteFile(root, "app/tns_modules/with-main/lib/entry.js", "");
+    WriteFile(root, "app/tns_modules/main-folder/package.json", "{ \"main\": \"lib\", \"version\": [1, { \"x\": null }] }");
+    WriteFile(root, "app/tns_modules/main-folder/lib/index.js", "");
+    WriteFile(root, "app/tns_modules/without-main/package.json", "{ \"name\": \"without-main\" }");
+    WriteFile(root, "app/tns_modules/without-main/index.js", "");
+    WriteFile(root, "app/tns_modules/index-only/index.js", "");
+    WriteFile(root, "app/tns_modules/not-strict/package.json", "{ main: 'index.js' }");
+    WriteFile(root, "app/tns_modules/not-strict/index.js", "");
+
+    return root;
+}
+
+void TestResolution(ModuleResolver& resolver, const string& root) {
+    static const Case cases[] = {
+        // relative
+        { "./a", "app/dir", Resolution::Found, "app/dir/a.js" },
+        { "./sub/b.js", "app/dir", Resolution::Found, "app/dir/sub/b.js" },
+        { "../a", "app/dir/sub", Resolution::Found, "app/dir/a.js" },
+        { "../data.json", "app/dir", Resolution::Found, "app/data.json" },
+        { "./main", nullptr, Resolution::Found, "app/main.js" },
+        { "~/dir/a", "app/dir/sub", Resolution::Found, "app/dir/a.js" },
+        // absolute
+        { "/app/dir//a.js", nullptr, Resolution::Found, "app/dir/a.js" },
+        // the core modules and the node_modules folders
+        { "core", "app/dir", Resolution::Found, "app/tns_modules/tns-core-modules/core.js" },
+        { "local", "app/dir/sub", Resolution::Found, "app/dir/node_modules/local.js" },
+        // package.json "main" and the index.js fallback
+        { "with-main", "app/dir", Resolution::Found, "app/tns_modules/with-main/lib/entry.js" },
+        { "main-folder", "app/dir", Resolution::Found, "app/tns_modules/main-folder/lib/index.js" },
+        { "without-main", "app/dir", Resolution::Found, "app/tns_modules/without-main/index.js" },
+        { "index-only", "app", Resolution::Found, "app/tns_modules/index-only/index.js" },
+        // the messages of Module.resolvePath
+        { "./missing", "app/dir", Resolution::NotFound, "Failed to find module: \"./missing\", relative to: app/dir/" },
+        { "~/missing.js", "app/dir", Resolution::NotFound, "Failed to find module: \"~/missing.js\", relative to: /app/" },
+        { "missing", "app/dir", Resolution::NotFound, "Failed to find module: \"missing\", relative to: app/tns_modules/" },
+        { "with-main/missing", "app/dir", Resolution::NotFound, "Failed to find module: \"with-main/missing\", relative to: app/tns_modules/" },
+        // left to org.json
+        { "not-strict", "app/dir", Resolution::Unsupported, nullptr }
+    };
+
+    for (const auto& c : cases) {
+        string name = c.name;
+        if (name[0] == '/') {
+            name = root + name;
+        }
+        string baseDir = (c.baseDir != nullptr) ? (root + "/" + c.baseDir) : "";
+
+        string path;
+        string errorMessage;
+        auto resolution = resolver.Resolve(name, baseDir, path, errorMessage);
+
+        if (resolution != c.resolution) {
+            fprintf(stderr, "%s from %s: unexpected resolution\n", c.name, (c.baseDir != nullptr) ? c.baseDir : "(none)");
+            failures++;
+        } else if (resolution == Resolution::Found && path != root + "/" + c.expected) {
+            fprintf(stderr, "%s: resolved to %s\n", c.name, path.c_str());
+            failures++;
+        } else if (resolution == Resolution::NotFound && errorMessage != c.expected) {
+            fprintf(stderr, "%s: reported %s\n", c.name, errorMessage.c_str());
+            failures++;
+        }
+    }
+}
+
+void TestCaches(ModuleResolver& resolver, const string& root) {
+    string path;
+    string errorMessage;
+
+    // the resolved paths are cached
+    unlink((root + "/app/dir/a.js").c_str());
+    EXPECT(resolver.Resolve("./a", root + "/app/dir", path, errorMessage) == Resolution::Found);
+    EXPECT(path == root + "/app/dir/a.js");
+
+    // a module written after a failed lookup, e.g. by livesync, is found by the next one
+    errorMessage.clear();
+    EXPECT(resolver.Resolve("./added", root + "/app/dir", path, errorMessage) == Resolution::NotFound);
+    EXPECT(errorMessage == "Failed to find module: \"./added\", relative to: app/dir/");
+    WriteFile(root, "app/dir/added.js", "");
+    EXPECT(resolver.Resolve("./added", root + "/app/dir", path, errorMessage) == Resolution::Found);
+    EXPECT(path == root + "/app/dir/added.js");
+
+    // and so is a hot update in a folder listed before it was written
+    EXPECT(resolver.Resolve("./sub/b", root + "/app/dir", path, errorMessage) == Resolution::Found);
+    WriteFile(root, "app/dir/sub/b.1234.hot-update.js", "");
+    EXPECT(resolver.Resolve("./sub/b.1234.hot-update.js", root + "/app/dir", path, errorMessage) == Resolution::Found);
+
+    // a folder created after a failed lookup
+    EXPECT(resolver.Resolve("./created/c", root + "/app/dir", path, errorMessage) == Resolution::NotFound);
+    WriteFile(root, "app/dir/created/c.js", "");
+    EXPECT(resolver.Resolve("./created/c", root + "/app/dir", path, errorMessage) == Resolution::Found);
+
+    // a listing older than the modification time of its folder is not trusted
+    WriteFile(root, "app/old/d.js", "");
+    struct timespec times[2] = { { 0, UTIME_OMIT }, { 1, 0 } };
+    utimensat(AT_FDCWD, (root + "/app/old").c_str(), times, 0);
+    EXPECT(resolver.Resolve("./d", root + "/app/old", path, errorMessage) == Resolution::Found);
+    EXPECT(resolver.Resolve("./e", root + "/app/old", path, errorMessage) == Resolution::NotFound);
+    WriteFile(root, "app/old/e.js", "");
+    utimensat(AT_FDCWD, (root + "/app/old").c_str(), times, 0);
+    // the folder was listed with the same modification time
+    EXPECT(resolver.Resolve("./e", root + "/app/old", path, errorMessage) == Resolution::NotFound);
+
+    // until the caches are dropped, e.g. after livesync removed a module
+    resolver.Invalidate();
+    EXPECT(resolver.Resolve("./e", root + "/app/old", path, errorMessage) == Resolution::Found);
+    EXPECT(resolver.Resolve("./a", root + "/app/dir", path, errorMessage) == Resolution::NotFound);
+}
+
+void TestParsePackageMain() {
+    bool hasMain;
+    string main;
+
+    EXPECT(ModuleResolver::ParsePackageMain("\xEF\xBB\xBF{\"main\":\"a\\u00e9\\/b\"}", hasMain, main));
+    EXPECT(hasMain && main == "a\xC3\xA9/b");
+    EXPECT(ModuleResolver::ParsePackageMain("{}", hasMain, main) && !hasMain);
+    EXPECT(!ModuleResolver::ParsePackageMain("{\"main\":1}", hasMain, main));
+    EXPECT(!ModuleResolver::ParsePackageMain("{\"main\":\"a\",\"main\":\"b\"}", hasMain, main));
+    EXPECT(!ModuleResolver::ParsePackageMain("{\"main\":\"a\"} x", hasMain, main));
+}
+}
+
+int main() {
+    auto root = CreateFixture();
+
+    ModuleResolver resolver;
+    resolver.Init(root + "/app");
+
+    TestResolution(resolver, root);
+    TestCaches(resolver, root);
+    TestParsePackageMain();
+
+    system(("rm -rf " + root).c_str());
+
+    if (failures > 0) {
+        fprintf(stderr, "%d expectation(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("All the module names resolved\n");
+    return 0;
+}
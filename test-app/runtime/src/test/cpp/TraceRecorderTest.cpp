@@ -0,0 +1,436 @@
+/*
+ * Records events on several threads and checks that the written file is valid JSON in the Chrome
+ * trace-event format: an object with a "traceEvents" array of complete ("X"), instant ("i") and
+ * metadata ("M") events.
+ *
+ *   trace-recorder-test <trace file>
+ */
+
+#include "TraceRecorder.h"
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+using namespace tns;
+
+namespace {
+int failures = 0;
+
+#define EXPECT(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: expected %s\n", __FILE__, __LINE__, #condition); \
+            failures++; \
+        } \
+    } while (0)
+
+struct Value {
+    enum Kind { Null, Bool, Number, String, Array, Object } kind = Null;
+    double number = 0;
+    string text;
+    vector<Value> items;
+    map<string, Value> members;
+
+    const Value* Get(const string& key) const {
+        auto it = members.find(key);
+        return it != members.end() ? &it->second : nullptr;
+    }
+};
+
+/*
+ * A strict parser of the JSON the recorder writes, which fails on anything Chrome would reject.
+ */
+class Parser {
+    public:
+        Parser(const string& json) : m_json(json), m_pos(0) {
+        }
+
+        bool Parse(Value& value) {
+            return ParseValue(value) && (SkipSpaces(), m_pos == m_json.size());
+        }
+
+    private:
+        void SkipSpaces() {
+            while (m_pos < m_json.size() && isspace(static_cast<unsigned char>(m_json[m_pos]))) {
+                m_pos++;
+            }
+        }
+
+        bool Consume(char c) {
+            SkipSpaces();
+            if (m_pos < m_json.size() && m_json[m_pos] == c) {
+                m_pos++;
+                return true;
+            }
+            return false;
+        }
+
+        bool ParseValue(Value& value) {
+            SkipSpaces();
+            if (m_pos >= m_json.size()) {
+                return false;
+            }
+
+            char c = m_json[m_pos];
+            if (c == '{') {
+                return ParseObject(value);
+            } else if (c == '[') {
+                return ParseArray(value);
+            } else if (c == '"') {
+                value.kind = Value::String;
+                return ParseString(value.text);
+            } else if (c == '-' || isdigit(static_cast<unsigned char>(c))) {
+                return ParseNumber(value);
+            }
+
+            static const char* literals[] = { "true", "false", "null" };
+            for (auto literal : literals) {
+                if (m_json.compare(m_pos, strlen(literal), literal) == 0) {
+                    m_pos += strlen(literal);
+                    value.kind = literal[0] == 'n' ? Value::Null : Value::Bool;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        bool ParseObject(Value& value) {
+            value.kind = Value::Object;
+            m_pos++;
+            if (Consume('}')) {
+                return true;
+            }
+
+            do {
+                string key;
+                SkipSpaces();
+                if (!ParseString(key) || !Consume(':') || !ParseValue(value.members[key])) {
+                    return false;
+                }
+            } while (Consume(','));
+
+            return Consume('}');
+        }
+
+        bool ParseArray(Value& value) {
+            value.kind = Value::Array;
+            m_pos++;
+            if (Consume(']')) {
+                return true;
+            }
+
+            do {
+                value.items.emplace_back();
+                if (!ParseValue(value.items.back())) {
+                    return false;
+                }
+            } while (Consume(','));
+
+            return Consume(']');
+        }
+
+        bool ParseString(string& text) {
+            if (m_pos >= m_json.size() || m_json[m_pos] != '"') {
+                return false;
+            }
+
+            for (m_pos++; m_pos < m_json.size(); m_pos++) {
+                auto c = static_cast<unsigned char>(m_json[m_pos]);
+                if (c == '"') {
+                    m_pos++;
+                    return true;
+                } else if (c < 0x20) {
+                    return false;
+                } else if (c != '\\') {
+                    text += static_cast<char>(c);
+                    continue;
+                }
+
+                if (++m_pos >= m_json.size()) {
+                    return false;
+                }
+
+                switch (m_json[m_pos]) {
+                case '"':
+                    text += '"';
+                    break;
+                case '\\':
+                    text += '\\';
+                    break;
+                case '/':
+                    text += '/';
+                    break;
+                case 'n':
+                    text += '\n';
+                    break;
+                case 'r':
+                    text += '\r';
+                    break;
+                case 't':
+                    text += '\t';
+                    break;
+                case 'b':
+                    text += '\b';
+                    break;
+                case 'f':
+                    text += '\f';
+                    break;
+                case 'u': {
+                        if (m_pos + 4 >= m_json.size()) {
+                            return false;
+                        }
+                        auto code = strtol(m_json.substr(m_pos + 1, 4).c_str(), nullptr, 16);
+                        // the recorder escapes the control characters only
+                        if (code >= 0x20) {
+                            return false;
+                        }
+                        text += static_cast<char>(code);
+                        m_pos += 4;
+                        break;
+                    }
+                default:
+                    return false;
+                }
+            }
+
+            return false;
+        }
+
+        bool ParseNumber(Value& value) {
+            const char* start = m_json.c_str() + m_pos;
+            char* end = nullptr;
+            value.kind = Value::Number;
+            value.number = strtod(start, &end);
+            if (end == start) {
+                return false;
+            }
+            m_pos += end - start;
+            return true;
+        }
+
+        const string& m_json;
+        size_t m_pos;
+};
+
+bool ReadTrace(const string& path, Value& trace) {
+    ifstream file(path, ios::in | ios::binary);
+    stringstream content;
+    content << file.rdbuf();
+
+    auto json = content.str();
+    return file && Parser(json).Parse(trace);
+}
+
+/*
+ * Checks the fields of the events and returns the events of each thread, by tid.
+ */
+map<int, vector<const Value*>> CheckTraceFormat(const Value& trace) {
+    map<int, vector<const Value*>> threads;
+
+    EXPECT(trace.kind == Value::Object);
+    auto events = trace.Get("traceEvents");
+    EXPECT(events != nullptr && events->kind == Value::Array);
+    if (events == nullptr) {
+        return threads;
+    }
+
+    for (const auto& event : events->items) {
+        auto name = event.Get("name");
+        auto ph = event.Get("ph");
+        auto pid = event.Get("pid");
+        auto tid = event.Get("tid");
+        EXPECT(name != nullptr && name->kind == Value::String);
+        EXPECT(ph != nullptr && ph->kind == Value::String);
+        EXPECT(pid != nullptr && pid->kind == Value::Number);
+        EXPECT(tid != nullptr && tid->kind == Value::Number);
+        if (ph == nullptr || tid == nullptr) {
+            continue;
+        }
+
+        if (ph->text == "M") {
+            EXPECT(name->text == "thread_name");
+            EXPECT(event.Get("args") != nullptr && event.Get("args")->Get("name") != nullptr);
+            continue;
+        }
+
+        EXPECT(ph->text == "X" || ph->text == "i");
+        EXPECT(event.Get("cat") != nullptr && event.Get("cat")->kind == Value::String);
+        EXPECT(event.Get("ts") != nullptr && event.Get("ts")->kind == Value::Number);
+        if (ph->text == "X") {
+            EXPECT(event.Get("dur") != nullptr && event.Get("dur")->number >= 0);
+        } else {
+            EXPECT(event.Get("s") != nullptr);
+        }
+
+        threads[static_cast<int>(tid->number)].push_back(&event);
+    }
+
+    return threads;
+}
+
+void TestDisabled(const string& path) {
+    TraceRecorder::AddComplete("test", "ignored", 0, 1);
+    {
+        string name("ignored scope");
+        TraceRecorder::Scope scope("test", name);
+    }
+
+    Value trace;
+    EXPECT(TraceRecorder::Write(path));
+    EXPECT(ReadTrace(path, trace));
+    EXPECT(CheckTraceFormat(trace).empty());
+}
+
+void TestThreads(const string& path) {
+    static const int threadsCount = 4;
+    static const int eventsPerThread = 100;
+
+    TraceRecorder::Start(eventsPerThread);
+
+    vector<thread> threads;
+    for (int t = 0; t < threadsCount; t++) {
+        threads.emplace_back([t] {
+            string name("require");
+            for (int i = 0; i < eventsPerThread; i++) {
+                string module = "./module" + to_string(t) + "-" + to_string(i);
+                TraceRecorder::Scope scope("require", name, module);
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    // the escaping of the names
+    string special("\"quoted\" back\\slash\nnew line\ttab\x01");
+    auto start = TraceRecorder::Now();
+    TraceRecorder::AddComplete("test", special, start, start + 1500);
+    TraceRecorder::AddInstant("test", "First frame");
+
+    // shorter than the threshold
+    {
+        string name("fast call");
+        TraceRecorder::Scope scope("jni", name, 1000000);
+    }
+
+    Value trace;
+    EXPECT(TraceRecorder::Write(path));
+    EXPECT(ReadTrace(path, trace));
+
+    auto byThread = CheckTraceFormat(trace);
+    int requireThreads = 0;
+    bool hasSpecial = false;
+    bool hasInstant = false;
+    bool hasFastCall = false;
+
+    for (const auto& pair : byThread) {
+        const auto& events = pair.second;
+        double lastTs = 0;
+        int requires = 0;
+
+        for (auto event : events) {
+            const auto& name = event->Get("name")->text;
+            auto ts = event->Get("ts")->number;
+
+            if (name.compare(0, 8, "require ") == 0) {
+                requires++;
+                // recorded one after the other, from the oldest
+                EXPECT(ts >= lastTs);
+                lastTs = ts;
+            }
+
+            hasSpecial = hasSpecial || name == special;
+            hasFastCall = hasFastCall || name == "fast call";
+            if (name == "First frame") {
+                hasInstant = event->Get("ph")->text == "i";
+            }
+            if (name == special) {
+                EXPECT(event->Get("dur")->number == 1.5);
+            }
+        }
+
+        if (requires > 0) {
+            EXPECT(requires == eventsPerThread);
+            requireThreads++;
+        }
+    }
+
+    EXPECT(requireThreads == threadsCount);
+    EXPECT(hasSpecial);
+    EXPECT(hasInstant);
+    EXPECT(!hasFastCall);
+}
+
+void TestRingBuffer(const string& path) {
+    static const int capacity = 8;
+    static const int recorded = 20;
+
+    TraceRecorder::Start(capacity);
+
+    int tid = 0;
+    thread recorder([] {
+        for (int i = 0; i < recorded; i++) {
+            TraceRecorder::AddComplete("test", "event " + to_string(i), i * 1000, i * 1000 + 10);
+        }
+    });
+    recorder.join();
+
+    Value trace;
+    EXPECT(TraceRecorder::Write(path));
+    EXPECT(ReadTrace(path, trace));
+
+    // the thread with the "event" names keeps the latest ones, from the oldest
+    for (const auto& pair : CheckTraceFormat(trace)) {
+        const auto& events = pair.second;
+        if (events.empty() || events[0]->Get("name")->text.compare(0, 6, "event ") != 0) {
+            continue;
+        }
+
+        tid = pair.first;
+        EXPECT(events.size() == capacity);
+        for (size_t i = 0; i < events.size(); i++) {
+            EXPECT(events[i]->Get("name")->text == "event " + to_string(recorded - capacity + i));
+        }
+    }
+    EXPECT(tid != 0);
+
+    auto otherData = trace.Get("otherData");
+    EXPECT(otherData != nullptr && otherData->Get("droppedEvents") != nullptr);
+    if (otherData != nullptr && otherData->Get("droppedEvents") != nullptr) {
+        EXPECT(atoi(otherData->Get("droppedEvents")->text.c_str()) >= recorded - capacity);
+    }
+
+    TraceRecorder::Stop();
+}
+}
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        fprintf(stderr, "Usage: trace-recorder-test <trace file>\n");
+        return 1;
+    }
+
+    string path = argv[1];
+
+    TestDisabled(path);
+    TestThreads(path);
+    TestRingBuffer(path);
+
+    if (failures > 0) {
+        fprintf(stderr, "%d expectation(s) failed\n", failures);
+        return 1;
+    }
+
+    printf("The trace in %s is valid\n", path.c_str());
+    return 0;
+}
@@ -0,0 +1,17 @@
+/*
+ * The logging of the NDK, for the runtime classes built on the host. The messages go to stderr.
+ */
+
+#ifndef ANDROID_LOG_H_
+#define ANDROID_LOG_H_
+
+#include <cstdio>
+
+enum {
+    ANDROID_LOG_DEBUG = 3,
+    ANDROID_LOG_FATAL = 7
+};
+
+#define __android_log_print(priority, tag, fmt, ...) (fprintf(stderr, "%s: " fmt "\n", tag, ##__VA_ARGS__))
+
+#endif /* ANDROID_LOG_H_ */
@@ -0,0 +1,108 @@
+package com.tns;
+
+import org.junit.Assert;
+import org.junit.Before;
+import org.junit.Test;
+
+import java.lang.ref.WeakReference;
+
+public class InstanceTableTest {
+
+    private static final int BOUND_OBJECTS_COUNT = 100000;
+
+    private InstanceTable instances;
+
+    @Before
+    public void setUp() {
+        instances = new InstanceTable();
+    }
+
+    @Test
+    public void testStrongInstanceIsReturnedOnlyAsStrong() {
+        Object instance = new Object();
+
+        instances.putStrong(42, instance);
+
+        Assert.assertSame(instance, instances.getStrong(42));
+        Assert.assertNull(instances.getWeak(42));
+        Assert.assertEquals(1, instances.size());
+    }
+
+    @Test
+    public void testMakeWeakReplacesTheStrongReference() {
+        Object instance = new Object();
+        instances.putStrong(42, instance);
+
+        instances.makeWeak(42);
+
+        Assert.assertNull(instances.getStrong(42));
+        WeakReference<Object> weakRef = instances.getWeak(42);
+        Assert.assertNotNull(weakRef);
+        Assert.assertSame(instance, weakRef.get());
+    }
+
+    @Test
+    public void testBoundWeakReferenceIsNotMistakenForAWeakSlot() {
+        WeakReference<Object> instance = new WeakReference<Object>(new Object());
+
+        instances.putStrong(7, instance);
+
+        Assert.assertSame(instance, instances.getStrong(7));
+        Assert.assertNull(instances.getWeak(7));
+    }
+
+    @Test
+    public void testRemoveClearsTheSlot() {
+        instances.putStrong(5, new Object());
+        instances.makeWeak(5);
+
+        instances.remove(5);
+
+        Assert.assertNull(instances.getStrong(5));
+        Assert.assertNull(instances.getWeak(5));
+        Assert.assertEquals(0, instances.size());
+    }
+
+    @Test
+    public void testUnknownIdsAreNotFound() {
+        instances.putStrong(1, new Object());
+
+        Assert.assertNull(instances.getStrong(2));
+        Assert.assertNull(instances.getWeak(1 << 24));
+
+        instances.remove(1 << 24);
+        Assert.assertEquals(1, instances.size());
+    }
+
+    @Test
+    public void testManyBoundObjects() {
+        Object[] objects = new Object[BOUND_OBJECTS_COUNT];
+        for (int i = 0; i < BOUND_OBJECTS_COUNT; i++) {
+            objects[i] = new Object();
+            instances.putStrong(i, objects[i]);
+        }
+        Assert.assertEquals(BOUND_OBJECTS_COUNT, instances.size());
+
+        for (int i = 0; i < BOUND_OBJECTS_COUNT; i += 2) {
+            instances.makeWeak(i);
+        }
+        for (int i = 1; i < BOUND_OBJECTS_COUNT; i += 2) {
+            instances.remove(i);
+        }
+
+        Assert.assertEquals(BOUND_OBJECTS_COUNT / 2, instances.size());
+        for (int i = 0; i < BOUND_OBJECTS_COUNT; i++) {
+            if (i % 2 == 0) {
+                Assert.assertSame(objects[i], instances.getWeak(i).get());
+            } else {
+                Assert.assertNull(instances.getStrong(i));
+                Assert.assertNull(instances.getWeak(i));
+            }
+        }
+
+        for (int i = 0; i < BOUND_OBJECTS_COUNT; i += 2) {
+            instances.remove(i);
+        }
+        Assert.assertEquals(0, instances.size());
+    }
+}
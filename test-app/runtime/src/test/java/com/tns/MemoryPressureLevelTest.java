@@ -0,0 +1,28 @@
+package com.tns;
+
+import android.content.ComponentCallbacks2;
+
+import org.junit.Assert;
+import org.junit.Test;
+
+public class MemoryPressureLevelTest {
+
+    @Test
+    public void testRunningLevels() {
+        Assert.assertEquals(MemoryPressureLevel.moderate, MemoryPressureLevel.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE));
+        Assert.assertEquals(MemoryPressureLevel.moderate, MemoryPressureLevel.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW));
+        Assert.assertEquals(MemoryPressureLevel.critical, MemoryPressureLevel.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL));
+    }
+
+    @Test
+    public void testHiddenUiIsNoPressure() {
+        Assert.assertEquals(MemoryPressureLevel.none, MemoryPressureLevel.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_UI_HIDDEN));
+    }
+
+    @Test
+    public void testBackgroundLevels() {
+        Assert.assertEquals(MemoryPressureLevel.moderate, MemoryPressureLevel.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_BACKGROUND));
+        Assert.assertEquals(MemoryPressureLevel.moderate, MemoryPressureLevel.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_MODERATE));
+        Assert.assertEquals(MemoryPressureLevel.critical, MemoryPressureLevel.fromTrimLevel(ComponentCallbacks2.TRIM_MEMORY_COMPLETE));
+    }
+}
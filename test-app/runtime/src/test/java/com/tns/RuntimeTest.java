@@ -9,12 +9,12 @@ import org.mockito.MockitoAnnotations;
 import org.mockito.Spy;
 
 import java.lang.ref.WeakReference;
-import java.util.HashMap;
 import java.util.Map;
 
 import static org.mockito.Mockito.doReturn;
 import static org.mockito.Mockito.mock;
 import static org.mockito.Mockito.mockingDetails;
+import static org.mockito.Mockito.times;
 import static org.mockito.Mockito.verify;
 import static org.mockito.Mockito.when;
 
@@ -26,10 +26,7 @@ public class RuntimeTest {
     private Runtime runtime;
 
     @Mock
-    private HashMap<Integer, Object> strongInstances;
-
-    @Mock
-    private HashMap<Integer, WeakReference<Object>> weakInstances;
+    private InstanceTable instances;
 
     @Mock
     private NativeScriptHashMap<Object, Integer> strongJavaObjectToId;
@@ -49,42 +46,77 @@ public class RuntimeTest {
                 mock(DynamicConfiguration.class),
                 0,
                 0,
-                strongInstances,
-                weakInstances,
+                instances,
                 strongJavaObjectToId,
                 weakJavaObjectToId);
     }
 
     @Test
     public void testStrongInstanceIsSuccessfullyRemoved() {
-        when(strongInstances.get(TESTING_NATIVE_OBJECT_ID)).thenReturn(TESTING_NATIVE_OBJECT);
+        when(instances.getStrong(TESTING_NATIVE_OBJECT_ID)).thenReturn(TESTING_NATIVE_OBJECT);
 
         runtime.releaseNativeCounterpart(TESTING_NATIVE_OBJECT_ID);
 
-        verify(strongInstances).remove(TESTING_NATIVE_OBJECT_ID);
+        verify(instances).remove(TESTING_NATIVE_OBJECT_ID);
         verify(strongJavaObjectToId).remove(TESTING_NATIVE_OBJECT);
     }
 
     @Test
     public void testWeakInstanceIsSuccessfullyRemoved(){
-        when(weakInstances.get(TESTING_NATIVE_OBJECT_ID)).thenReturn(testingObjectWeakRefMock);
+        when(instances.getWeak(TESTING_NATIVE_OBJECT_ID)).thenReturn(testingObjectWeakRefMock);
+        when(testingObjectWeakRefMock.get()).thenReturn(TESTING_NATIVE_OBJECT);
 
         runtime.releaseNativeCounterpart(TESTING_NATIVE_OBJECT_ID);
 
-        verify(weakInstances).remove(TESTING_NATIVE_OBJECT_ID);
-        verify(weakJavaObjectToId).remove(testingObjectWeakRefMock);
+        verify(instances).remove(TESTING_NATIVE_OBJECT_ID);
+        verify(weakJavaObjectToId).remove(TESTING_NATIVE_OBJECT);
     }
 
     @Test
     public void testStrongAndWeakInstancesAreSuccessfullyRemoved(){
-        when(strongInstances.get(TESTING_NATIVE_OBJECT_ID)).thenReturn(TESTING_NATIVE_OBJECT);
-        when(weakInstances.get(TESTING_NATIVE_OBJECT_ID)).thenReturn(testingObjectWeakRefMock);
+        when(instances.getStrong(TESTING_NATIVE_OBJECT_ID)).thenReturn(TESTING_NATIVE_OBJECT);
+        when(instances.getWeak(TESTING_NATIVE_OBJECT_ID)).thenReturn(testingObjectWeakRefMock);
+        when(testingObjectWeakRefMock.get()).thenReturn(TESTING_NATIVE_OBJECT);
 
         runtime.releaseNativeCounterpart(TESTING_NATIVE_OBJECT_ID);
 
-        verify(strongInstances).remove(TESTING_NATIVE_OBJECT_ID);
+        verify(instances, times(2)).remove(TESTING_NATIVE_OBJECT_ID);
         verify(strongJavaObjectToId).remove(TESTING_NATIVE_OBJECT);
-        verify(weakInstances).remove(TESTING_NATIVE_OBJECT_ID);
-        verify(weakJavaObjectToId).remove(testingObjectWeakRefMock);
+        verify(weakJavaObjectToId).remove(TESTING_NATIVE_OBJECT);
+    }
+
+    @Test
+    public void testReleasedWeakInstanceIsNotFoundOnceItsIdIsReused() {
+        InstanceTable instanceTable = new InstanceTable();
+        NativeScriptHashMap<Object, Integer> strongMap = new NativeScriptHashMap<Object, Integer>();
+        NativeScriptWeakHashMap<Object, Integer> weakMap = new NativeScriptWeakHashMap<Object, Integer>();
+        Runtime runtimeWithTables = new Runtime(mock(ClassResolver.class),
+                mock(GcListener.class),
+                mock(StaticConfiguration.class),
+                mock(DynamicConfiguration.class),
+                0,
+                0,
+                instanceTable,
+                strongMap,
+                weakMap);
+
+        Object oldInstance = new Object();
+        int id = instanceTable.allocateId();
+        instanceTable.putStrong(id, oldInstance);
+        instanceTable.makeWeak(id);
+        weakMap.put(oldInstance, id);
+
+        runtimeWithTables.releaseNativeCounterpart(id);
+
+        Assert.assertNull(weakMap.get(oldInstance));
+
+        Object newInstance = new Object();
+        Assert.assertEquals(id, instanceTable.allocateId());
+        instanceTable.putStrong(id, newInstance);
+        strongMap.put(newInstance, id);
+
+        Assert.assertNull(weakMap.get(oldInstance));
+        Assert.assertNull(strongMap.get(oldInstance));
+        Assert.assertSame(newInstance, instanceTable.getStrong(id));
     }
 }